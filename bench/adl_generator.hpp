@@ -0,0 +1,108 @@
+#ifndef ADL_GENERATOR_H
+#define ADL_GENERATOR_H
+
+#include <cstddef>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Seeded generator of synthetic ADL for the benchmarks: define, object and region blocks with comments and numeric literals
+class AdlGenerator {
+    private:
+        std::mt19937 rng;
+        int block_count;
+
+        const std::vector<std::string> particles = {"Jet", "FatJet", "Electron", "Muon", "Tau", "Photon"};
+        const std::vector<std::string> attributes = {"pt", "eta", "phi", "m", "abs(eta", "q"};
+        const std::vector<std::string> comparisons = {">", "<", ">=", "<=", "==", "!="};
+
+        int pick(int n) {
+            return static_cast<int>(rng() % n);
+        }
+
+        std::string number() {
+            switch (pick(4)) {
+                case 0: return std::to_string(pick(500));
+                case 1: return std::to_string(pick(100)) + "." + std::to_string(pick(1000));
+                case 2: return std::to_string(1 + pick(9)) + "." + std::to_string(pick(10)) + "e" + std::to_string(pick(4));
+                default: return "-" + std::to_string(pick(50));
+            }
+        }
+
+        std::string attribute_of(const std::string &name) {
+            std::string attribute = attributes[pick(attributes.size())];
+            if (attribute.back() == 'a' && attribute.front() == 'a') return attribute + "(" + name + "))";
+            return attribute + "(" + name + ")";
+        }
+
+        std::string comment() {
+            const std::vector<std::string> notes = {"tighten this after the next calibration", "see the object definitions above", "TODO: check against the reference", "loose working point", "from the 2018 recommendations"};
+            return "# " + notes[pick(notes.size())];
+        }
+
+        std::string criterion(const std::string &name) {
+            std::stringstream text;
+            text << attribute_of(name) << " " << comparisons[pick(comparisons.size())] << " " << number();
+            if (pick(3) == 0) text << " and " << attribute_of(name) << " " << comparisons[pick(comparisons.size())] << " " << number();
+            return text.str();
+        }
+
+    public:
+        AdlGenerator(unsigned seed): rng(seed), block_count(0) {}
+
+        // Write whole blocks until at least target_size bytes are out, giving the number actually written
+        std::size_t write_file(const std::string &filename, std::size_t target_size) {
+            std::ofstream out(filename);
+            std::size_t written = 0;
+            while (written < target_size) {
+                std::string block = next_block();
+                out << block;
+                written += block.size();
+            }
+            return written;
+        }
+
+        std::string next_block() {
+            std::stringstream text;
+            std::string name = "b" + std::to_string(block_count++);
+
+            if (pick(6) == 0) text << comment() << "\n";
+
+            switch (pick(3)) {
+                case 0:
+                    text << "define " << name << " = " << number() << " * " << number() << " + " << number();
+                    if (pick(2)) text << "  " << comment();
+                    text << "\n";
+                    break;
+                case 1: {
+                    std::string particle = particles[pick(particles.size())];
+                    text << "object " << name << "\n";
+                    text << "    take " << particle << "\n";
+                    for (int i = pick(5); i >= 0; i--) {
+                        text << "    " << (pick(5) == 0 ? "reject " : "select ") << criterion(particle);
+                        if (pick(4) == 0) text << "  " << comment();
+                        text << "\n";
+                    }
+                    break;
+                }
+                default: {
+                    std::string particle = particles[pick(particles.size())];
+                    text << "region " << name << "\n";
+                    text << "    select ALL\n";
+                    for (int i = pick(6); i >= 0; i--) {
+                        text << "    select size(" << particle << ") >= " << pick(4) << "\n";
+                        text << "    select " << criterion(particle + "[" + std::to_string(pick(3)) + "]") << "\n";
+                    }
+                    text << "    histo h" << name << ", \"" << particle << " pT\", 50, 0, " << number() << ", pt(" << particle << "[0])\n";
+                    break;
+                }
+            }
+            text << "\n";
+
+            return text.str();
+        }
+};
+
+#endif
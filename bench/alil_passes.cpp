@@ -0,0 +1,252 @@
+#include "adl_generator.hpp"
+#include "ali_converter.hpp"
+#include "alil_file.hpp"
+#include "config.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "timber_converter.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Benchmark and check of the ALIL files and passes over a synthetic ADL file. The lowered commands are written out
+as text and as binary, and must read back as the same commands. TIMBER is then generated from the commands as they
+are, with dead commands eliminated, and with common subexpressions eliminated as well. Neither pass may change the
+output of a file whose every block is used by a closing region. Without that region, eliminating dead commands may
+only take lines out, although a line that a dead block needed first, such as the provenance of a particle, moves
+down to the first live block that needs it. Finally constant folding is checked on small cases that are easy to get
+wrong.
+
+    make bench_alil_passes && ./bench_alil_passes [megabytes] [seed]
+*/
+
+std::unique_ptr<Parser> parse_file(const std::string &filename) {
+    auto lexer = std::make_unique<Lexer>();
+    lexer->read_lines(filename);
+    auto parser = std::make_unique<Parser>(lexer.release());
+    parser->parse();
+    return parser;
+}
+
+std::vector<AnalysisCommand> lower_file(const std::string &filename, Config &config) {
+    auto parser = parse_file(filename);
+    ALILConverter alil(config);
+    alil.visitation(parser->get_root());
+    return alil.get_commands();
+}
+
+// Whether two command lists are the same, leaving out where the commands came from if the text format lost it
+bool same_commands(const std::vector<AnalysisCommand> &a, const std::vector<AnalysisCommand> &b, bool with_locations) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (a[i].get_instruction() != b[i].get_instruction() || a[i].has_dest_argument() != b[i].has_dest_argument()) return false;
+        if (with_locations && a[i].get_source_location() != b[i].get_source_location()) return false;
+        if (a[i].get_num_arguments() != b[i].get_num_arguments()) return false;
+        for (int pos = 0; pos < a[i].get_num_arguments(); pos++) {
+            if (a[i].get_argument_symbol(pos) != b[i].get_argument_symbol(pos)) return false;
+        }
+    }
+    return true;
+}
+
+// The passes named, run in the order main runs them, and then the TIMBER backend, whose output is given back
+std::string timber_of(const std::vector<AnalysisCommand> &commands, Config &config, bool fold, bool dead, bool cse, double *pass_seconds = nullptr) {
+    auto alil = std::make_unique<ALILConverter>(config);
+    alil->load_commands(commands);
+
+    auto start = std::chrono::steady_clock::now();
+    if (fold) alil->fold_constants();
+    if (dead) alil->eliminate_dead_commands();
+    if (cse) alil->eliminate_common_subexpressions();
+    auto end = std::chrono::steady_clock::now();
+    if (pass_seconds) *pass_seconds = std::chrono::duration<double>(end - start).count();
+
+    std::stringstream out;
+    std::streambuf *stdout_buffer = std::cout.rdbuf(out.rdbuf());
+    TimberConverter(alil.release(), config).print();
+    std::cout.rdbuf(stdout_buffer);
+    return out.str();
+}
+
+// Whether every line of `part` is also in `whole`, at least as many times
+bool lines_kept(const std::string &part, const std::string &whole) {
+    std::unordered_map<std::string, long> counts;
+    std::stringstream whole_lines(whole);
+    for (std::string line; std::getline(whole_lines, line); ) counts[line]++;
+
+    std::stringstream part_lines(part);
+    for (std::string line; std::getline(part_lines, line); ) {
+        if (--counts[line] < 0) return false;
+    }
+    return true;
+}
+
+// The command that defines a name, or null
+const AnalysisCommand *definition_of(const std::vector<AnalysisCommand> &commands, const std::string &name) {
+    for (auto &command : commands) {
+        if (command.has_dest_argument() && command.get_dest_argument() == name) return &command;
+    }
+    return nullptr;
+}
+
+// The command a name comes down to once every alias of another name is followed, or null for a literal
+const AnalysisCommand *value_of(const std::vector<AnalysisCommand> &commands, const std::string &name, std::string &literal) {
+    literal = name;
+    const AnalysisCommand *command = definition_of(commands, name);
+    while (command && command->get_instruction() == ADD_ALIAS) {
+        literal = command->get_source_argument(0);
+        command = definition_of(commands, literal);
+    }
+    return command;
+}
+
+bool check_folding(Config &config) {
+    std::ofstream("bench_alil_passes.fold.adl") <<
+        "define power_then_divide = 2^3 / 3\n"
+        "define variable_power = size(Jet)^1 / 2\n"
+        "define inexact_division = 7 / 2\n"
+        "define exact_division = 8 / 2\n"
+        "define not_not_variable = not not size(Jet)\n"
+        "define not_not_number = not not 3\n"
+        "region folded\n"
+        "    select variable_power > 1\n"
+        "    select inexact_division > 1\n";
+
+    auto alil = std::make_unique<ALILConverter>(config);
+    alil->load_commands(lower_file("bench_alil_passes.fold.adl", config));
+    alil->fold_constants();
+    const std::vector<AnalysisCommand> &commands = alil->get_commands();
+
+    bool ok = true;
+    auto expect = [&](bool holds, const std::string &what) {
+        if (!holds) std::cerr << "Constant folding went wrong: " << what << std::endl;
+        ok = ok && holds;
+    };
+
+    std::string literal;
+    const AnalysisCommand *value;
+
+    value = value_of(commands, "power_then_divide", literal);
+    expect(!value && literal == "2.6666666666666665", "2^3 / 3 should be 2.6666666666666665, the power being floating point");
+
+    value = value_of(commands, "variable_power", literal);
+    const AnalysisCommand *power = value && value->get_instruction() == EXPR_DIVIDE ? definition_of(commands, value->get_source_argument(0)) : nullptr;
+    expect(power && power->get_instruction() == EXPR_RAISE, "x^1 should be kept, as it makes an integer x floating point");
+
+    value = value_of(commands, "inexact_division", literal);
+    expect(value && value->get_instruction() == EXPR_DIVIDE, "7 / 2 should be left for the backend, which may divide integers either way");
+
+    value = value_of(commands, "exact_division", literal);
+    expect(!value && literal == "4", "8 / 2 should be 4");
+
+    value = value_of(commands, "not_not_variable", literal);
+    expect(value && value->get_instruction() == EXPR_LOGICAL_NOT, "not not of a number should be kept, as it is 0 or 1");
+
+    value = value_of(commands, "not_not_number", literal);
+    expect(!value && literal == "1", "not not 3 should be 1");
+
+    std::string timber = timber_of(commands, config, false, true, false);
+    expect(timber.find("raise_power(size(Jet_pt),1)") != std::string::npos, "the TIMBER for x^1 should keep raise_power");
+
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 1;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+
+    // The backends only read the settings that do not change between runs, so the defaults will do
+    Config config("bench_alil_passes.config");
+
+    AdlGenerator generator(seed);
+    std::ofstream generated("bench_alil_passes.adl");
+    std::stringstream closing_region;
+    closing_region << "region every_block\n    select ALL\n";
+    std::size_t written = 0;
+    while (written < megabytes * 1024 * 1024) {
+        std::string block = generator.next_block();
+        generated << block;
+        written += block.size();
+
+        std::stringstream lines(block);
+        for (std::string line; std::getline(lines, line); ) {
+            std::stringstream words(line);
+            std::string keyword, name;
+            words >> keyword >> name;
+            if (keyword == "define") closing_region << "    select " << name << " != 0\n";
+            if (keyword == "object") closing_region << "    select size(" << name << ") >= 0\n";
+        }
+    }
+    generated.close();
+    std::ofstream("bench_alil_passes.live.adl") << std::ifstream("bench_alil_passes.adl").rdbuf() << closing_region.str();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<AnalysisCommand> commands = lower_file("bench_alil_passes.adl", config);
+    auto end = std::chrono::steady_clock::now();
+    double lower_seconds = std::chrono::duration<double>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::stringstream text;
+    ALILWriter(text).write_text(commands);
+    std::string text_data = text.str();
+    std::vector<AnalysisCommand> from_text = ALILReader(text_data).read();
+    end = std::chrono::steady_clock::now();
+    double text_seconds = std::chrono::duration<double>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::stringstream binary;
+    ALILWriter(binary).write_binary(commands);
+    std::string binary_data = binary.str();
+    std::vector<AnalysisCommand> from_binary = ALILReader(binary_data).read();
+    end = std::chrono::steady_clock::now();
+    double binary_seconds = std::chrono::duration<double>(end - start).count();
+
+    if (!same_commands(commands, from_text, false) || !same_commands(commands, from_binary, true)) {
+        std::cerr << "The ALIL read back differs from the ALIL written" << std::endl;
+        return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    std::string kept_dead = timber_of(commands, config, false, false, false);
+    end = std::chrono::steady_clock::now();
+    double timber_seconds = std::chrono::duration<double>(end - start).count();
+
+    double dead_seconds, both_seconds;
+    std::string without_dead = timber_of(commands, config, false, true, false, &dead_seconds);
+    std::string with_cse = timber_of(commands, config, false, true, true, &both_seconds);
+
+    if (with_cse != without_dead) {
+        std::cerr << "Common subexpression elimination changed the TIMBER output" << std::endl;
+        return 1;
+    }
+    if (!lines_kept(without_dead, kept_dead)) {
+        std::cerr << "Dead command elimination did more to the TIMBER output than take lines out" << std::endl;
+        return 1;
+    }
+
+    std::vector<AnalysisCommand> live = lower_file("bench_alil_passes.live.adl", config);
+    if (timber_of(live, config, false, true, false) != timber_of(live, config, false, false, false)) {
+        std::cerr << "Dead command elimination changed the TIMBER output when every block is used" << std::endl;
+        return 1;
+    }
+
+    if (!check_folding(config)) return 1;
+
+    std::cout << written << " bytes of ADL, " << commands.size() << " ALIL commands" << std::endl;
+    std::cout << "lowering:                 " << lower_seconds * 1e3 << " ms" << std::endl;
+    std::cout << "text write and read:      " << text_seconds * 1e3 << " ms, " << text_data.size() << " bytes" << std::endl;
+    std::cout << "binary write and read:    " << binary_seconds * 1e3 << " ms, " << binary_data.size() << " bytes" << std::endl;
+    std::cout << "TIMBER:                   " << timber_seconds * 1e3 << " ms" << std::endl;
+    std::cout << "dead command elimination: " << dead_seconds * 1e3 << " ms, TIMBER of " << kept_dead.size() << " bytes down to " << without_dead.size() << std::endl;
+    std::cout << "dead commands, then CSE:  " << both_seconds * 1e3 << " ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "adl_generator.hpp"
+#include "flat_ast.hpp"
+#include "lexer.hpp"
+#include "node.hpp"
+#include "parser.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+/*
+Benchmark of a full-tree pass over the pointer-based Node tree against the same pass over its FlatAST. A synthetic
+ADL file is parsed once, flattened, and then each pass sums the symbols of every token-carrying node, first walking
+Node children recursively as ASTVisitor does, then following the flat child and sibling links in the same way, then
+as one sweep over the flat arrays.
+The flat copy is first checked to hold the same nodes in the same order.
+
+    make bench_ast && ./bench_ast [megabytes] [seed] [repeats]
+*/
+
+struct Checksum {
+    std::size_t nodes = 0;
+    std::size_t symbols = 0;
+
+    bool operator==(const Checksum &other) const {
+        return nodes == other.nodes && symbols == other.symbols;
+    }
+};
+
+void walk_nodes(PNode node, Checksum &sum) {
+    sum.nodes++;
+    if (node->has_token()) sum.symbols += node->get_symbol();
+    for (auto it = node->get_children().begin(); it != node->get_children().end(); ++it) {
+        walk_nodes(*it, sum);
+    }
+}
+
+void walk_flat(const FlatAST &ast, Flat_index node, Checksum &sum) {
+    sum.nodes++;
+    if (ast.has_token(node)) sum.symbols += ast.get_symbol(node);
+    for (Flat_index child = ast.get_first_child(node); child != NO_FLAT_NODE; child = ast.get_next_sibling(child)) {
+        walk_flat(ast, child, sum);
+    }
+}
+
+Checksum sweep_flat(const FlatAST &ast) {
+    Checksum sum;
+    for (Flat_index i = 0; i < ast.size(); i++) {
+        sum.nodes++;
+        if (ast.has_token(i)) sum.symbols += ast.get_symbol(i);
+    }
+    return sum;
+}
+
+// Every node must appear in pre-order with the same type and token
+bool same_order(PNode node, const FlatAST &ast, Flat_index &position) {
+    Flat_index index = position++;
+    if (ast.get_ast_type(index) != node->get_ast_type()) return false;
+    if (ast.has_token(index) != node->has_token()) return false;
+    if (node->has_token() && ast.get_token_index(index) != node->get_token().get_index()) return false;
+    if (ast.get_num_children(index) != node->get_children().size()) return false;
+
+    for (auto it = node->get_children().begin(); it != node->get_children().end(); ++it) {
+        if (ast.get_parent(position) != index) return false;
+        if (!same_order(*it, ast, position)) return false;
+    }
+    return true;
+}
+
+template <typename Pass>
+double best_time(int repeats, Pass pass) {
+    double best = 0;
+    for (int r = 0; r < repeats; r++) {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (r == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 1;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+    int repeats = argc > 3 ? std::atoi(argv[3]) : 10;
+
+    std::string filename = "bench_ast.adl";
+    AdlGenerator(seed).write_file(filename, static_cast<std::size_t>(megabytes * 1e6));
+
+    auto lexer = std::make_unique<Lexer>();
+    lexer->read_lines(filename);
+    Parser parser(lexer.release());
+    parser.parse();
+
+    FlatAST ast = parser.get_flat_ast();
+
+    Flat_index position = 0;
+    if (!same_order(parser.get_root(), ast, position) || position != ast.size()) {
+        std::cerr << "The flat AST does not match the node tree" << std::endl;
+        return 1;
+    }
+
+    Checksum node_sum, flat_sum, sweep_sum;
+    double node_seconds = best_time(repeats, [&]() { node_sum = Checksum(); walk_nodes(parser.get_root(), node_sum); });
+    double flat_seconds = best_time(repeats, [&]() { flat_sum = Checksum(); walk_flat(ast, ast.get_root(), flat_sum); });
+    double sweep_seconds = best_time(repeats, [&]() { sweep_sum = sweep_flat(ast); });
+
+    if (!(node_sum == flat_sum) || !(node_sum == sweep_sum)) {
+        std::cerr << "The passes disagree" << std::endl;
+        return 1;
+    }
+
+    double nodes = ast.size();
+    std::size_t flat_bytes = sizeof(std::uint8_t) + sizeof(Token_index) + 3 * sizeof(Flat_index);
+    std::cout << ast.size() << " nodes from " << megabytes << " MB of ADL, seed " << seed << std::endl;
+    std::cout << "bytes per node:   " << sizeof(Node) << " as Node, " << flat_bytes << " flat" << std::endl;
+    std::cout << "node tree walk:   " << node_seconds / nodes * 1e9 << " ns/node" << std::endl;
+    std::cout << "flat tree walk:   " << flat_seconds / nodes * 1e9 << " ns/node" << std::endl;
+    std::cout << "flat sweep:       " << sweep_seconds / nodes * 1e9 << " ns/node" << std::endl;
+
+    return 0;
+}
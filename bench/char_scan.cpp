@@ -0,0 +1,245 @@
+#include "char_scan.hpp"
+#include "lexer.hpp"
+#include "source_buffer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Check and benchmark of the lexer's run skipping in char_scan.cpp. Random ADL-like text is split into tokens by the
+character-at-a-time loop read_lines used before, which is kept below verbatim apart from recording spans, and by the
+Lexer at every vector width the CPU supports. All of them must give identical tokens before any timing is done.
+
+    make bench_char_scan && ./bench_char_scan [lines] [seed]
+*/
+
+struct Span {
+    int line;
+    int column;
+    std::string lexeme;
+
+    bool operator==(const Span &other) const {
+        return line == other.line && column == other.column && lexeme == other.lexeme;
+    }
+};
+
+bool legacy_is_symbol(char c) {
+    if (c == '=' || c == '!' || c == '!' || c == '~' || c == '<' || c == '>' || c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}' || c == ':' || c == '&' || c == '|' || c == '+' || c == '-' || c == '*' || c == '/' || c == '?' || c == '^' || c == ',' || c == '.') return true;
+    return false;
+}
+
+bool legacy_is_delimiter(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+void legacy_lex_token(std::vector<Span> &spans, std::string &token, int line, int &column) {
+    if (token.size() == 0) return;
+    spans.push_back({line, column, token});
+    column += token.length();
+    token.clear();
+}
+
+std::vector<Span> legacy_split(const std::string &text) {
+    std::vector<Span> spans;
+    std::istringstream read_file(text);
+    std::string content;
+
+    int line = 0;
+    while (std::getline(read_file, content)) {
+        line++;
+
+        std::string running_token;
+
+        bool is_commented_out = false;
+        bool is_quoted_out = false;
+
+        int column = 1;
+        for (auto it = content.begin(); it != content.end(); ++it) {
+            char current_char = *it;
+
+            if (current_char == '#' && !is_commented_out) {
+                legacy_lex_token(spans, running_token, line, column);
+                is_commented_out = true;
+                running_token += current_char;
+                continue;
+
+            } else if (is_commented_out) {
+                running_token += current_char;
+                continue;
+            }
+
+            if (is_quoted_out && current_char == '"') {
+                running_token += current_char;
+                legacy_lex_token(spans, running_token, line, column);
+                is_quoted_out = false;
+                continue;
+            } else if (current_char == '"') {
+                legacy_lex_token(spans, running_token, line, column);
+                is_quoted_out = true;
+                running_token += current_char;
+                continue;
+            } else if(is_quoted_out) {
+                running_token += current_char;
+                continue;
+            }
+
+            bool delimiter = legacy_is_delimiter(current_char);
+            bool symbol = legacy_is_symbol(current_char);
+
+            if (current_char == '(' || current_char == ')' || current_char == ','|| current_char == '{' || current_char == '}' || current_char == '[' || current_char == ']') {
+                legacy_lex_token(spans, running_token, line, column);
+                running_token += current_char;
+                legacy_lex_token(spans, running_token, line, column);
+                continue;
+            }
+
+            if (running_token.size() <= 0) {
+                running_token += current_char;
+                continue;
+            }
+
+            char prev_char = running_token.back();
+
+            bool previous_delimiter = legacy_is_delimiter(prev_char);
+            bool previous_symbol = legacy_is_symbol(prev_char);
+
+            char next_char = std::next(it) != content.end() ? *std::next(it) : ' ';
+
+            if (delimiter != previous_delimiter || symbol != previous_symbol) {
+
+                bool was_negative_sign_for_number = prev_char == '-' && current_char >= '0' && current_char <= '9';
+                bool was_decimal_point_for_number = prev_char == '.' && current_char >= '0' && current_char <= '9';
+                bool is_decimal_point_in_number = current_char == '.' && next_char <= '9' && next_char >= '0';
+
+                if (!was_negative_sign_for_number && !was_decimal_point_for_number && !is_decimal_point_in_number) {
+                    legacy_lex_token(spans, running_token, line, column);
+                }
+            } 
+            running_token = running_token + current_char;
+        }
+        legacy_lex_token(spans, running_token, line, column);
+        spans.push_back({line, column, "\n"});
+    }
+
+    return spans;
+}
+
+std::vector<Span> lexer_split(std::shared_ptr<Lexer> lexer, const std::string &text) {
+    std::istringstream in(text);
+    lexer->read_source(std::make_shared<const SourceBuffer>(in));
+
+    std::vector<Span> spans;
+    auto tokens = lexer->get_tokens();
+    for (Token_index i = 0; i < tokens->size(); i++) {
+        PToken tok = tokens->get(i);
+        spans.push_back({tok->get_line(), tok->get_column(), tok->get_lexeme()});
+    }
+    return spans;
+}
+
+// Lines of valid ADL tokens, with the long identifiers, long whitespace runs, comments and strings the vector paths are aimed at.
+// Every piece is kept apart by whitespace or a bracket, so that no run of symbols can join into a malformed token.
+std::string generate_text(int lines, unsigned seed) {
+    std::mt19937 rng(seed);
+    auto pick = [&](int n) { return static_cast<int>(rng() % n); };
+
+    const std::vector<std::string> words = {"select", "reject", "take", "def", "object", "region", "histo", "pt", "eta", "Jet", "Electron", "and", "or", "not", ">", ">=", "==", "!=", "+", "*", "/", "^", "-3", "30", "2.4", "1.5e3", "0.04", "size"};
+    const std::string identifier_chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+    const std::string spaces = " \t\r";
+    const std::string brackets = "()[]{},";
+
+    std::stringstream text;
+    for (int line = 0; line < lines; line++) {
+        int pieces = pick(12);
+        for (int p = 0; p < pieces; p++) {
+            int run = pick(p == 0 ? 3 : 40) + (p == 0 ? 0 : 1);
+            for (int s = 0; s < run; s++) text << spaces[pick(run > 8 ? 3 : 1)];
+
+            switch (pick(6)) {
+                case 0: case 1:
+                    text << words[pick(words.size())];
+                    break;
+                case 2: {
+                    // identifiers long enough to cross several 16 and 32 byte chunks
+                    int length = 1 + pick(80);
+                    text << "v";
+                    for (int c = 0; c < length; c++) text << identifier_chars[pick(identifier_chars.size())];
+                    break;
+                }
+                case 3:
+                    text << brackets[pick(brackets.size())];
+                    break;
+                case 4:
+                    text << '"';
+                    for (int c = pick(30); c > 0; c--) {
+                        char quoted = ' ' + pick(94);
+                        text << (quoted == '"' || quoted == '#' ? ' ' : quoted);
+                    }
+                    text << '"';
+                    break;
+                default:
+                    text << "#";
+                    for (int c = pick(60); c > 0; c--) text << static_cast<char>(' ' + pick(94));
+                    p = pieces;
+                    break;
+            }
+        }
+        if (pick(5) != 0 || line + 1 < lines) text << "\n";
+    }
+    return text.str();
+}
+
+int main(int argc, char **argv) {
+    int lines = argc > 1 ? std::atoi(argv[1]) : 20000;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+
+    std::string text = generate_text(lines, seed);
+    std::vector<Span> reference = legacy_split(text);
+
+    std::vector<Vector_width> widths = {VECTOR_NONE};
+    if (get_supported_vector_width() >= VECTOR_SSE2) widths.push_back(VECTOR_SSE2);
+    if (get_supported_vector_width() >= VECTOR_AVX2) widths.push_back(VECTOR_AVX2);
+    const char *width_names[] = {"scalar", "SSE2  ", "AVX2  "};
+
+    Vector_width default_width = get_vector_width();
+
+    auto lexer = std::make_shared<Lexer>();
+    for (Vector_width width : widths) {
+        set_vector_width(width);
+        std::vector<Span> spans = lexer_split(lexer, text);
+
+        if (spans.size() != reference.size()) {
+            std::cerr << width_names[width] << ": " << spans.size() << " tokens, reference has " << reference.size() << std::endl;
+            return 1;
+        }
+        for (std::size_t i = 0; i < spans.size(); i++) {
+            if (!(spans[i] == reference[i])) {
+                std::cerr << width_names[width] << ": token " << i << " is \"" << spans[i].lexeme << "\" at " << spans[i].line << ":" << spans[i].column
+                    << ", reference has \"" << reference[i].lexeme << "\" at " << reference[i].line << ":" << reference[i].column << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::cout << reference.size() << " tokens in " << text.size() << " bytes, identical at every vector width" << std::endl;
+
+    const int repeats = 10;
+    for (Vector_width width : widths) {
+        set_vector_width(width);
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) lexer_split(lexer, text);
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count() / repeats;
+        std::cout << width_names[width] << ": " << text.size() / seconds / 1e6 << " MB/s" << (width == default_width ? " (default)" : "") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "adl_generator.hpp"
+#include "ast_cache.hpp"
+#include "flat_ast.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source_buffer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+Benchmark of Parser::reparse_lines against parsing the whole file again, for edits to single lines of a synthetic
+ADL file of a few thousand lines. Each edit changes the numbers on one line, and after every edit the tree is
+checked against a full parse of the edited text, node for node, down to the tokens. Every tenth edit is first tried
+with a line that cannot parse, which must be rejected with the tree left as it was. Finally a tree loaded from the
+AST cache must refuse an edit until it is given its source, and then be parsed again in full.
+
+    make bench_incremental_parse && ./bench_incremental_parse [lines] [seed] [edits]
+*/
+
+bool same_tree(const FlatAST &a, const FlatAST &b) {
+    if (a.size() != b.size()) return false;
+    for (Flat_index i = 0; i < a.size(); i++) {
+        if (a.get_ast_type(i) != b.get_ast_type(i)) return false;
+        if (a.get_token_index(i) != b.get_token_index(i)) return false;
+        if (a.get_parent(i) != b.get_parent(i) || a.get_next_sibling(i) != b.get_next_sibling(i)) return false;
+        if (a.has_token(i) && a.get_token(i)->get_lexeme_view() != b.get_token(i)->get_lexeme_view()) return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Parser> parse_file(const std::string &filename) {
+    auto lexer = std::make_unique<Lexer>();
+    lexer->read_lines(filename);
+    auto parser = std::make_unique<Parser>(lexer.release());
+    parser->parse();
+    return parser;
+}
+
+void write_lines(const std::string &filename, const std::vector<std::string> &lines) {
+    std::ofstream out(filename);
+    for (auto &line : lines) out << line << "\n";
+}
+
+int main(int argc, char **argv) {
+    std::size_t line_count = argc > 1 ? std::atoi(argv[1]) : 5000;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+    int edits = argc > 3 ? std::atoi(argv[3]) : 200;
+
+    AdlGenerator generator(seed);
+    std::vector<std::string> lines;
+    while (lines.size() < line_count) {
+        std::stringstream block(generator.next_block());
+        for (std::string line; std::getline(block, line); ) lines.push_back(line);
+    }
+
+    // The incremental parser keeps its original file, so that file is never written again
+    write_lines("bench_incremental_parse.adl", lines);
+    auto incremental = parse_file("bench_incremental_parse.adl");
+    auto last_full = parse_file("bench_incremental_parse.adl");
+
+    std::size_t blocks = incremental->get_root()->get_children().size();
+    std::size_t reparsed = 0;
+    double incremental_seconds = 0;
+    double full_seconds = 0;
+
+    std::mt19937 rng(seed);
+    for (int e = 0; e < edits; e++) {
+        int line = 1 + rng() % lines.size();
+        std::string &text = lines[line - 1];
+
+        if (e % 10 == 0) {
+            bool rejected = false;
+            try {
+                incremental->reparse_lines(line, line, "object )\n");
+            } catch (const std::exception &) {
+                rejected = true;
+            }
+            if (!rejected || !same_tree(incremental->get_flat_ast(), last_full->get_flat_ast())) {
+                std::cerr << "A line that cannot parse was not rejected with the tree left as it was" << std::endl;
+                return 1;
+            }
+        }
+
+        for (char &c : text) {
+            if (c >= '0' && c <= '9') c = '0' + rng() % 10;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        // A replacement of "" would be no lines at all, rather than one empty line
+        Block_changes changes = incremental->reparse_lines(line, line, text + "\n");
+        auto end = std::chrono::steady_clock::now();
+        incremental_seconds += std::chrono::duration<double>(end - start).count();
+        reparsed += changes.inserted.size();
+
+        write_lines("bench_incremental_parse.edited.adl", lines);
+        start = std::chrono::steady_clock::now();
+        auto full = parse_file("bench_incremental_parse.edited.adl");
+        end = std::chrono::steady_clock::now();
+        full_seconds += std::chrono::duration<double>(end - start).count();
+
+        if (!same_tree(incremental->get_flat_ast(), full->get_flat_ast())) {
+            std::cerr << "The incrementally parsed tree differs from a full parse" << std::endl;
+            return 1;
+        }
+        last_full = std::move(full);
+    }
+
+    {
+        const std::string cache_directory = "bench_incremental_parse.cache";
+        PSource source = std::make_shared<const SourceBuffer>("bench_incremental_parse.edited.adl");
+        ASTCache cache(cache_directory);
+        cache.store(source->get_contents(), last_full->get_tree());
+
+        Parser cached(new Lexer());
+        if (!cache.load(source->get_contents(), cached.get_tree())) {
+            std::cerr << "The AST cache did not give back the tree it was given" << std::endl;
+            return 1;
+        }
+
+        bool refused = false;
+        try {
+            cached.reparse_lines(1, 1, lines[0] + "\n");
+        } catch (const std::exception &) {
+            refused = true;
+        }
+
+        cached.set_unlexed_source(source);
+        Block_changes changes = cached.reparse_lines(1, 1, lines[0] + "\n");
+        std::filesystem::remove_all(cache_directory);
+
+        bool reparsed_in_full = changes.removed.size() == last_full->get_root()->get_children().size() && changes.inserted.size() == changes.removed.size();
+        if (!refused || !reparsed_in_full || !same_tree(cached.get_flat_ast(), last_full->get_flat_ast())) {
+            std::cerr << "A tree loaded from the AST cache was not edited as a full parse" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << lines.size() << " lines, " << blocks << " blocks, " << edits << " single-line edits" << std::endl;
+    std::cout << "blocks reparsed per edit: " << static_cast<double>(reparsed) / edits << std::endl;
+    std::cout << "full parse:               " << full_seconds / edits * 1e6 << " us/edit" << std::endl;
+    std::cout << "incremental parse:        " << incremental_seconds / edits * 1e6 << " us/edit" << std::endl;
+
+    return 0;
+}
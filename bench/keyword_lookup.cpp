@@ -0,0 +1,335 @@
+#include "keywords.hpp"
+#include "tokens.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+Microbenchmark of the keyword lookup in Lexer::identify_token: the compile-time perfect hash in keywords.hpp against the chain of string comparisons
+it replaced, which is kept below verbatim. Both are first checked to agree on every token of the corpus.
+
+    make bench_keywords && ./bench_keywords [iterations]
+*/
+
+std::string legacy_convert_to_uppercase(std::string &input) {
+    std::string uppercase;
+    for (auto it = input.begin(); it != input.end(); ++it) {
+            char c = *it;
+
+            // If lowercase ASCII letter, make it uppercase
+            if (c >= 'a' && c <= 'z') c -= 32;
+
+            uppercase += c;
+        }
+    return uppercase;
+}
+
+Token_type legacy_lookup_keyword(std::string &token) {
+    std::string uppercase_token = legacy_convert_to_uppercase(token);
+
+    // Top level ADL syntax
+    if (uppercase_token == "DEF" || uppercase_token == "DEFINE") return DEF;
+    if (uppercase_token == "ALGORITHM" || uppercase_token == "ALGO" || uppercase_token == "REGION") return ALGO;
+    if (uppercase_token == "HISTOLIST") return HISTOLIST;
+    if (uppercase_token == "INFO") return ADLINFO;
+    if (uppercase_token == "OBJ" || uppercase_token == "OBJECT") return OBJ;
+    if (uppercase_token == "COMP" || uppercase_token == "COMPOSITE") return COMP;
+
+
+    if (uppercase_token == "CMD" || uppercase_token == "CUT" || uppercase_token == "SELECT") return SELECT;
+    if (uppercase_token == "REJECT") return REJEC;
+
+    // Header info tags
+    if (token == "experiment") return PAP_EXPERIMENT;
+    if (token == "id") return PAP_ID;
+    if (uppercase_token == "TITLE") return PAP_TITLE;
+    if (token == "publication") return PAP_PUBLICATION;
+    if (token == "sqrtS") return PAP_SQRTS;
+    if (token == "lumi" ) return PAP_LUMI;
+    if (token == "arXiv") return PAP_ARXIV;
+    if (token == "hepdata") return PAP_HEPDATA;
+    if (token == "doi"   ) return PAP_DOI;
+    
+    if (uppercase_token == "PARTICLE" || uppercase_token == "CANDIDATE") return PARTICLE_KEYWORD; // keyword that allows definitions to be of particles and not functions
+    if (uppercase_token == "EXTERN" || uppercase_token  == "EXTERNAL") return EXTERNAL; // keyword that allows arbitrary external functions to be included
+    if (uppercase_token == "CORRECTIONLIB") return CORRECTIONLIB;
+
+    if (token == "systematic") return SYSTEMATIC;
+    if (token == "ttree") return SYST_TTREE;
+    if (token == "weightMc") return SYST_WEIGHT_MC;
+    if (token == "weightPileup") return SYST_WEIGHT_PILEUP;
+    if (token == "weightJvt") return SYST_WEIGHT_JVT;
+    if (token == "weightLeptonSF") return SYST_WEIGHT_LEPTON_SF;
+    if (token == "weightBTagSF") return SYST_WEIGHT_BTAG_SF;
+    if (token == "RunYear") return RUNYEAR;
+    if (token == "mcChannelNumber") return MC_CHANNEL_NUMBER;
+    if (uppercase_token == "EVENTNO") return EVENT_NO;
+    if (uppercase_token == "RUNNO") return RUN_NO;
+    if (uppercase_token == "LBNO") return LB_NO;
+    if (token == "OME") return OME;
+
+    if (uppercase_token == "PRINT") return PRINT;
+    if (uppercase_token == "IF") return IF;
+    if (uppercase_token == "THEN") return THEN;
+    if (uppercase_token == "ELSE") return ELSE;
+    if (uppercase_token == "DO") return DO;
+    if (uppercase_token == "ON" || uppercase_token == "TRUE") return TRUE; 
+    if (uppercase_token == "OFF" || uppercase_token == "FALSE") return FALSE; 
+    if (uppercase_token == "NVARS") return NVARS;
+    if (uppercase_token == "ERRORS") return ERRORS;
+    if (uppercase_token == "TABLETYPE") return TABLETYPE;
+    if (uppercase_token == "TAKE"  || uppercase_token == "USING") return TAKE;
+    if (uppercase_token == "HISTO" || uppercase_token == "HIST") return HISTO;
+    if (uppercase_token == "WEIGHT") return WEIGHT;
+    if (uppercase_token == "TABLE") return TABLE;
+    if (uppercase_token == "SKIPHISTOS") return SKIP_HISTO;
+    if (uppercase_token == "SKIPEFS") return SKIP_EFFS;
+
+    // Particle types
+    if (uppercase_token == "GEN") return GEN;
+    if (uppercase_token == "ELE"|| uppercase_token == "ELECTRON"|| token == "electron") return ELECTRON;
+    if (uppercase_token == "MUO" || uppercase_token == "MUON"| token == "muon") return MUON;
+    if (uppercase_token == "TAU") return TAU;
+    if (uppercase_token == "TRK") return TRACK;
+    if (uppercase_token == "PHO" || uppercase_token == "PHOTON") return PHOTON;
+    if (uppercase_token == "JET") return JET;
+    if (uppercase_token == "FJET"|| uppercase_token == "FATJET") return FJET;
+    if (uppercase_token == "QGJET") return QGJET;
+    if (uppercase_token == "MET" || uppercase_token == "METLV") return METLV;
+
+
+    // Within-object block helper
+    if (uppercase_token == "THIS") return THIS;
+
+    
+    // Particle extra keywords
+    if (token == "daughters" || token == "constituents") return CONSTITUENTS;
+
+
+    if (uppercase_token == "BIN") return BIN;
+    if (uppercase_token == "BINS") return BINS;
+
+    if (token == "genPartIdx") return GENPART_IDX;
+
+
+    if (uppercase_token == "UNION") return UNION;
+    if (uppercase_token == "ALIAS") return ALIAS;
+
+    // Tagging functions
+    // if (uppercase_token == "BTAG") return IS_BTAG;
+    // if (uppercase_token == "CTAG") return IS_CTAG;
+    // if (uppercase_token == "TAUTAG") return IS_TAUTAG;
+    // if (uppercase_token == "FLAVOR" | uppercase_token == "BTAGGER") return FLAVOR;
+
+    // Id functions
+    if (uppercase_token == "PDGID" || uppercase_token == "PDG_ID") return PDG_ID;
+    // if (uppercase_token == "JETID") return JET_ID;
+
+
+    if (uppercase_token == "STATUSFLAGS") return STATUS_FLAGS;
+
+    if (uppercase_token == "ISTIGHT" ) return IS_TIGHT;
+    if (uppercase_token == "ISMEDIUM") return IS_MEDIUM;
+    if (uppercase_token == "ISLOOSE" ) return IS_LOOSE;
+
+    if (uppercase_token == "MINIISO") return MINI_ISO;
+    if (uppercase_token == "ABSISO") return ABS_ISO;
+
+    if (token == "dxy"||uppercase_token == "D0") return DXY;
+    if (token == "dz") return DZ;
+
+    if (uppercase_token == "PHI") return PHI;//functions
+    if (uppercase_token == "ETA") return ETA;
+    if (uppercase_token == "RAP") return RAPIDITY;
+
+    if (uppercase_token == "CHARGE") return CHARGE;
+    if (uppercase_token == "MASS") return MASS;
+
+    if (uppercase_token == "MSOFTDROP") return MSOFTDROP;
+
+    if (uppercase_token == "THETA") return THETA;
+
+    if (uppercase_token == "PT") return PT;
+    if (uppercase_token == "PZ") return PZ;
+    if (uppercase_token == "DR" || uppercase_token == "DELTAR") return DR;
+    if (uppercase_token == "DPHI" || uppercase_token == "DELTAPHI") return DPHI;
+    if (uppercase_token == "DETA" || uppercase_token == "DELTAETA") return DETA;
+
+    if (uppercase_token == "DISTINCT") return DISTINCT;
+
+    if (uppercase_token == "DRHADAMARD" || uppercase_token == "DELTARHADAMARD") return DR_HADAMARD;
+    if (uppercase_token == "DETAHADAMARD" || uppercase_token == "DELTAETAHADAMARD") return DETA_HADAMARD;
+    if (uppercase_token == "DPHIHADAMARD" || uppercase_token == "DELTAPHIHADAMARD") return DPHI_HADAMARD;
+
+    if (uppercase_token == "SIZE" || uppercase_token == "COUNT" || uppercase_token == "NUMOF") return NUMOF;//no arg funcs 
+
+    // Global analysis tokens
+    if (uppercase_token == "ALL") return ALL;
+    if (uppercase_token == "NONE") return NONE;
+
+    // Comparison operators
+    if (token == "=="|| uppercase_token == "EQ") return EQ;
+    if (token == "!="|| uppercase_token == "NE") return NE;
+    if (token == "~!") return MAXIMIZE;
+    if (token == "~=") return MINIMIZE;
+    if (token == "<="|| uppercase_token == "LE") return LE;
+    if (token == ">="|| uppercase_token == "GE") return GE;
+    if (token == "<"|| uppercase_token == "LT") return LT;
+    if (token == ">"|| uppercase_token == "GT") return GT;
+
+    // Logical operators
+    if (uppercase_token == "AND" || token == "&&") return AND;
+    if (uppercase_token == "OR" || token == "||") return OR;
+    if (uppercase_token == "NOT") return NOT;
+    if (uppercase_token == "WITHIN" || uppercase_token == "IN") return WITHIN;
+    if (uppercase_token == "OUTSIDE") return OUTSIDE;
+
+    
+    if (token == "-") return MINUS;
+    if (token == "+") return PLUS;
+    if (token == "*") return MULTIPLY;
+    if (token == "/") return DIVIDE;
+
+    if (token == "&") return AMPERSAND;
+    if (token == "|") return PIPE;
+    if (token == ":") return COLON;
+    if (token == "^") return RAISED_TO_POWER;
+
+    //  A dot, likely used to index an attribute e.g. particle.m
+    if (token == ".") return DOT_INDEX;
+    if (token == "->") return ARROW_INDEX;
+
+    if (token == "(") return OPEN_PAREN;
+    if (token == ")") return CLOSE_PAREN;
+    if (token == "[") return OPEN_SQUARE_BRACE;
+    if (token == "]") return CLOSE_SQUARE_BRACE;
+    if (token == "{") return OPEN_CURLY_BRACE;
+    if (token == "}") return CLOSE_CURLY_BRACE;
+    if (token == "?") return QUESTION;
+    if (token == "=") return ASSIGN;
+    if (token == "_") return UNDERSCORE;
+
+
+    // Purely mathematical functions
+    if (uppercase_token == "DESCEND" || uppercase_token == "DESCENDING" || uppercase_token == "DECREASING") return DESCEND;
+    if (uppercase_token == "TAN") return TAN;
+    if (uppercase_token == "SIN") return SIN;
+    if (uppercase_token == "COS") return COS;
+    if (uppercase_token == "SINH") return SINH;
+    if (uppercase_token == "COSH") return COSH;
+    if (uppercase_token == "TANH") return TANH;
+    if (uppercase_token == "EXP") return EXP;
+    if (uppercase_token == "LOG") return LOG;
+    if (uppercase_token == "ABS") return ABS;
+    if (uppercase_token == "SQRT") return SQRT;
+
+    // Functions on variable lists
+    if (uppercase_token == "AVE") return AVE;
+    if (uppercase_token == "SUM") return SUM;
+    if (uppercase_token == "ADD") return ADD;
+    if (uppercase_token == "SAVE") return SAVE;
+    if (uppercase_token == "CSV") return CSV;
+    if (uppercase_token == "ANY" || uppercase_token == "ANYOF") return ANYOF;
+    if (uppercase_token == "ALLOF" || uppercase_token ==  "ALL") return ALLOF;
+
+    if (uppercase_token == "ASCEND" || uppercase_token == "ASCENDING" || uppercase_token == "INCREASING") return ASCEND;
+ 
+    if (uppercase_token == "ANYOCCURRENCES") return ANYOCCURRENCES;
+    
+    if (uppercase_token == "SORT") return SORT;
+    if (uppercase_token == "COMB" || uppercase_token=="CARTESIAN") return COMB;
+    if (uppercase_token == "DISJOINT") return DISJOINT;
+    if (uppercase_token == "DIRECT") return DIRECT;
+    if (uppercase_token == "MIN") return MIN;
+    if (uppercase_token == "MAX") return MAX;
+    if (uppercase_token == "FIRST") return FIRST;
+    if (uppercase_token == "SECOND") return SECOND;
+    if (token == "+-"|| token == "-+") return PM;
+
+    if (token == ",") return COMMA;
+
+    // these letters are keywords in ADL, and so are their own tokens
+    if (uppercase_token == "Q") return LETTER_Q; // charge
+    if (uppercase_token == "E") return LETTER_E; // energy
+    if (uppercase_token == "P") return LETTER_P; // momentum
+    if (uppercase_token == "M") return LETTER_M; // mass
+
+    return LEXER_ERROR;
+}
+
+std::vector<std::string> build_corpus() {
+    std::vector<std::string> corpus;
+
+    // every keyword as written, lowercased, and with its first letter flipped
+    for (std::size_t i = 0; i < NUM_KEYWORDS; i++) {
+        std::string text(adl_keywords[i].text);
+        corpus.push_back(text);
+
+        std::string lower;
+        for (char c : text) lower += (c >= 'A' && c <= 'Z') ? c + 32 : c;
+        corpus.push_back(lower);
+
+        std::string flipped = text;
+        if (flipped[0] >= 'a' && flipped[0] <= 'z') flipped[0] -= 32;
+        else if (flipped[0] >= 'A' && flipped[0] <= 'Z') flipped[0] += 32;
+        corpus.push_back(flipped);
+    }
+
+    // identifiers and literals of the sort a real analysis is mostly made of
+    std::vector<std::string> others = {
+        "goodJets", "goodEle", "goodMu", "Jet", "FatJet", "Electron", "Muon", "MET", "leps", "presel", "signal", "_MASKgoodJets",
+        "mll", "ht", "dphijj", "btagDeepB", "jetId", "puId", "3.14159", "30", "2.4", "1.5e3", "-2", "\"a string\"", "weightmc", "DZ", "ID",
+        "Experiment", "electron", "muon", "dxy", "D0", "x", "ab", "abcdefghijklmnopqrstuvwxyz"
+    };
+    corpus.insert(corpus.end(), others.begin(), others.end());
+
+    return corpus;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 2000;
+
+    std::vector<std::string> corpus = build_corpus();
+
+    int mismatches = 0;
+    for (auto &token : corpus) {
+        if (legacy_lookup_keyword(token) != lookup_keyword(token)) {
+            std::cerr << "Mismatch on \"" << token << "\": chain gives " << legacy_lookup_keyword(token) << ", table gives " << lookup_keyword(token) << std::endl;
+            mismatches++;
+        }
+    }
+    if (mismatches > 0) return 1;
+
+    // shuffle so that neither lookup benefits from the keywords being visited in table order
+    std::shuffle(corpus.begin(), corpus.end(), std::mt19937(12345));
+
+    long checksum = 0;
+
+    auto start_chain = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        for (auto &token : corpus) checksum += legacy_lookup_keyword(token);
+    }
+    auto end_chain = std::chrono::steady_clock::now();
+
+    auto start_table = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        for (auto &token : corpus) checksum += lookup_keyword(token);
+    }
+    auto end_table = std::chrono::steady_clock::now();
+
+    double lookups = static_cast<double>(iterations) * corpus.size();
+    double chain_ns = std::chrono::duration<double, std::nano>(end_chain - start_chain).count() / lookups;
+    double table_ns = std::chrono::duration<double, std::nano>(end_table - start_table).count() / lookups;
+
+    std::cout << corpus.size() << " tokens x " << iterations << " iterations (checksum " << checksum << ")" << std::endl;
+    std::cout << "comparison chain: " << chain_ns << " ns/lookup" << std::endl;
+    std::cout << "perfect hash:     " << table_ns << " ns/lookup" << std::endl;
+    std::cout << "speedup:          " << chain_ns / table_ns << "x" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "adl_generator.hpp"
+#include "lexer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/*
+Throughput benchmark of the lexer. A synthetic ADL file of the requested size is written from a seeded generator, made of
+define, object and region blocks with comments and numeric literals. It is then lexed with Lexer::read_lines and drained
+through Lexer::next, which is where the whitespace filtering that erase_whitespace used to do up front now happens.
+
+    make bench_lexer && ./bench_lexer [megabytes] [seed] [repeats] [output file]
+*/
+
+int main(int argc, char **argv) {
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 16;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+    int repeats = argc > 3 ? std::atoi(argv[3]) : 5;
+    std::string filename = argc > 4 ? argv[4] : "bench_lexer.adl";
+
+    std::size_t written = AdlGenerator(seed).write_file(filename, static_cast<std::size_t>(megabytes * 1e6));
+
+    std::size_t all_tokens = 0;
+    std::size_t parser_tokens = 0;
+    double best_seconds = 0;
+
+    for (int r = 0; r < repeats; r++) {
+        auto start = std::chrono::steady_clock::now();
+
+        Lexer lexer;
+        lexer.read_lines(filename);
+        lexer.reset();
+
+        std::size_t seen = 0;
+        while (lexer.next()->get_token_type() != LEXER_END_OF_FILE) seen++;
+
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (r == 0 || seconds < best_seconds) best_seconds = seconds;
+        all_tokens = lexer.get_tokens()->size();
+        parser_tokens = seen;
+    }
+
+    std::cout << filename << ": " << written / 1e6 << " MB, " << all_tokens << " tokens (" << parser_tokens << " seen by the parser), seed " << seed << std::endl;
+    std::cout << "best of " << repeats << ": " << best_seconds * 1e3 << " ms" << std::endl;
+    std::cout << written / best_seconds / 1e6 << " MB/s" << std::endl;
+    std::cout << all_tokens / best_seconds / 1e6 << " M tokens/s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "adl_generator.hpp"
+#include "flat_ast.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+/*
+Benchmark of parsing the top-level blocks of a synthetic ADL file on several threads, against the serial parse.
+The input is lexed once and the same tokens are parsed each time, and every parallel tree is first checked to be the
+serial one node for node, down to the tokens.
+
+    make bench_parallel_parse && ./bench_parallel_parse [megabytes] [seed] [max threads] [repeats]
+*/
+
+bool same_tree(const FlatAST &a, const FlatAST &b) {
+    if (a.size() != b.size()) return false;
+    for (Flat_index i = 0; i < a.size(); i++) {
+        if (a.get_ast_type(i) != b.get_ast_type(i)) return false;
+        if (a.get_token_index(i) != b.get_token_index(i)) return false;
+        if (a.get_parent(i) != b.get_parent(i) || a.get_next_sibling(i) != b.get_next_sibling(i)) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 4;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+    unsigned max_threads = argc > 3 ? std::atoi(argv[3]) : 8;
+    int repeats = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    std::string filename = "bench_parallel_parse.adl";
+    AdlGenerator(seed).write_file(filename, static_cast<std::size_t>(megabytes * 1e6));
+
+    Lexer lexer;
+    lexer.read_lines(filename);
+
+    // Each run gets a fresh parser over the same tokens
+    auto run = [&](unsigned threads, std::optional<FlatAST> *flat) {
+        Parser parser(lexer.replay().release());
+        auto start = std::chrono::steady_clock::now();
+        if (threads > 1) parser.parse_parallel(threads);
+        else parser.parse();
+        auto end = std::chrono::steady_clock::now();
+        if (flat) flat->emplace(parser.get_flat_ast());
+        return std::chrono::duration<double>(end - start).count();
+    };
+
+    std::optional<FlatAST> serial_tree;
+    run(1, &serial_tree);
+
+    std::cout << serial_tree->size() << " nodes from " << megabytes << " MB of ADL, seed " << seed << std::endl;
+    double serial_seconds = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        std::optional<FlatAST> tree;
+        run(threads, &tree);
+        if (!same_tree(*serial_tree, *tree)) {
+            std::cerr << "The tree parsed on " << threads << " threads differs from the serial one" << std::endl;
+            return 1;
+        }
+
+        double best = 0;
+        for (int r = 0; r < repeats; r++) {
+            double seconds = run(threads, nullptr);
+            if (r == 0 || seconds < best) best = seconds;
+        }
+        if (threads == 1) serial_seconds = best;
+        std::cout << threads << " threads: " << best * 1e3 << " ms, " << serial_seconds / best << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "adl_generator.hpp"
+#include "lexer.hpp"
+#include "node.hpp"
+#include "parser.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+/*
+Stress test of the list productions and of expressions, parsed under the default stack.
+
+A synthetic ADL file of many blocks, closed by one region holding as many select commands, must give back exactly
+the blocks and commands written, as each is one more turn of a parser loop. Then definitions made of one very
+long chain of operators, of deeply nested parentheses and of a tower of right-associative powers must parse without
+growing the stack, in time proportional to their length, which is checked by parsing them at two lengths.
+
+    make bench_parser_stress && ./bench_parser_stress [blocks] [seed] [expression terms]
+*/
+
+// Parse a file, giving the seconds taken and the parser holding its tree
+double parse_file(const std::string &filename, std::unique_ptr<Parser> &parser) {
+    auto start = std::chrono::steady_clock::now();
+    auto lexer = std::make_unique<Lexer>();
+    lexer->read_lines(filename);
+    parser = std::make_unique<Parser>(lexer.release());
+    parser->parse();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Time the three expression shapes at the given number of terms each, giving seconds per term
+double parse_expressions(int terms) {
+    const char *operators[] = {" + ", " * ", " - ", " / ", " and ", " > ", " or "};
+
+    std::string filename = "bench_parser_stress.adl";
+    {
+        std::ofstream out(filename);
+        out << "define chain = 1";
+        for (int i = 1; i < terms; i++) out << operators[i % 7] << i;
+        out << "\n";
+
+        out << "define nested = " << std::string(terms, '(') << "1" << std::string(terms, ')') << "\n";
+
+        out << "define tower = 2";
+        for (int i = 1; i < terms; i++) out << " ^ 2";
+        out << "\n";
+    }
+
+    std::unique_ptr<Parser> parser;
+    double seconds = parse_file(filename, parser);
+    if (parser->get_root()->get_children().size() != 3) {
+        std::cerr << "Expected 3 definitions, parsed " << parser->get_root()->get_children().size() << std::endl;
+        std::exit(1);
+    }
+    return seconds / (3.0 * terms);
+}
+
+int main(int argc, char **argv) {
+    int blocks = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+    int terms = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+    std::string filename = "bench_parser_stress.adl";
+    {
+        AdlGenerator generator(seed);
+        std::ofstream out(filename);
+        for (int i = 0; i < blocks; i++) out << generator.next_block();
+
+        out << "region stress\n";
+        for (int i = 0; i < blocks; i++) out << "    select " << i << " > 0\n";
+    }
+
+    std::unique_ptr<Parser> parser;
+    double seconds = parse_file(filename, parser);
+
+    // The root holds the blocks; the last one is the stress region, with its name ahead of the commands
+    PNode root = parser->get_root();
+    if (root->get_children().size() != static_cast<std::size_t>(blocks) + 1) {
+        std::cerr << "Expected " << blocks + 1 << " blocks, parsed " << root->get_children().size() << std::endl;
+        return 1;
+    }
+    PNode region = root->get_children().back();
+    if (region->get_children().size() != static_cast<std::size_t>(blocks) + 1) {
+        std::cerr << "Expected " << blocks << " region commands, parsed " << region->get_children().size() - 1 << std::endl;
+        return 1;
+    }
+
+    std::cout << blocks << " blocks and " << blocks << " region commands parsed in " << seconds << " s" << std::endl;
+
+    double short_per_term = parse_expressions(terms / 4);
+    double long_per_term = parse_expressions(terms);
+    std::cout << "expressions of " << terms / 4 << " terms: " << short_per_term * 1e9 << " ns/term" << std::endl;
+    std::cout << "expressions of " << terms << " terms: " << long_per_term * 1e9 << " ns/term" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "adl_generator.hpp"
+#include "ast_visitor.hpp"
+#include "lexer.hpp"
+#include "node.hpp"
+#include "parser.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+Benchmark of the two visitor bases on the same tree: one visitor derives from the virtual ASTVisitor, the other from
+StaticASTVisitor, and both count every node they are handed by a hook before walking on into its children.
+A synthetic ADL file is parsed once and each visitor then walks it the given number of times.
+The two must count the same nodes.
+
+    make bench_visitor && ./bench_visitor [megabytes] [seed] [repeats]
+*/
+
+struct Counts {
+    std::size_t hooked = 0;
+    std::size_t symbols = 0;
+
+    bool operator==(const Counts &other) const {
+        return hooked == other.hooked && symbols == other.symbols;
+    }
+};
+
+class VirtualCounter : public ASTVisitor {
+    private:
+        void count(PNode node) {
+            counts.hooked++;
+            if (node->has_token()) counts.symbols += node->get_symbol();
+            visit_children(node);
+        }
+
+    protected:
+        void visit_object(PNode node) override { count(node); }
+        void visit_region(PNode node) override { count(node); }
+        void visit_definition(PNode node) override { count(node); }
+        void visit_composite(PNode node) override { count(node); }
+        void visit_criteria(PNode node) override { count(node); }
+        void visit_object_select(PNode node) override { count(node); }
+        void visit_object_reject(PNode node) override { count(node); }
+        void visit_region_select(PNode node) override { count(node); }
+        void visit_region_reject(PNode node) override { count(node); }
+        void visit_use(PNode node) override { count(node); }
+        void visit_expression(PNode node) override { count(node); }
+        void visit_if(PNode node) override { count(node); }
+        void visit_condition(PNode node) override { count(node); }
+        void visit_histo_use(PNode node) override { count(node); }
+        void visit_histogram(PNode node) override { count(node); }
+        void visit_histo_list(PNode node) override { count(node); }
+        void visit_particle_sum(PNode node) override { count(node); }
+        void visit_table_def(PNode node) override { count(node); }
+        void visit_bin(PNode node) override { count(node); }
+        void visit_bin_list(PNode node) override { count(node); }
+        void visit_weight(PNode node) override { count(node); }
+
+    public:
+        Counts counts;
+};
+
+class StaticCounter : public StaticASTVisitor<StaticCounter> {
+    private:
+        friend class StaticASTVisitor<StaticCounter>;
+
+        void count(PNode node) {
+            counts.hooked++;
+            if (node->has_token()) counts.symbols += node->get_symbol();
+            visit_children(node);
+        }
+
+        void visit_object(PNode node) { count(node); }
+        void visit_region(PNode node) { count(node); }
+        void visit_definition(PNode node) { count(node); }
+        void visit_composite(PNode node) { count(node); }
+        void visit_criteria(PNode node) { count(node); }
+        void visit_object_select(PNode node) { count(node); }
+        void visit_object_reject(PNode node) { count(node); }
+        void visit_region_select(PNode node) { count(node); }
+        void visit_region_reject(PNode node) { count(node); }
+        void visit_use(PNode node) { count(node); }
+        void visit_expression(PNode node) { count(node); }
+        void visit_if(PNode node) { count(node); }
+        void visit_condition(PNode node) { count(node); }
+        void visit_histo_use(PNode node) { count(node); }
+        void visit_histogram(PNode node) { count(node); }
+        void visit_histo_list(PNode node) { count(node); }
+        void visit_particle_sum(PNode node) { count(node); }
+        void visit_table_def(PNode node) { count(node); }
+        void visit_bin(PNode node) { count(node); }
+        void visit_bin_list(PNode node) { count(node); }
+        void visit_weight(PNode node) { count(node); }
+
+    public:
+        Counts counts;
+};
+
+std::size_t count_nodes(PNode root) {
+    std::size_t total = 0;
+    std::vector<PNode> pending = {root};
+    while (!pending.empty()) {
+        PNode node = pending.back();
+        pending.pop_back();
+        total++;
+        for (auto it = node->get_children().begin(); it != node->get_children().end(); ++it) pending.push_back(*it);
+    }
+    return total;
+}
+
+template <typename Pass>
+double best_time(int repeats, Pass pass) {
+    double best = 0;
+    for (int r = 0; r < repeats; r++) {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (r == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    double megabytes = argc > 1 ? std::atof(argv[1]) : 4;
+    unsigned seed = argc > 2 ? std::atoi(argv[2]) : 12345;
+    int repeats = argc > 3 ? std::atoi(argv[3]) : 10;
+
+    std::string filename = "bench_visitor.adl";
+    AdlGenerator(seed).write_file(filename, static_cast<std::size_t>(megabytes * 1e6));
+
+    auto lexer = std::make_unique<Lexer>();
+    lexer->read_lines(filename);
+    Parser parser(lexer.release());
+    parser.parse();
+
+    PNode root = parser.get_root();
+
+    VirtualCounter virtual_counter;
+    StaticCounter static_counter;
+
+    double virtual_seconds = best_time(repeats, [&]() { virtual_counter.counts = Counts(); virtual_counter.visit(root); });
+    double static_seconds = best_time(repeats, [&]() { static_counter.counts = Counts(); static_counter.visit(root); });
+
+    if (!(virtual_counter.counts == static_counter.counts)) {
+        std::cerr << "The visitors disagree" << std::endl;
+        return 1;
+    }
+
+    std::size_t nodes = count_nodes(root);
+    std::cout << nodes << " nodes from " << megabytes << " MB of ADL, seed " << seed << ", " << virtual_counter.counts.hooked << " of them handed to hooks" << std::endl;
+    std::cout << "ASTVisitor:        " << virtual_seconds / nodes * 1e9 << " ns/node" << std::endl;
+    std::cout << "StaticASTVisitor:  " << static_seconds / nodes * 1e9 << " ns/node" << std::endl;
+
+    return 0;
+}
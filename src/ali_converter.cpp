@@ -1,75 +1,145 @@
 #include "ali_converter.hpp"
+#include "alil_file.hpp"
 #include "lexer.hpp"
 #include "node.hpp"
 #include "tokens.hpp"
 #include "exceptions.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <iomanip>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 
-AnalysisCommand::AnalysisCommand(AnalysisLevelInstruction inst, std::weak_ptr<Token> tok): instruction(inst), source_token(tok), has_dest_argument_yet(false), has_source_token(true)  {
+AnalysisCommand::AnalysisCommand(AnalysisLevelInstruction inst, PToken tok): instruction(inst), num_arguments(0), has_dest_argument_yet(false), source_location(tok.get_index())  {
 
 }
 
-AnalysisCommand::AnalysisCommand(AnalysisLevelInstruction inst): instruction(inst), has_dest_argument_yet(false), source_token(), has_source_token(false)  {
+AnalysisCommand::AnalysisCommand(AnalysisLevelInstruction inst): instruction(inst), num_arguments(0), has_dest_argument_yet(false), source_location(NO_TOKEN_INDEX)  {
 
 }
 
-void AnalysisCommand::add_dest_argument(std::string arg) {
-    assert(!has_dest_argument_yet);
-    has_dest_argument_yet = true;
-    dest_argument = arg;
+AnalysisCommand::AnalysisCommand(AnalysisLevelInstruction inst, Token_index location): instruction(inst), num_arguments(0), has_dest_argument_yet(false), source_location(location)  {
+
 }
 
-void AnalysisCommand::add_source_argument(std::string arg) {
-    source_arguments.push_back(arg);
+AnalysisCommand::AnalysisCommand(const AnalysisCommand &other): instruction(other.instruction), num_arguments(other.num_arguments), has_dest_argument_yet(other.has_dest_argument_yet), source_location(other.source_location) {
+    std::copy(std::begin(other.inline_arguments), std::end(other.inline_arguments), std::begin(inline_arguments));
+    if (other.spilled_arguments) spilled_arguments = std::make_unique<std::vector<Symbol>>(*other.spilled_arguments);
 }
 
-AnalysisLevelInstruction AnalysisCommand::get_instruction() {
-    return instruction;
+AnalysisCommand &AnalysisCommand::operator=(const AnalysisCommand &other) {
+    if (this != &other) *this = AnalysisCommand(other);
+    return *this;
 }
-std::string AnalysisCommand::get_argument(int pos) {
-    assert(pos >= 0);
-    
-    if (pos == 0) {
-        if (has_dest_argument_yet) return dest_argument;
-        assert(source_arguments.size() >= 1);
-        return source_arguments[0];
-    } else if (has_dest_argument_yet) {
-        int pos_in_vec = pos - 1;
-        assert(pos_in_vec < source_arguments.size());
-        return source_arguments[pos_in_vec];
+
+// The interned symbol of an argument, or, for the stand-in of a name not yet numbered, its number within its block
+static Symbol argument_symbol(std::string_view arg) {
+    if (arg.empty() || arg[0] != RELOCATION_MARK) return intern_symbol(arg);
+
+    Symbol number = 0;
+    auto parsed = std::from_chars(arg.data() + 1, arg.data() + arg.size(), number);
+    assert(parsed.ptr == arg.data() + arg.size());
+    return RELOCATED_NAME | number;
+}
+
+void AnalysisCommand::add_dest_argument(std::string_view arg) {
+    add_dest_symbol(argument_symbol(arg));
+}
+
+void AnalysisCommand::add_source_argument(std::string_view arg) {
+    add_source_symbol(argument_symbol(arg));
+}
+
+void AnalysisCommand::push_argument(Symbol arg) {
+    assert(num_arguments < UINT8_MAX);
+
+    if (num_arguments < INLINE_ARGUMENTS) {
+        inline_arguments[num_arguments] = arg;
     } else {
-        assert(pos < source_arguments.size());
-        return source_arguments[pos];
+        if (!spilled_arguments) spilled_arguments = std::make_unique<std::vector<Symbol>>();
+        spilled_arguments->push_back(arg);
     }
+    num_arguments++;
+}
+
+void AnalysisCommand::add_dest_symbol(Symbol arg) {
+    assert(!has_dest_argument_yet);
+    has_dest_argument_yet = true;
 
+    // The destination goes before any sources that were added first
+    push_argument(arg);
+    for (int pos = num_arguments - 1; pos > 0; pos--) argument_slot(pos) = argument_slot(pos - 1);
+    argument_slot(0) = arg;
 }
 
-bool AnalysisCommand::has_dest_argument() {
+void AnalysisCommand::add_source_symbol(Symbol arg) {
+    push_argument(arg);
+}
+
+AnalysisLevelInstruction AnalysisCommand::get_instruction() const {
+    return static_cast<AnalysisLevelInstruction>(instruction);
+}
+const std::string &AnalysisCommand::get_argument(int pos) const {
+    return symbol_text(get_argument_symbol(pos));
+}
+
+Symbol AnalysisCommand::get_argument_symbol(int pos) const {
+    return argument_slot(pos);
+}
+
+void AnalysisCommand::set_argument_symbol(int pos, Symbol arg) {
+    argument_slot(pos) = arg;
+}
+
+Symbol &AnalysisCommand::argument_slot(int pos) {
+    return const_cast<Symbol &>(static_cast<const AnalysisCommand *>(this)->argument_slot(pos));
+}
+
+const Symbol &AnalysisCommand::argument_slot(int pos) const {
+    assert(pos >= 0 && pos < num_arguments);
+
+    if (pos < INLINE_ARGUMENTS) return inline_arguments[pos];
+    return (*spilled_arguments)[pos - INLINE_ARGUMENTS];
+}
+
+bool AnalysisCommand::has_dest_argument() const {
     return has_dest_argument_yet;
 }
 
-std::string AnalysisCommand::get_dest_argument() {
+const std::string &AnalysisCommand::get_dest_argument() const {
     assert(has_dest_argument_yet);
-    return dest_argument;
+    return get_argument(0);
 }
 
-std::string AnalysisCommand::get_source_argument(int pos) {
-    assert(pos < source_arguments.size()); 
-    return source_arguments[pos];
+const std::string &AnalysisCommand::get_source_argument(int pos) const {
+    return get_argument(pos + has_dest_argument_yet);
 }
 
-int AnalysisCommand::get_num_arguments() {
-    return static_cast<int>(has_dest_argument_yet) + source_arguments.size();
+int AnalysisCommand::get_num_arguments() const {
+    return num_arguments;
 }
 
+Token_index AnalysisCommand::get_source_location() const {
+    return source_location;
+}
 
 std::string AnalysisCommand::instruction_to_text(AnalysisLevelInstruction inst) {
 
@@ -279,7 +349,7 @@ std::string AnalysisCommand::instruction_to_text(AnalysisLevelInstruction inst)
         case FUNC_MAX:
             return "FUNC_MAX";
         case FUNC_MAX_LIST:
-            return "FUNC_MAX";
+            return "FUNC_MAX_LIST";
         case FUNC_MIN_LIST:
             return "FUNC_MIN_LIST";
         case FUNC_SORT_ASCEND:
@@ -366,6 +436,8 @@ std::string AnalysisCommand::instruction_to_text(AnalysisLevelInstruction inst)
             return "FUNC_ABS_ISO";
         case FUNC_MINI_ISO:
             return "FUNC_MINI_ISO";
+        case FUNC_DISTINCT:
+            return "FUNC_DISTINCT";
         case FUNC_DR:
             return "FUNC_DR";
         case FUNC_DPHI:
@@ -424,31 +496,35 @@ std::string AnalysisCommand::instruction_to_text(AnalysisLevelInstruction inst)
         }
 }
 
-void AnalysisCommand::print_instruction(int width_of_dest, int width_of_inst) {
+void AnalysisCommand::print_instruction(std::ostream &out, int width_of_dest, int width_of_inst) const {
     
-    if (instruction == MAKE_EMPTY_PARTICLE || instruction == MAKE_EMPTY_UNION || instruction == MAKE_EMPTY_COMB || instruction == CREATE_REGION || instruction == CREATE_MASK) std::cout << std::endl;
+    if (instruction == MAKE_EMPTY_PARTICLE || instruction == MAKE_EMPTY_UNION || instruction == MAKE_EMPTY_COMB || instruction == CREATE_REGION || instruction == CREATE_MASK) out << std::endl;
 
 
-    std::cout << std::left << std::setw(width_of_dest) << (std::stringstream() << "(" << (has_dest_argument_yet ? dest_argument : "") << ") ").str() << std::left << std::setw(2) << " <- ";
+    out << std::left << std::setw(width_of_dest) << (std::stringstream() << "(" << (has_dest_argument_yet ? get_dest_argument() : "") << ") ").str() << std::left << std::setw(2) << " <- ";
 
-    std::cout << std::left << std::setw(width_of_inst) << instruction_to_text(instruction);
+    out << std::left << std::setw(width_of_inst) << instruction_to_text(get_instruction());
 
     std::stringstream args;
 
-    for (auto it = source_arguments.begin(); it != source_arguments.end(); ++it) {
+    for (int pos = has_dest_argument_yet; pos < num_arguments; ++pos) {
         args << " (";
-        args << *it;
+        args << get_argument(pos);
         args << ")";
     }
 
-    std::cout << std::left << args.str();
-    std::cout << std::endl;
+    out << std::left << args.str();
+    out << std::endl;
 
-    if (instruction == END_EXPRESSION || instruction == ADD_HIST_TO_LIST) std::cout << std::endl;
+    if (instruction == END_EXPRESSION || instruction == ADD_HIST_TO_LIST) out << std::endl;
 
 }
 
-void AnalysisCommand::print_instruction() {
+void AnalysisCommand::print_instruction(int width_of_dest, int width_of_inst) const {
+    print_instruction(std::cout, width_of_dest, width_of_inst);
+}
+
+void AnalysisCommand::print_instruction() const {
     print_instruction(0,0);
 }
 
@@ -456,23 +532,35 @@ void visit_if(PNode node) {
 
 }
 
-std::string ALILConverter::reserve_scoped_value_name() {
+// A stand-in is only ever used whole, so a name that needs more after its scope must have it passed as the suffix
+std::string ALILConverter::reserve_scoped_name(const char *prefix, const char *suffix) {
+    // A block lowered on its own thread cannot know how many names the blocks before it take, so it only hands out a
+    // stand-in, and keeps the parts of the name to put together once the block is numbered
+    if (relocatable_names) {
+        relocated_names.push_back({prefix, current_scope_name + suffix});
+        std::string stand_in(1, RELOCATION_MARK);
+        stand_in += std::to_string(highest_var_val++);
+        return stand_in;
+    }
+
     std::stringstream new_var_name;
-    new_var_name << "_V" << highest_var_val++ << "" << current_scope_name;
-    last_value_name = new_var_name.str();
+    new_var_name << prefix << highest_var_val++;
+
+    new_var_name << current_scope_name << suffix;
+    return new_var_name.str();
+}
+
+std::string ALILConverter::reserve_scoped_value_name() {
+    last_value_name = reserve_scoped_name("_V");
     return last_value_name;
 }
 
 std::string ALILConverter::reserve_scoped_limit_name() {
-    std::stringstream new_var_name;
-    new_var_name << "_L" << highest_var_val++ << "" << current_scope_name;
-    return new_var_name.str();
+    return reserve_scoped_name("_L");
 }
 
 std::string ALILConverter::reserve_scoped_region_name() {
-    std::stringstream new_var_name;
-    new_var_name << "_R" << highest_var_val++ << "" << current_scope_name;
-    return new_var_name.str();
+    return reserve_scoped_name("_R");
 }
 
 std::string ALILConverter::if_operator(PNode node) {
@@ -588,7 +676,7 @@ std::string ALILConverter::handle_particle(PNode node, std::string last_part) {
 
         // if we have two parts to the index, add both to the function
         if (node->get_children()[0]->get_children().size() > 1) {
-            next_part.add_source_argument(relevant_node->get_children()[1]->get_token()->get_lexeme());
+            next_part.add_source_symbol(relevant_node->get_children()[1]->get_symbol());
         }
     }
 
@@ -624,8 +712,8 @@ void ALILConverter::visit_bin_list(PNode node) {
 
         std::string condition_result = reserve_scoped_value_name();
         within.add_dest_argument(condition_result);
-        within.add_source_argument(node->get_children()[i-1]->get_token()->get_lexeme());
-        within.add_source_argument(node->get_children()[i]->get_token()->get_lexeme());
+        within.add_source_symbol(node->get_children()[i-1]->get_symbol());
+        within.add_source_symbol(node->get_children()[i]->get_symbol());
 
         command_list.push_back(within);
 
@@ -647,7 +735,7 @@ void ALILConverter::visit_weight(PNode node) {
     AnalysisCommand weight_apply(WEIGHT_APPLY, node->get_children()[0]->get_token());
     weight_apply.add_dest_argument(current_region);
     weight_apply.add_source_argument(prev_name);
-    weight_apply.add_source_argument(node->get_children()[0]->get_token()->get_lexeme());
+    weight_apply.add_source_symbol(node->get_children()[0]->get_symbol());
     weight_apply.add_source_argument(last_condition_name);
 
     command_list.push_back(weight_apply);
@@ -986,7 +1074,7 @@ std::string ALILConverter::literal_value(PNode node) {
 
     std::string dest = reserve_scoped_value_name();
     assign.add_dest_argument(dest);
-    assign.add_source_argument(node->get_token()->get_lexeme());
+    assign.add_source_symbol(node->get_symbol());
 
     command_list.push_back(assign);
 
@@ -1103,13 +1191,29 @@ void ALILConverter::visit_expression(PNode node) {
 
 std::string ALILConverter::handle_expression(PNode node) {
 
+    Expr_id id = expressions ? expressions->id_of(node) : NO_EXPR_ID;
+    if (id == NO_EXPR_ID) return lower_expression(node);
+
+    // An expression that refers to `this`, or to a name that another block defines again, can only be shared within the scope it was lowered in
+    Shared_value &shared = shared_values[id];
+    if (!shared.name.empty() && (shared.scope == current_scope_name || !expressions->is_contextual(id))) {
+        return shared.name;
+    }
+
+    std::string name = lower_expression(node);
+    shared_values[id] = {name, current_scope_name};
+    return name;
+}
+
+std::string ALILConverter::lower_expression(PNode node) {
+
     if (node->get_ast_type() == USER_FUNCTION) {
         std::string source = handle_expression(node->get_children()[0]);
         std::string dest = reserve_scoped_limit_name();
         AnalysisCommand func(FUNC_NAMED);
         func.add_dest_argument(dest);
         func.add_source_argument(source);
-        func.add_source_argument(node->get_children()[1]->get_token()->get_lexeme());
+        func.add_source_symbol(node->get_children()[1]->get_symbol());
 
         command_list.push_back(func);
     } else if (node->get_ast_type() == NEGATE) {
@@ -1145,17 +1249,16 @@ std::string ALILConverter::handle_expression(PNode node) {
 
 void ALILConverter::visit_condition(PNode node) {
 
-    std::stringstream cond_name;
-    cond_name << reserve_scoped_value_name() << "_COND";
+    std::string cond_name = reserve_scoped_name("_V", "_COND");
 
     std::string final = handle_expression(node->get_children()[0]);
 
     AnalysisCommand end_condition(END_EXPRESSION);
-    end_condition.add_dest_argument(cond_name.str());
+    end_condition.add_dest_argument(cond_name);
     end_condition.add_source_argument(final);
 
     command_list.push_back(end_condition);
-    last_condition_name = cond_name.str();
+    last_condition_name = cond_name;
 }
 
 void ALILConverter::visit_if(PNode node) {
@@ -1212,7 +1315,7 @@ void ALILConverter::visit_sort(PNode node) {
 
 void ALILConverter::visit_histo_use(PNode node) {
     AnalysisCommand hist_use(USE_HIST_LIST, node->get_children()[0]->get_token());
-    hist_use.add_source_argument(node->get_children()[0]->get_token()->get_lexeme());
+    hist_use.add_source_symbol(node->get_children()[0]->get_symbol());
 
     // add the name of the most recent cut, since we are using that for our histogram's working region
     hist_use.add_source_argument(current_region);
@@ -1263,9 +1366,9 @@ void ALILConverter::visit_histogram(PNode node) {
 
     AnalysisCommand hist(inst, node->get_children()[0]->get_token());
 
-    hist.add_source_argument(node->get_children()[0]->get_token()->get_lexeme());
+    hist.add_source_symbol(node->get_children()[0]->get_symbol());
     
-    hist.add_source_argument(node->get_children()[1]->get_token()->get_lexeme());
+    hist.add_source_symbol(node->get_children()[1]->get_symbol());
 
     std::string binning_1d = handle_expression(node->get_children()[2]);
     std::string lower_1d = handle_expression(node->get_children()[3]);
@@ -1466,7 +1569,7 @@ std::string ALILConverter::union_list(PNode node, std::string prev) {
     unite.add_source_argument(prev);
 
     if (inst == ADD_NAMED_TO_UNION) {
-        unite.add_source_argument(node->get_token()->get_lexeme());
+        unite.add_source_symbol(node->get_symbol());
     }
 
     command_list.push_back(unite);
@@ -1943,7 +2046,7 @@ void ALILConverter::visit_table_def(PNode node) {
 
     AnalysisCommand create_table(CREATE_TABLE, name->get_token());
     create_table.add_dest_argument(prev_name);
-    create_table.add_source_argument(nvars->get_token()->get_lexeme());
+    create_table.add_source_symbol(nvars->get_symbol());
 
     command_list.push_back(create_table);
 
@@ -1994,7 +2097,7 @@ void ALILConverter::visit_table_def(PNode node) {
     }
 
     AnalysisCommand finish_table(FINISH_TABLE, name->get_token());
-    finish_table.add_dest_argument(name->get_token()->get_lexeme());
+    finish_table.add_dest_symbol(name->get_symbol());
     finish_table.add_source_argument(prev_name);
     command_list.push_back(finish_table);
 
@@ -2036,26 +2139,718 @@ void ALILConverter::clean_command_list() {
 
 }
 
+void ALILConverter::share_expressions(const ExpressionDAG *dag) {
+    expressions = dag;
+    shared_values.assign(dag ? dag->size() : 0, Shared_value());
+}
+
+// Instructions whose result depends on nothing but their instruction and sources, and that the backends only turn into text for later uses
+static bool is_pure_instruction(AnalysisLevelInstruction inst) {
+    if (inst >= EXPR_RAISE && inst <= EXPR_LOGICAL_NOT) return true;
+    if (inst >= FUNC_GEN_PART_IDX && inst <= FUNC_IS_LOOSE) return true;
+    if (inst >= ADD_PART_ELECTRON && inst <= SUB_PART_NAMED) return true;
+
+    switch (inst) {
+        case ADD_ALIAS:
+        case END_EXPRESSION:
+        case MAKE_EMPTY_PARTICLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// A name made by reserve_scoped_name, such as _V12 or _L3_MASKgoodJets, rather than one the ADL gave
+static bool is_intermediate_name(const std::string &name) {
+    return name.size() > 2 && name[0] == '_' && (name[1] == 'V' || name[1] == 'L') && name[2] >= '0' && name[2] <= '9';
+}
+
+// Mix one more word into a hash, as ExpressionDAG does
+static std::uint64_t mix(std::uint64_t hash, std::uint64_t value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
+std::size_t ALILConverter::eliminate_common_subexpressions() {
+
+    // A name defined more than once may mean something else at each use, so no command defining or using one is touched
+    std::unordered_map<Symbol, int> definitions;
+    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
+        if (it->has_dest_argument()) definitions[it->get_argument_symbol(0)]++;
+    }
+
+    auto can_share = [&](const AnalysisCommand &command) {
+        if (!is_pure_instruction(command.get_instruction()) || !command.has_dest_argument()) return false;
+        if (!is_intermediate_name(command.get_dest_argument()) || definitions[command.get_argument_symbol(0)] != 1) return false;
+
+        for (int pos = 1; pos < command.get_num_arguments(); ++pos) {
+            auto found = definitions.find(command.get_argument_symbol(pos));
+            if (found != definitions.end() && found->second > 1) return false;
+        }
+        return true;
+    };
+
+    // The destination of each dropped command, and the one of the earlier command its uses now read instead
+    std::unordered_map<Symbol, Symbol> replacements;
+    // Kept pure commands by a hash of their instruction and sources; colliding ones are told apart by comparing them
+    std::unordered_multimap<std::uint64_t, std::size_t> kept_by_hash;
+
+    std::vector<AnalysisCommand> kept;
+    kept.reserve(command_list.size());
+
+    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
+        AnalysisCommand &command = *it;
+
+        for (int pos = command.has_dest_argument(); pos < command.get_num_arguments(); ++pos) {
+            auto replaced = replacements.find(command.get_argument_symbol(pos));
+            if (replaced != replacements.end()) command.set_argument_symbol(pos, replaced->second);
+        }
+
+        if (!can_share(command)) {
+            kept.push_back(std::move(command));
+            continue;
+        }
+
+        std::uint64_t hash = mix(command.get_instruction(), command.get_num_arguments());
+        for (int pos = 1; pos < command.get_num_arguments(); ++pos) hash = mix(hash, command.get_argument_symbol(pos));
+
+        bool dropped = false;
+        auto [first, last] = kept_by_hash.equal_range(hash);
+        for (auto candidate = first; candidate != last && !dropped; ++candidate) {
+            const AnalysisCommand &earlier = kept[candidate->second];
+            if (earlier.get_instruction() != command.get_instruction() || earlier.get_num_arguments() != command.get_num_arguments()) continue;
+
+            bool same_sources = true;
+            for (int pos = 1; pos < command.get_num_arguments() && same_sources; ++pos) {
+                same_sources = earlier.get_argument_symbol(pos) == command.get_argument_symbol(pos);
+            }
+            if (!same_sources) continue;
+
+            replacements[command.get_argument_symbol(0)] = earlier.get_argument_symbol(0);
+            dropped = true;
+        }
+        if (dropped) continue;
+
+        kept_by_hash.insert({hash, kept.size()});
+        kept.push_back(std::move(command));
+    }
+
+    std::size_t removed = command_list.size() - kept.size();
+    command_list = std::move(kept);
+    iter_command = 0;
+    return removed;
+}
+
+// A value known before the analysis runs; integral ones are written, and computed on by the backends, as integers
+struct Constant {
+    double value;
+    bool integral;
+};
+
+// Integers past this are not all exact as doubles
+constexpr double MAX_EXACT_INTEGER = 9007199254740992.0;
+
+// Read a numeric literal such as 30, -2, 2.5 or 1.5e3; names, and text such as inf or 0x10, are not literals
+static bool parse_constant(const std::string &text, Constant &constant) {
+    if (text.empty() || text.find_first_not_of("0123456789.eE+-") != std::string::npos) return false;
+
+    const char *start = text.c_str();
+    char *end = nullptr;
+    double value = std::strtod(start, &end);
+    if (end != start + text.size() || !std::isfinite(value)) return false;
+
+    constant.value = value;
+    constant.integral = text.find_first_of(".eE") == std::string::npos && std::abs(value) < MAX_EXACT_INTEGER;
+    return true;
+}
+
+// The shortest text that reads back as the constant, with a floating point one always written as one
+static std::string constant_text(const Constant &constant) {
+    std::ostringstream text;
+    if (constant.integral) {
+        text << static_cast<long long>(constant.value);
+        return text.str();
+    }
+
+    for (int precision = 1; precision <= 17; ++precision) {
+        text.str("");
+        text << std::setprecision(precision) << constant.value;
+        if (std::strtod(text.str().c_str(), nullptr) == constant.value) break;
+    }
+    if (text.str().find_first_of(".e") == std::string::npos) text << ".0";
+    return text.str();
+}
+
+static Constant boolean_constant(bool value) {
+    return {value ? 1.0 : 0.0, true};
+}
+
+// Results kept integral only while exact, as C++ and Python integers would give them
+static Constant integer_or_floating(double value, bool integral) {
+    return {value, integral && value == std::trunc(value) && std::abs(value) < MAX_EXACT_INTEGER};
+}
+
+// Whether an interval instruction holds, given its value and bounds
+static bool interval_holds(AnalysisLevelInstruction inst, double value, double low, double high) {
+    switch (inst) {
+        case EXPR_WITHIN: return value >= low && value <= high;
+        case EXPR_WITHIN_EXCLUSIVE: return value > low && value < high;
+        case EXPR_WITHIN_LEFT_EXCLUSIVE: return value > low && value <= high;
+        case EXPR_WITHIN_RIGHT_EXCLUSIVE: return value >= low && value < high;
+        default: return value <= low || value >= high;
+    }
+}
+
+/*
+Whether an interval instruction holds for every value, or for none, whatever the value is: an outside interval whose
+bounds meet or cross always does, and a within interval whose bounds cross, or meet on an excluded end, never does.
+*/
+static bool interval_is_decided(AnalysisLevelInstruction inst, double low, double high, bool &holds) {
+    switch (inst) {
+        case EXPR_OUTSIDE:
+            holds = true;
+            return low >= high;
+        case EXPR_WITHIN:
+            holds = false;
+            return low > high;
+        default:
+            holds = false;
+            return low >= high;
+    }
+}
+
+// Instructions whose result is a truth value, so that x and true, or not not x, is x itself
+static bool is_boolean_instruction(AnalysisLevelInstruction inst) {
+    return (inst >= EXPR_LT && inst <= EXPR_NE) || inst == EXPR_AND || inst == EXPR_OR || (inst >= EXPR_WITHIN && inst <= EXPR_OUTSIDE) || inst == EXPR_LOGICAL_NOT;
+}
+
+// Work out a pure instruction on constant sources; false if it is not one that can be, or gives no finite result
+static bool fold_instruction(AnalysisLevelInstruction inst, const std::vector<Constant> &sources, Constant &result) {
+
+    if (sources.size() == 1) {
+        const Constant &x = sources[0];
+        switch (inst) {
+            case EXPR_NEGATE: result = {-x.value, x.integral}; return true;
+            case EXPR_LOGICAL_NOT: result = boolean_constant(x.value == 0); return true;
+            case FUNC_ABS: result = {std::abs(x.value), x.integral}; return true;
+            case FUNC_SQRT: result = {std::sqrt(x.value), false}; break;
+            case FUNC_COS: result = {std::cos(x.value), false}; break;
+            case FUNC_SIN: result = {std::sin(x.value), false}; break;
+            case FUNC_TAN: result = {std::tan(x.value), false}; break;
+            case FUNC_SINH: result = {std::sinh(x.value), false}; break;
+            case FUNC_COSH: result = {std::cosh(x.value), false}; break;
+            case FUNC_TANH: result = {std::tanh(x.value), false}; break;
+            case FUNC_EXP: result = {std::exp(x.value), false}; break;
+            case FUNC_LOG: result = {std::log(x.value), false}; break;
+            default: return false;
+        }
+        return std::isfinite(result.value);
+    }
+
+    if (sources.size() == 2) {
+        const Constant &a = sources[0];
+        const Constant &b = sources[1];
+        bool integral = a.integral && b.integral;
+        switch (inst) {
+            case EXPR_ADD: result = integer_or_floating(a.value + b.value, integral); break;
+            case EXPR_SUBTRACT: result = integer_or_floating(a.value - b.value, integral); break;
+            case EXPR_MULTIPLY: result = integer_or_floating(a.value * b.value, integral); break;
+            // The backends raise with a floating point function, so 2^3 is 8.0 and a later division by it does not truncate
+            case EXPR_RAISE: result = {std::pow(a.value, b.value), false}; break;
+            case EXPR_DIVIDE:
+                // Integer division truncates in C++ but not in Python, so only an exact one is folded
+                if (b.value == 0 || (integral && std::fmod(a.value, b.value) != 0)) return false;
+                result = integer_or_floating(a.value / b.value, integral);
+                break;
+            case EXPR_LT: result = boolean_constant(a.value < b.value); return true;
+            case EXPR_LE: result = boolean_constant(a.value <= b.value); return true;
+            case EXPR_GT: result = boolean_constant(a.value > b.value); return true;
+            case EXPR_GE: result = boolean_constant(a.value >= b.value); return true;
+            case EXPR_EQ: result = boolean_constant(a.value == b.value); return true;
+            case EXPR_NE: result = boolean_constant(a.value != b.value); return true;
+            case EXPR_AND: result = boolean_constant(a.value != 0 && b.value != 0); return true;
+            case EXPR_OR: result = boolean_constant(a.value != 0 || b.value != 0); return true;
+            default: return false;
+        }
+        return std::isfinite(result.value) && (!result.integral || result.value == std::trunc(result.value));
+    }
+
+    if (sources.size() == 3 && inst >= EXPR_WITHIN && inst <= EXPR_OUTSIDE) {
+        result = boolean_constant(interval_holds(inst, sources[0].value, sources[1].value, sources[2].value));
+        return true;
+    }
+
+    return false;
+}
+
+std::size_t ALILConverter::fold_constants() {
+
+    // A name defined more than once may hold something else at each use, so none is taken to be constant
+    std::unordered_map<Symbol, int> definitions;
+    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
+        if (it->has_dest_argument()) definitions[it->get_argument_symbol(0)]++;
+    }
+
+    // Names only ever used, directly or through aliases, as the condition of a region cut, which is one truth value per
+    // event whatever it is made from. Every use of a name comes after it is defined, so this is found walking backwards.
+    std::unordered_map<Symbol, bool> only_cut_conditions;
+    for (auto it = command_list.rbegin(); it != command_list.rend(); ++it) {
+        bool is_alias = (it->get_instruction() == ADD_ALIAS || it->get_instruction() == END_EXPRESSION) && it->has_dest_argument() && it->get_num_arguments() == 2;
+        bool dest_only_cut = is_alias && only_cut_conditions[it->get_argument_symbol(0)];
+
+        for (int pos = it->has_dest_argument(); pos < it->get_num_arguments(); ++pos) {
+            bool is_cut_condition = (it->get_instruction() == CUT_REGION && pos == 2) || dest_only_cut;
+            auto inserted = only_cut_conditions.insert({it->get_argument_symbol(pos), is_cut_condition});
+            if (!inserted.second) inserted.first->second = inserted.first->second && is_cut_condition;
+        }
+    }
+
+    auto defined_once = [&](Symbol name) {
+        auto found = definitions.find(name);
+        return found != definitions.end() && found->second == 1;
+    };
+
+    std::unordered_map<Symbol, Constant> constants;
+    std::unordered_set<Symbol> booleans;
+    // The instruction and source of each not and negation, so that a second one can give the source back
+    std::unordered_map<Symbol, std::pair<AnalysisLevelInstruction, Symbol>> negated;
+
+    auto constant_of = [&](Symbol name, Constant &constant) {
+        auto found = constants.find(name);
+        if (found != constants.end()) {
+            constant = found->second;
+            return true;
+        }
+        return parse_constant(symbol_text(name), constant);
+    };
+
+    std::size_t folded = 0;
+
+    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
+        AnalysisCommand &command = *it;
+        AnalysisLevelInstruction inst = command.get_instruction();
+        if (!command.has_dest_argument() || !is_pure_instruction(inst)) continue;
+
+        Symbol dest = command.get_argument_symbol(0);
+        bool trusted = defined_once(dest);
+        int num_sources = command.get_num_arguments() - 1;
+
+        std::vector<Constant> sources(num_sources);
+        int num_constant = 0;
+        for (int pos = 0; pos < num_sources; ++pos) {
+            if (constant_of(command.get_argument_symbol(pos + 1), sources[pos])) num_constant++;
+        }
+
+        if ((inst == ADD_ALIAS || inst == END_EXPRESSION) && num_sources == 1) {
+            if (!trusted) continue;
+            if (num_constant == 1) constants[dest] = sources[0];
+            if (booleans.count(command.get_argument_symbol(1)) != 0) booleans.insert(dest);
+            continue;
+        }
+
+        if (inst < EXPR_RAISE || (inst > EXPR_LOGICAL_NOT && (inst < FUNC_SQRT || inst > FUNC_LOG))) continue;
+
+        // The command becomes an alias of the constant or source it is found to equal
+        Constant result;
+        Symbol same_as = NO_SYMBOL;
+
+        bool is_constant = num_constant == num_sources && fold_instruction(inst, sources, result);
+
+        // With constant bounds an interval may hold for any value, but a value of each object would then become a single one
+        if (!is_constant && num_sources == 3 && num_constant == 2 && !constant_of(command.get_argument_symbol(1), sources[0]) && inst >= EXPR_WITHIN && inst <= EXPR_OUTSIDE) {
+            bool holds;
+            if (only_cut_conditions[dest] && interval_is_decided(inst, sources[1].value, sources[2].value, holds)) {
+                result = boolean_constant(holds);
+                is_constant = true;
+            }
+        }
+
+        if (!is_constant && num_sources == 2 && num_constant == 1) {
+            Symbol a = command.get_argument_symbol(1);
+            Symbol b = command.get_argument_symbol(2);
+            bool a_constant = constant_of(a, sources[0]);
+            const Constant &c = a_constant ? sources[0] : sources[1];
+            Symbol other = a_constant ? b : a;
+
+            // Only integral identities, since x * 1.0 would make an integer x floating point
+            switch (inst) {
+                case EXPR_MULTIPLY:
+                    if (c.integral && c.value == 1) same_as = other;
+                    break;
+                case EXPR_ADD:
+                    if (c.integral && c.value == 0) same_as = other;
+                    break;
+                // x ^ 1 is left alone, as the power makes an integer x floating point
+                case EXPR_DIVIDE:
+                    if (!a_constant && c.integral && c.value == 1) same_as = a;
+                    break;
+                case EXPR_SUBTRACT:
+                    if (!a_constant && c.integral && c.value == 0) same_as = a;
+                    break;
+                case EXPR_AND:
+                    if (c.value != 0 && booleans.count(other) != 0) same_as = other;
+                    break;
+                case EXPR_OR:
+                    if (c.value == 0 && booleans.count(other) != 0) same_as = other;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (!is_constant && same_as == NO_SYMBOL && num_sources == 1 && (inst == EXPR_NEGATE || inst == EXPR_LOGICAL_NOT)) {
+            Symbol source = command.get_argument_symbol(1);
+            auto found = negated.find(source);
+            if (found != negated.end() && found->second.first == inst) {
+                // not not x is x only for a truth value x; for a number it is 0 or 1
+                Symbol original = found->second.second;
+                if (inst == EXPR_NEGATE || booleans.count(original) != 0) same_as = original;
+            }
+        }
+
+        if (is_constant || same_as != NO_SYMBOL) {
+            AnalysisCommand alias(ADD_ALIAS, command.get_source_location());
+            alias.add_dest_symbol(dest);
+            if (is_constant) alias.add_source_argument(constant_text(result));
+            else alias.add_source_symbol(same_as);
+
+            command = std::move(alias);
+            folded++;
+
+            if (!trusted) continue;
+            if (is_constant) constants[dest] = result;
+            else if (booleans.count(same_as) != 0) booleans.insert(dest);
+            continue;
+        }
+
+        if (!trusted) continue;
+        if (is_boolean_instruction(inst)) booleans.insert(dest);
+        if ((inst == EXPR_NEGATE || inst == EXPR_LOGICAL_NOT) && defined_once(command.get_argument_symbol(1))) {
+            negated[dest] = {inst, command.get_argument_symbol(1)};
+        }
+    }
+
+    iter_command = 0;
+    return folded;
+}
+
+// Commands that make the analysis' output, and so are kept along with everything they use
+static bool is_root_instruction(AnalysisLevelInstruction inst) {
+    switch (inst) {
+        case CREATE_REGION:
+        case MERGE_REGIONS:
+        case CUT_REGION:
+        case WEIGHT_APPLY:
+        case CREATE_BIN:
+        case USE_HIST:
+        case USE_HIST_LIST:
+        case DO_CUTFLOW_ON_REGION:
+        case DO_EVENTLIST_ON_REGION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// The name a command defines: its destination, or the histogram a HIST_1D or HIST_2D is given first; NO_SYMBOL if none
+static Symbol defined_name(const AnalysisCommand &command) {
+    if (command.has_dest_argument()) return command.get_argument_symbol(0);
+    if ((command.get_instruction() == HIST_1D || command.get_instruction() == HIST_2D) && command.get_num_arguments() > 0) return command.get_argument_symbol(0);
+    return NO_SYMBOL;
+}
+
+std::size_t ALILConverter::eliminate_dead_commands() {
+
+    std::unordered_set<Symbol> defined;
+    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
+        Symbol name = defined_name(*it);
+        if (name != NO_SYMBOL) defined.insert(name);
+    }
+
+    // The commands to keep once a name is live. A pure command only ever defines its destination, but any other may
+    // also change a name it is given in place, as LIMIT_MASK does to its mask, so it is kept whenever any of its names is.
+    // An element of a composite, such as Zs->e1, is kept along with the composite.
+    std::unordered_map<Symbol, std::vector<std::size_t>> keepers;
+    for (std::size_t i = 0; i < command_list.size(); ++i) {
+        const AnalysisCommand &command = command_list[i];
+
+        Symbol name = defined_name(command);
+        if (name != NO_SYMBOL) {
+            keepers[name].push_back(i);
+
+            std::size_t arrow = symbol_text(name).find("->");
+            if (arrow != std::string::npos) keepers[intern_symbol(std::string_view(symbol_text(name)).substr(0, arrow))].push_back(i);
+        }
+
+        if (is_pure_instruction(command.get_instruction())) continue;
+        for (int pos = command.has_dest_argument(); pos < command.get_num_arguments(); ++pos) {
+            if (defined.count(command.get_argument_symbol(pos)) != 0) keepers[command.get_argument_symbol(pos)].push_back(i);
+        }
+    }
+
+    std::vector<bool> live(command_list.size(), false);
+    std::vector<std::size_t> pending;
+    auto keep = [&](std::size_t i) {
+        if (live[i]) return;
+        live[i] = true;
+        pending.push_back(i);
+    };
+
+    // Commands that define nothing, such as BEGIN_IF, are kept as they are
+    for (std::size_t i = 0; i < command_list.size(); ++i) {
+        if (is_root_instruction(command_list[i].get_instruction()) || defined_name(command_list[i]) == NO_SYMBOL) keep(i);
+    }
+
+    std::unordered_set<Symbol> live_names;
+    while (!pending.empty()) {
+        const AnalysisCommand &command = command_list[pending.back()];
+        pending.pop_back();
+
+        for (int pos = 0; pos < command.get_num_arguments(); ++pos) {
+            Symbol name = command.get_argument_symbol(pos);
+            if (defined.count(name) == 0 || !live_names.insert(name).second) continue;
+
+            auto found = keepers.find(name);
+            if (found == keepers.end()) continue;
+            for (auto keeper = found->second.begin(); keeper != found->second.end(); ++keeper) keep(*keeper);
+        }
+    }
+
+    std::vector<AnalysisCommand> kept;
+    kept.reserve(command_list.size());
+    for (std::size_t i = 0; i < command_list.size(); ++i) {
+        if (live[i]) kept.push_back(std::move(command_list[i]));
+    }
+
+    std::size_t removed = command_list.size() - kept.size();
+    command_list = std::move(kept);
+    iter_command = 0;
+    return removed;
+}
+
 void ALILConverter::visitation(PNode root) {
     visit(root);
     clean_command_list();
 }
 
-void ALILConverter::print_commands() {
+// Replace each stand-in in the arguments of a block's commands with its name, numbered after the names reserved before the block
+static void renumber_names(std::vector<AnalysisCommand> &commands, const std::vector<Relocated_name> &names, int offset) {
+    // Most names are used more than once, so each is only put together and interned the first time
+    std::vector<Symbol> numbered(names.size(), NO_SYMBOL);
+    std::string text;
+
+    for (AnalysisCommand &command : commands) {
+        for (int pos = 0; pos < command.get_num_arguments(); ++pos) {
+            Symbol symbol = command.get_argument_symbol(pos);
+            if (!(symbol & RELOCATED_NAME)) continue;
+
+            Symbol number = symbol & ~RELOCATED_NAME;
+            if (numbered[number] == NO_SYMBOL) {
+                const Relocated_name &name = names[number];
+                text = name.prefix;
+                text += std::to_string(number + offset);
+                text += name.rest;
+                numbered[number] = intern_symbol(text);
+            }
+            command.set_argument_symbol(pos, numbered[number]);
+        }
+    }
+}
 
-    int top_size_of_dest = 0;
-    int top_size_of_inst = 0;
+/*
+The top-level blocks form a dependency graph: a block depends on every other block that defines a name it uses,
+such as the objects a region selects on. The blocks are lowered by separate converters, each on whichever thread
+takes it once its dependencies are done, into a buffer of its own. The buffers are then joined in a topological
+order that keeps to the order of the file wherever it can, so it is the order of the file whenever every name is
+defined before it is used. Each converter numbers its names from 0, and its commands hold only those numbers until
+the buffers are joined, when each becomes exactly the name a serial visitation would have given it.
+*/
+void ALILConverter::visitation_parallel(PNode root, const FlatAST &ast, unsigned threads) {
+    std::vector<PNode> blocks(root->get_children().begin(), root->get_children().end());
+    std::size_t num_blocks = blocks.size();
+
+    if (threads < 2 || num_blocks < 2) return visitation(root);
+
+    // Each block is a contiguous run of the FlatAST, from its own position up to its next sibling's
+    std::vector<Flat_index> block_starts;
+    for (Flat_index child = ast.get_first_child(ast.get_root()); child != NO_FLAT_NODE; child = ast.get_next_sibling(child)) {
+        block_starts.push_back(child);
+    }
+    assert(block_starts.size() == num_blocks);
+    block_starts.push_back(ast.size());
+
+    // The name each block defines is its first child, if that is a token
+    std::unordered_map<Symbol, std::vector<std::size_t>> defined_by;
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        Flat_index first_child = ast.get_first_child(block_starts[b]);
+        if (first_child != NO_FLAT_NODE && ast.has_token(first_child)) defined_by[ast.get_symbol(first_child)].push_back(b);
+    }
 
-    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
-        if (it->has_dest_argument()) {
-            top_size_of_dest = std::max(top_size_of_dest, static_cast<int>(it->get_dest_argument().size()));
+    // Every token of a block that names another block is a dependency on it
+    std::vector<std::vector<std::size_t>> dependencies(num_blocks);
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        for (Flat_index node = block_starts[b]; node < block_starts[b + 1]; ++node) {
+            Symbol symbol = ast.get_symbol(node);
+            if (symbol == NO_SYMBOL) continue;
+
+            auto found = defined_by.find(symbol);
+            if (found == defined_by.end()) continue;
+            for (std::size_t other : found->second) {
+                if (other != b) dependencies[b].push_back(other);
+            }
         }
-        top_size_of_inst = std::max(top_size_of_inst, static_cast<int>(AnalysisCommand::instruction_to_text(it->get_instruction()).size()));
+
+        std::sort(dependencies[b].begin(), dependencies[b].end());
+        dependencies[b].erase(std::unique(dependencies[b].begin(), dependencies[b].end()), dependencies[b].end());
     }
 
-    for (auto it = command_list.begin(); it != command_list.end(); ++it) {
-        it->print_instruction(top_size_of_dest+4, top_size_of_inst+1);
+    // Kahn's algorithm, always taking the earliest ready block. A cycle, which only a name defined twice can make,
+    // is broken by taking the earliest block left as if it were ready.
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> position(num_blocks, num_blocks);
+    {
+        std::vector<std::vector<std::size_t>> dependents(num_blocks);
+        std::vector<std::size_t> unmet(num_blocks);
+        for (std::size_t b = 0; b < num_blocks; ++b) {
+            unmet[b] = dependencies[b].size();
+            for (std::size_t dependency : dependencies[b]) dependents[dependency].push_back(b);
+        }
+
+        std::set<std::size_t> ready;
+        for (std::size_t b = 0; b < num_blocks; ++b) if (unmet[b] == 0) ready.insert(b);
+
+        std::size_t next_unplaced = 0;
+        while (order.size() < num_blocks) {
+            if (ready.empty()) {
+                while (position[next_unplaced] != num_blocks) next_unplaced++;
+                ready.insert(next_unplaced);
+            }
+
+            std::size_t b = *ready.begin();
+            ready.erase(ready.begin());
+            position[b] = order.size();
+            order.push_back(b);
+
+            for (std::size_t dependent : dependents[b]) {
+                if (position[dependent] == num_blocks && --unmet[dependent] == 0) ready.insert(dependent);
+            }
+        }
+    }
+
+    // Only the dependencies on blocks earlier in the order are waited for, so a broken cycle cannot hold up the threads
+    std::vector<std::vector<std::size_t>> dependents(num_blocks);
+    std::vector<std::size_t> unmet(num_blocks, 0);
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        for (std::size_t dependency : dependencies[b]) {
+            if (position[dependency] < position[b]) {
+                dependents[dependency].push_back(b);
+                unmet[b]++;
+            }
+        }
+    }
+
+    struct Lowered_block {
+        std::vector<AnalysisCommand> commands;
+        std::vector<Relocated_name> names;
+        std::exception_ptr error;
+    };
+    std::vector<Lowered_block> lowered(num_blocks);
+
+    // Ready blocks, by their place in the order, so that the threads take them roughly in the order they will be joined
+    std::set<std::size_t> ready;
+    for (std::size_t b = 0; b < num_blocks; ++b) if (unmet[b] == 0) ready.insert(position[b]);
+
+    std::mutex scheduler_mutex;
+    std::condition_variable scheduler_wake;
+    std::size_t num_lowered = 0;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(scheduler_mutex);
+
+        while (true) {
+            scheduler_wake.wait(lock, [&]() { return !ready.empty() || num_lowered == num_blocks; });
+            if (ready.empty()) return;
+
+            std::size_t b = order[*ready.begin()];
+            ready.erase(ready.begin());
+            lock.unlock();
+
+            ALILConverter block_converter(config);
+            block_converter.relocatable_names = true;
+            if (expressions) block_converter.share_expressions(expressions);
+
+            try {
+                block_converter.visit(blocks[b]);
+            } catch (...) {
+                lowered[b].error = std::current_exception();
+            }
+            lowered[b].commands = std::move(block_converter.command_list);
+            lowered[b].names = std::move(block_converter.relocated_names);
+
+            lock.lock();
+            num_lowered++;
+            for (std::size_t dependent : dependents[b]) {
+                if (--unmet[dependent] == 0) ready.insert(position[dependent]);
+            }
+            scheduler_wake.notify_all();
+        }
+    };
+
+    get_symbol_table().share_between_threads(true);
+
+    std::vector<std::thread> pool;
+    unsigned num_threads = std::min<std::size_t>(threads, num_blocks);
+    for (unsigned t = 0; t < num_threads; ++t) pool.emplace_back(worker);
+    for (auto &thread : pool) thread.join();
+
+    // A serial visitation would have stopped at the first block of the file to fail
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        if (lowered[b].error) {
+            get_symbol_table().share_between_threads(false);
+            std::rethrow_exception(lowered[b].error);
+        }
     }
+
+    // Once every block is lowered, the names reserved before each one are known, and the blocks can be renumbered at once
+    std::vector<int> offsets(num_blocks);
+    std::size_t num_commands = 0;
+    for (std::size_t b : order) {
+        offsets[b] = highest_var_val;
+        highest_var_val += lowered[b].names.size();
+        num_commands += lowered[b].commands.size();
+    }
+
+    std::atomic<std::size_t> next_position(0);
+    auto renumberer = [&]() {
+        for (std::size_t p = next_position++; p < num_blocks; p = next_position++) {
+            renumber_names(lowered[order[p]].commands, lowered[order[p]].names, offsets[order[p]]);
+        }
+    };
+
+    pool.clear();
+    for (unsigned t = 0; t < num_threads; ++t) pool.emplace_back(renumberer);
+    for (auto &thread : pool) thread.join();
+
+    get_symbol_table().share_between_threads(false);
+
+    command_list.reserve(command_list.size() + num_commands);
+    for (std::size_t b : order) {
+        std::move(lowered[b].commands.begin(), lowered[b].commands.end(), std::back_inserter(command_list));
+    }
+
+    clean_command_list();
+}
+
+void ALILConverter::print_commands() {
+    ALILWriter(std::cout).write_text(command_list);
+}
+
+const std::vector<AnalysisCommand> &ALILConverter::get_commands() const {
+    return command_list;
+}
+
+void ALILConverter::load_commands(std::vector<AnalysisCommand> commands) {
+    command_list = std::move(commands);
+    iter_command = 0;
 }
 
 bool ALILConverter::clear_to_next() {
@@ -2063,10 +2858,10 @@ bool ALILConverter::clear_to_next() {
     return true;
 }
 
-AnalysisCommand ALILConverter::next_command() {
+const AnalysisCommand &ALILConverter::next_command() {
     return command_list[iter_command++];
 }
 
-ALILConverter::ALILConverter(Config &conf): highest_var_val(0), iter_command(0),  config(conf){}
+ALILConverter::ALILConverter(Config &conf): highest_var_val(0), relocatable_names(false), expressions(nullptr), iter_command(0),  config(conf){}
 
 ALILToFrameworkCompiler::ALILToFrameworkCompiler(ALILConverter *alil_in, Config &conf): alil(alil_in), config(conf) {}
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "alil_file.hpp"
+#include "exceptions.hpp"
+#include "symbol_table.hpp"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+static const char alil_magic[8] = {'A', 'D', 'L', 'A', 'L', 'I', 'L', '\0'};
+
+template <typename Unsigned>
+static void write_little_endian(std::ostream &out, Unsigned value) {
+    char bytes[sizeof(Unsigned)];
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    out.write(bytes, sizeof(Unsigned));
+}
+
+template <typename Unsigned>
+static bool read_little_endian(std::string_view data, std::size_t &position, Unsigned &value) {
+    if (data.size() - position < sizeof(Unsigned)) return false;
+
+    value = 0;
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+        value |= static_cast<Unsigned>(static_cast<Unsigned>(static_cast<unsigned char>(data[position + i])) << (8 * i));
+    }
+    position += sizeof(Unsigned);
+    return true;
+}
+
+// Every instruction by the name the listing gives it
+static std::unordered_map<std::string, AnalysisLevelInstruction> instructions_by_text() {
+    std::unordered_map<std::string, AnalysisLevelInstruction> instructions;
+    for (int inst = 0; inst <= SUB_PART_NAMED; ++inst) {
+        instructions.insert({AnalysisCommand::instruction_to_text(static_cast<AnalysisLevelInstruction>(inst)), static_cast<AnalysisLevelInstruction>(inst)});
+    }
+    return instructions;
+}
+
+ALILWriter::ALILWriter(std::ostream &in_out): out(in_out) {}
+
+void ALILWriter::write_text(const std::vector<AnalysisCommand> &commands) {
+
+    int top_size_of_dest = 0;
+    int top_size_of_inst = 0;
+
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        if (it->has_dest_argument()) {
+            top_size_of_dest = std::max(top_size_of_dest, static_cast<int>(it->get_dest_argument().size()));
+        }
+        top_size_of_inst = std::max(top_size_of_inst, static_cast<int>(AnalysisCommand::instruction_to_text(it->get_instruction()).size()));
+    }
+
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        it->print_instruction(out, top_size_of_dest+4, top_size_of_inst+1);
+    }
+}
+
+void ALILWriter::write_binary(const std::vector<AnalysisCommand> &commands) {
+
+    // Equal symbols have equal text, so each one need only be written once
+    std::unordered_map<Symbol, std::uint32_t> string_indices;
+    std::vector<Symbol> strings;
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        for (int pos = 0; pos < it->get_num_arguments(); ++pos) {
+            if (string_indices.insert({it->get_argument_symbol(pos), strings.size()}).second) strings.push_back(it->get_argument_symbol(pos));
+        }
+    }
+
+    out.write(alil_magic, sizeof(alil_magic));
+    write_little_endian<std::uint32_t>(out, ALIL_FORMAT_VERSION);
+
+    write_little_endian<std::uint32_t>(out, strings.size());
+    for (auto it = strings.begin(); it != strings.end(); ++it) {
+        const std::string &text = symbol_text(*it);
+        write_little_endian<std::uint32_t>(out, text.size());
+        out.write(text.data(), text.size());
+    }
+
+    write_little_endian<std::uint32_t>(out, commands.size());
+    for (auto it = commands.begin(); it != commands.end(); ++it) {
+        write_little_endian<std::uint16_t>(out, it->get_instruction());
+        write_little_endian<std::uint8_t>(out, it->get_num_arguments());
+        write_little_endian<std::uint8_t>(out, it->has_dest_argument());
+        write_little_endian<std::uint32_t>(out, it->get_source_location());
+        for (int pos = 0; pos < it->get_num_arguments(); ++pos) {
+            write_little_endian<std::uint32_t>(out, string_indices[it->get_argument_symbol(pos)]);
+        }
+    }
+
+    out.flush();
+}
+
+ALILReader::ALILReader(std::string_view in_data): data(in_data) {}
+
+std::vector<AnalysisCommand> ALILReader::read() {
+    if (data.substr(0, sizeof(alil_magic)) == std::string_view(alil_magic, sizeof(alil_magic))) return read_binary();
+    return read_text();
+}
+
+std::vector<AnalysisCommand> ALILReader::read_text() {
+    static const std::unordered_map<std::string, AnalysisLevelInstruction> instructions = instructions_by_text();
+
+    std::vector<AnalysisCommand> commands;
+
+    std::size_t line_start = 0;
+    int line_number = 0;
+    while (line_start < data.size()) {
+        std::size_t line_end = data.find('\n', line_start);
+        if (line_end == std::string_view::npos) line_end = data.size();
+
+        std::string_view line = data.substr(line_start, line_end - line_start);
+        line_start = line_end + 1;
+        line_number++;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.find_first_not_of(' ') == std::string_view::npos) continue;
+
+        std::string location = "line " + std::to_string(line_number);
+
+        // (destination) <- INSTRUCTION (source) (source) ..., with the destination and instruction padded to line up
+        std::size_t arrow = line.find(" <- ");
+        if (arrow == std::string_view::npos) raise_alil_reading_exception("expected \"(destination) <- INSTRUCTION (argument) ...\"", location);
+
+        std::string_view dest = line.substr(0, arrow);
+        while (!dest.empty() && dest.back() == ' ') dest.remove_suffix(1);
+        if (dest.size() < 2 || dest.front() != '(' || dest.back() != ')') raise_alil_reading_exception("the destination is not in parentheses", location);
+        dest = dest.substr(1, dest.size() - 2);
+
+        std::string_view rest = line.substr(arrow + 4);
+        std::size_t inst_end = std::min(rest.find(' '), rest.size());
+
+        auto found = instructions.find(std::string(rest.substr(0, inst_end)));
+        if (found == instructions.end()) raise_alil_reading_exception("unknown instruction \"" + std::string(rest.substr(0, inst_end)) + "\"", location);
+
+        AnalysisCommand command(found->second);
+        if (!dest.empty()) command.add_dest_argument(dest);
+
+        std::size_t position = std::min(rest.find_first_not_of(' ', inst_end), rest.size());
+        while (position < rest.size()) {
+            if (rest[position] != '(') raise_alil_reading_exception("expected an argument in parentheses", location);
+
+            // An argument ends at the first ')' that ends the line or is followed by the next argument
+            std::size_t close = position + 1;
+            while (true) {
+                close = rest.find(')', close);
+                if (close == std::string_view::npos) raise_alil_reading_exception("an argument is missing its closing parenthesis", location);
+                if (close + 1 == rest.size() || rest.substr(close + 1, 2) == " (") break;
+                close++;
+            }
+
+            command.add_source_argument(rest.substr(position + 1, close - position - 1));
+            position = close + 2;
+        }
+
+        commands.push_back(std::move(command));
+    }
+
+    return commands;
+}
+
+std::vector<AnalysisCommand> ALILReader::read_binary() {
+    std::size_t position = sizeof(alil_magic);
+
+    auto take = [&](auto &value, const std::string &location) {
+        if (!read_little_endian(data, position, value)) raise_alil_reading_exception("the file ends early", location);
+    };
+
+    std::uint32_t format_version;
+    take(format_version, "the header");
+    if (format_version != ALIL_FORMAT_VERSION) {
+        raise_alil_reading_exception("format version " + std::to_string(format_version) + " cannot be read, only " + std::to_string(ALIL_FORMAT_VERSION), "the header");
+    }
+
+    std::uint32_t string_count;
+    take(string_count, "the header");
+
+    // Counts are only trusted as far as the file could hold them
+    std::vector<Symbol> symbols;
+    symbols.reserve(std::min<std::size_t>(string_count, (data.size() - position) / sizeof(std::uint32_t)));
+    for (std::uint32_t i = 0; i < string_count; i++) {
+        std::string location = "argument text " + std::to_string(i + 1);
+
+        std::uint32_t size;
+        take(size, location);
+        if (data.size() - position < size) raise_alil_reading_exception("the file ends early", location);
+
+        symbols.push_back(intern_symbol(data.substr(position, size)));
+        position += size;
+    }
+
+    std::uint32_t command_count;
+    take(command_count, "the header");
+
+    std::vector<AnalysisCommand> commands;
+    commands.reserve(std::min<std::size_t>(command_count, (data.size() - position) / 8));
+    for (std::uint32_t i = 0; i < command_count; i++) {
+        std::string location = "command " + std::to_string(i + 1);
+
+        std::uint16_t inst;
+        std::uint8_t num_arguments;
+        std::uint8_t has_dest;
+        std::uint32_t source_location;
+        take(inst, location);
+        take(num_arguments, location);
+        take(has_dest, location);
+        take(source_location, location);
+
+        if (inst > SUB_PART_NAMED) raise_alil_reading_exception("unknown instruction " + std::to_string(inst), location);
+        if (has_dest > 1 || (has_dest && num_arguments == 0)) raise_alil_reading_exception("the destination flag is invalid", location);
+
+        AnalysisCommand command(static_cast<AnalysisLevelInstruction>(inst), source_location);
+        for (int pos = 0; pos < num_arguments; ++pos) {
+            std::uint32_t string;
+            take(string, location);
+            if (string >= symbols.size()) raise_alil_reading_exception("argument " + std::to_string(pos) + " refers to missing text", location);
+
+            if (pos == 0 && has_dest) command.add_dest_symbol(symbols[string]);
+            else command.add_source_symbol(symbols[string]);
+        }
+
+        commands.push_back(std::move(command));
+    }
+
+    if (position != data.size()) raise_alil_reading_exception("there is more data after the last command", "the end of the file");
+
+    return commands;
+}
@@ -0,0 +1,272 @@
+#include "ast_cache.hpp"
+#include "flat_ast.hpp"
+#include "parser.hpp"
+#include "source_buffer.hpp"
+#include "symbol_table.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+static const char cache_magic[8] = {'A', 'D', 'L', 'A', 'S', 'T', '\0', '\0'};
+
+/*
+Layout of a cache file, in host byte order:
+
+    Cache_header
+    uint32 size of each distinct lexeme      [string_count]
+    Cached_token                             [token_count]
+    Cached_node, in pre-order                [node_count]
+    the distinct lexemes, back to back       [string_bytes]
+
+Each distinct lexeme is stored, and interned on load, only once however many tokens share it.
+*/
+struct Cache_header {
+    char magic[8];
+    std::uint32_t format_version;
+    std::uint32_t parser_version;
+    std::uint64_t content_hash;
+    std::uint64_t content_size;
+    std::uint32_t string_count;
+    std::uint32_t token_count;
+    std::uint32_t node_count;
+    std::uint32_t reserved;
+    std::uint64_t string_bytes;
+};
+
+struct Cached_token {
+    std::uint32_t type;
+    std::int32_t line;
+    std::int32_t column;
+    std::uint32_t string;
+};
+
+struct Cached_node {
+    std::uint32_t type;
+    Token_index token;
+    std::uint32_t num_children;
+};
+
+// 64-bit FNV-1a
+static std::uint64_t hash_contents(std::string_view contents) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : contents) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// The name of a cache file also depends on the versions, so that trees from an older parser are never picked up
+static std::uint64_t hash_key(std::uint64_t content_hash) {
+    std::uint64_t hash = content_hash;
+    hash ^= (static_cast<std::uint64_t>(PARSER_VERSION) << 32) | AST_CACHE_FORMAT_VERSION;
+    return hash * 1099511628211ull;
+}
+
+ASTCache::ASTCache(std::string in_directory): directory(in_directory) {}
+
+std::string ASTCache::path_for(std::string_view contents) const {
+    return path_for_hash(hash_contents(contents));
+}
+
+std::string ASTCache::path_for_hash(std::uint64_t content_hash) const {
+    char name[21];
+    std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(hash_key(content_hash)));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool ASTCache::load(std::string_view contents, Tree &tree) const {
+    std::uint64_t content_hash = hash_contents(contents);
+
+    // Mapped rather than read, and only the lexemes are copied out of it
+    SourceBuffer file(path_for_hash(content_hash));
+    std::string_view data = file.get_contents();
+
+    std::size_t position = 0;
+    auto read = [&](void *out, std::size_t bytes) {
+        if (data.size() - position < bytes) return false;
+        std::memcpy(out, data.data() + position, bytes);
+        position += bytes;
+        return true;
+    };
+
+    Cache_header header;
+    if (!read(&header, sizeof(header))) return false;
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0) return false;
+    if (header.format_version != AST_CACHE_FORMAT_VERSION || header.parser_version != PARSER_VERSION) return false;
+    // The header repeats the content hash and size, so that a file whose name collides is not mistaken for a hit
+    if (header.content_hash != content_hash || header.content_size != contents.size()) return false;
+
+    std::uint64_t expected = sizeof(header) + std::uint64_t(header.string_count) * sizeof(std::uint32_t) + std::uint64_t(header.token_count) * sizeof(Cached_token)
+        + std::uint64_t(header.node_count) * sizeof(Cached_node) + header.string_bytes;
+    if (data.size() != expected || header.node_count == 0) return false;
+
+    // Check everything before building anything, so that a bad file leaves the tree as it was
+    std::vector<std::uint32_t> string_sizes(header.string_count);
+    read(string_sizes.data(), string_sizes.size() * sizeof(std::uint32_t));
+    std::uint64_t string_total = 0;
+    for (std::uint32_t size : string_sizes) string_total += size;
+    if (string_total != header.string_bytes) return false;
+
+    std::vector<Cached_token> cached_tokens(header.token_count);
+    read(cached_tokens.data(), cached_tokens.size() * sizeof(Cached_token));
+    for (const auto &tok : cached_tokens) {
+        if (tok.type >= NUM_TOKEN_TYPES || tok.string >= header.string_count) return false;
+    }
+
+    std::vector<Cached_node> cached_nodes(header.node_count);
+    read(cached_nodes.data(), cached_nodes.size() * sizeof(Cached_node));
+    // Children still owed to the nodes above the one being checked
+    std::vector<std::uint32_t> owed;
+    for (std::uint32_t i = 0; i < header.node_count; i++) {
+        const Cached_node &node = cached_nodes[i];
+        if (node.type >= NUM_AST_TYPES) return false;
+        if (node.token >= header.token_count && node.token != NO_TOKEN_INDEX && node.token != END_OF_FILE_INDEX) return false;
+
+        if (i == 0) {
+            if (node.type != INPUT || node.token != NO_TOKEN_INDEX) return false;
+        } else {
+            if (owed.empty()) return false;
+            if (--owed.back() == 0) owed.pop_back();
+        }
+        if (node.num_children > 0) owed.push_back(node.num_children);
+    }
+    if (!owed.empty()) return false;
+
+    auto tokens = std::make_shared<TokenArena>(nullptr);
+    std::string_view string_data = tokens->retain_line(std::string(data.substr(position)));
+
+    std::vector<std::string_view> strings(header.string_count);
+    std::vector<Symbol> symbols(header.string_count);
+    std::size_t string_start = 0;
+    for (std::uint32_t i = 0; i < header.string_count; i++) {
+        strings[i] = string_data.substr(string_start, string_sizes[i]);
+        symbols[i] = intern_symbol(strings[i]);
+        string_start += string_sizes[i];
+    }
+
+    tokens->reserve(header.token_count);
+    for (const auto &tok : cached_tokens) {
+        Token_type type = static_cast<Token_type>(tok.type);
+        switch (type) {
+            // Interned or not exactly as the lexer would have it
+            case LEXER_ERROR: case LEXER_NEWLINE: case LEXER_COMMENT: case LEXER_SPACE:
+                tokens->add(type, tok.line, tok.column, strings[tok.string], NO_SYMBOL);
+                break;
+            default:
+                tokens->add(type, tok.line, tok.column, strings[tok.string], symbols[tok.string]);
+                break;
+        }
+    }
+    tree.retain_tokens(tokens);
+
+    // Rebuild the tree in pre-order, with a stack of the nodes that are still waiting for children
+    std::vector<std::pair<PNode, std::uint32_t>> open;
+    if (cached_nodes[0].num_children > 0) open.push_back({tree.get_root(), cached_nodes[0].num_children});
+
+    for (std::uint32_t i = 1; i < header.node_count; i++) {
+        const Cached_node &cached = cached_nodes[i];
+        PNode parent = open.back().first;
+        if (--open.back().second == 0) open.pop_back();
+
+        PNode node;
+        if (cached.token == NO_TOKEN_INDEX) node = make_node(static_cast<AST_type>(cached.type), parent);
+        else if (cached.token == END_OF_FILE_INDEX) node = make_node(static_cast<AST_type>(cached.type), parent, TokenArena::end_of_file());
+        else node = make_node(static_cast<AST_type>(cached.type), parent, tokens->get(cached.token));
+        parent->add_child(node);
+
+        if (cached.num_children > 0) open.push_back({node, cached.num_children});
+    }
+
+    return true;
+}
+
+bool ASTCache::store(std::string_view contents, Tree &tree) const {
+    std::uint64_t content_hash = hash_contents(contents);
+    FlatAST ast = tree.flatten();
+
+    // Only the tokens the tree refers to are kept, renumbered in the order the tree first uses them
+    std::unordered_map<Token_index, Token_index> renumbered;
+    std::unordered_map<Symbol, std::uint32_t> string_indices;
+    std::vector<std::uint32_t> string_sizes;
+    std::string string_data;
+    std::vector<Cached_token> cached_tokens;
+    std::vector<Cached_node> cached_nodes(ast.size());
+
+    for (Flat_index i = 0; i < ast.size(); i++) {
+        Cached_node &node = cached_nodes[i];
+        node.type = ast.get_ast_type(i);
+        node.num_children = ast.get_num_children(i);
+        node.token = ast.get_token_index(i);
+
+        if (node.token == NO_TOKEN_INDEX || node.token == END_OF_FILE_INDEX) continue;
+
+        auto found = renumbered.find(node.token);
+        if (found == renumbered.end()) {
+            PToken tok = ast.get_token(i);
+            found = renumbered.insert({node.token, static_cast<Token_index>(cached_tokens.size())}).first;
+
+            // Equal symbols have equal text, so each one need only be written once
+            std::uint32_t string = string_sizes.size();
+            auto interned = tok->get_symbol() == NO_SYMBOL ? string_indices.end() : string_indices.find(tok->get_symbol());
+            if (interned != string_indices.end()) {
+                string = interned->second;
+            } else {
+                std::string_view lexeme = tok->get_lexeme_view();
+                if (tok->get_symbol() != NO_SYMBOL) string_indices.insert({tok->get_symbol(), string});
+                string_sizes.push_back(lexeme.size());
+                string_data.append(lexeme);
+            }
+
+            cached_tokens.push_back({static_cast<std::uint32_t>(tok->get_token_type()), tok->get_line(), tok->get_column(), string});
+        }
+        node.token = found->second;
+    }
+
+    Cache_header header;
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.format_version = AST_CACHE_FORMAT_VERSION;
+    header.parser_version = PARSER_VERSION;
+    header.content_hash = content_hash;
+    header.content_size = contents.size();
+    header.string_count = string_sizes.size();
+    header.token_count = cached_tokens.size();
+    header.node_count = cached_nodes.size();
+    header.reserved = 0;
+    header.string_bytes = string_data.size();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) return false;
+
+    // Write under a name of our own and rename it into place, so that concurrent jobs never see half a file
+    std::string path = path_for_hash(content_hash);
+    std::string temporary = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(string_sizes.data()), string_sizes.size() * sizeof(std::uint32_t));
+        out.write(reinterpret_cast<const char *>(cached_tokens.data()), cached_tokens.size() * sizeof(Cached_token));
+        out.write(reinterpret_cast<const char *>(cached_nodes.data()), cached_nodes.size() * sizeof(Cached_node));
+        out.write(string_data.data(), string_data.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
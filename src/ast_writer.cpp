@@ -0,0 +1,160 @@
+#include "ast_writer.hpp"
+#include "lexer.hpp"
+#include "tokens.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+static const char dump_magic[8] = {'A', 'D', 'L', 'D', 'U', 'M', 'P', '\0'};
+
+// Marks a node without a token in a binary dump
+constexpr std::uint16_t NO_TOKEN_TYPE = 0xffff;
+
+/*
+Pre-order walk with an explicit stack of (node, parent id) pairs, calling visit(node, id, parent id) on each node.
+Children are pushed in reverse so that they come off the stack, and so are numbered, in order.
+*/
+template <typename Visit>
+static void walk_pre_order(PNode root, Visit visit) {
+    std::vector<std::pair<PNode, std::uint32_t>> pending = {{root, 0}};
+    std::uint32_t next_id = 1;
+
+    while (!pending.empty()) {
+        auto [node, parent] = pending.back();
+        pending.pop_back();
+
+        std::uint32_t id = next_id++;
+        visit(node, id, parent);
+
+        auto &children = node->get_children();
+        for (auto it = children.end(); it != children.begin(); ) {
+            --it;
+            pending.push_back({*it, id});
+        }
+    }
+}
+
+// The printable names of every AST and token type, worked out once per dump rather than once per node
+static std::vector<std::string> ast_type_names() {
+    std::vector<std::string> names;
+    for (std::size_t type = 0; type < NUM_AST_TYPES; ++type) names.push_back(AST_type_to_string(static_cast<AST_type>(type)));
+    return names;
+}
+
+static std::vector<std::string> token_type_names() {
+    std::vector<std::string> names;
+    for (std::size_t type = 0; type < NUM_TOKEN_TYPES; ++type) names.push_back(token_type_to_string(static_cast<Token_type>(type)));
+    return names;
+}
+
+// Write text as the body of a JSON string
+static void write_json_escaped(std::ostream &out, std::string_view text) {
+    static const char hex_digits[] = "0123456789abcdef";
+
+    std::size_t run_start = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = text[i];
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+
+        out.write(text.data() + run_start, i - run_start);
+        run_start = i + 1;
+
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                out << "\\u00" << hex_digits[c >> 4] << hex_digits[c & 0xf];
+                break;
+        }
+    }
+    out.write(text.data() + run_start, text.size() - run_start);
+}
+
+template <typename Unsigned>
+static void write_little_endian(std::ostream &out, Unsigned value) {
+    char bytes[sizeof(Unsigned)];
+    for (std::size_t i = 0; i < sizeof(Unsigned); ++i) bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    out.write(bytes, sizeof(Unsigned));
+}
+
+ASTWriter::ASTWriter(std::ostream &in_out): out(in_out) {}
+
+void ASTWriter::write_dot(PNode root) {
+    std::vector<std::string> type_names = ast_type_names();
+
+    out << "digraph G {\n";
+
+    walk_pre_order(root, [&](PNode node, std::uint32_t id, std::uint32_t parent) {
+        if (parent != 0) out << "    " << parent << " -> " << id << '\n';
+
+        out << "    " << id << " [label=\"";
+        if (node->has_token()) {
+            // Quotes would end the label early, so they are left out
+            std::string_view lexeme = node->get_token()->get_lexeme_view();
+            for (std::size_t start = 0; start < lexeme.size(); ) {
+                std::size_t quote = lexeme.find('"', start);
+                if (quote == std::string_view::npos) quote = lexeme.size();
+                out.write(lexeme.data() + start, quote - start);
+                start = quote + 1;
+            }
+        } else {
+            out << "ID:" << type_names[node->get_ast_type()];
+        }
+        out << "\"]\n";
+    });
+
+    out << "}" << std::endl;
+}
+
+void ASTWriter::write_json_lines(PNode root) {
+    std::vector<std::string> type_names = ast_type_names();
+    std::vector<std::string> token_names = token_type_names();
+
+    walk_pre_order(root, [&](PNode node, std::uint32_t id, std::uint32_t parent) {
+        out << "{\"id\":" << id << ",\"parent\":" << parent << ",\"type\":\"" << type_names[node->get_ast_type()] << "\",\"children\":" << node->get_children().size();
+
+        if (node->has_token()) {
+            PToken tok = node->get_token();
+            out << ",\"token\":\"" << token_names[tok->get_token_type()] << "\",\"lexeme\":\"";
+            write_json_escaped(out, tok->get_lexeme_view());
+            out << "\",\"line\":" << tok->get_line() << ",\"column\":" << tok->get_column();
+        }
+
+        out << "}\n";
+    });
+
+    out.flush();
+}
+
+void ASTWriter::write_binary(PNode root) {
+    out.write(dump_magic, sizeof(dump_magic));
+    write_little_endian<std::uint32_t>(out, AST_DUMP_FORMAT_VERSION);
+
+    walk_pre_order(root, [&](PNode node, std::uint32_t, std::uint32_t parent) {
+        write_little_endian<std::uint32_t>(out, parent);
+        write_little_endian<std::uint16_t>(out, node->get_ast_type());
+
+        if (!node->has_token()) {
+            write_little_endian<std::uint16_t>(out, NO_TOKEN_TYPE);
+            write_little_endian<std::uint32_t>(out, node->get_children().size());
+            return;
+        }
+
+        PToken tok = node->get_token();
+        std::string_view lexeme = tok->get_lexeme_view();
+
+        write_little_endian<std::uint16_t>(out, tok->get_token_type());
+        write_little_endian<std::uint32_t>(out, node->get_children().size());
+        write_little_endian<std::uint32_t>(out, static_cast<std::uint32_t>(tok->get_line()));
+        write_little_endian<std::uint32_t>(out, static_cast<std::uint32_t>(tok->get_column()));
+        write_little_endian<std::uint32_t>(out, lexeme.size());
+        out.write(lexeme.data(), lexeme.size());
+    });
+
+    out.flush();
+}
@@ -0,0 +1,137 @@
+#include "char_scan.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define CHAR_SCAN_X86
+#include <immintrin.h>
+#endif
+
+/*
+Run skipping
+---
+
+Most of a line is made of identifier runs and whitespace runs, inside which the lexer does nothing but move on.
+These find the end of such a run 16 or 32 bytes at a time. Each byte is range-checked with a wrapping subtraction
+followed by an unsigned saturating one, which leaves zero exactly for the bytes within the range.
+Whatever is left over at the end of the line is finished one byte at a time through the char_kinds table.
+
+*/
+
+namespace {
+
+std::size_t skip_run_scalar(const char *text, std::size_t pos, std::size_t length, Char_kind kind) {
+    while (pos < length && has_char_kind(text[pos], kind)) pos++;
+    return pos;
+}
+
+#ifdef CHAR_SCAN_X86
+
+// 0xFF in every byte of chunk that lies in [low, low + span]
+inline __m128i in_range_sse2(__m128i chunk, char low, char span) {
+    __m128i offset = _mm_sub_epi8(chunk, _mm_set1_epi8(low));
+    return _mm_cmpeq_epi8(_mm_subs_epu8(offset, _mm_set1_epi8(span)), _mm_setzero_si128());
+}
+
+inline __m128i identifier_mask_sse2(__m128i chunk) {
+    __m128i lowercased = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i mask = in_range_sse2(lowercased, 'a', 'z' - 'a');
+    mask = _mm_or_si128(mask, in_range_sse2(chunk, '0', '9' - '0'));
+    return _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+}
+
+inline __m128i space_mask_sse2(__m128i chunk) {
+    __m128i mask = in_range_sse2(chunk, '\t', '\r' - '\t');
+    return _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+}
+
+template <__m128i (*Mask)(__m128i)>
+std::size_t skip_run_sse2(const char *text, std::size_t pos, std::size_t length) {
+    while (pos + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+        unsigned outside = ~static_cast<unsigned>(_mm_movemask_epi8(Mask(chunk))) & 0xFFFF;
+        if (outside != 0) return pos + __builtin_ctz(outside);
+        pos += 16;
+    }
+    return pos;
+}
+
+__attribute__((target("avx2"))) inline __m256i in_range_avx2(__m256i chunk, char low, char span) {
+    __m256i offset = _mm256_sub_epi8(chunk, _mm256_set1_epi8(low));
+    return _mm256_cmpeq_epi8(_mm256_subs_epu8(offset, _mm256_set1_epi8(span)), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) inline __m256i identifier_mask_avx2(__m256i chunk) {
+    __m256i lowercased = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i mask = in_range_avx2(lowercased, 'a', 'z' - 'a');
+    mask = _mm256_or_si256(mask, in_range_avx2(chunk, '0', '9' - '0'));
+    return _mm256_or_si256(mask, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+}
+
+__attribute__((target("avx2"))) inline __m256i space_mask_avx2(__m256i chunk) {
+    __m256i mask = in_range_avx2(chunk, '\t', '\r' - '\t');
+    return _mm256_or_si256(mask, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')));
+}
+
+template <__m256i (*Mask)(__m256i)>
+__attribute__((target("avx2"))) std::size_t skip_run_avx2(const char *text, std::size_t pos, std::size_t length) {
+    while (pos + 32 <= length) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+        unsigned outside = ~static_cast<unsigned>(_mm256_movemask_epi8(Mask(chunk)));
+        if (outside != 0) return pos + __builtin_ctz(outside);
+        pos += 32;
+    }
+    return pos;
+}
+
+#endif
+
+Vector_width detect_vector_width() {
+#ifdef CHAR_SCAN_X86
+    if (__builtin_cpu_supports("avx2")) return VECTOR_AVX2;
+    return VECTOR_SSE2;
+#else
+    return VECTOR_NONE;
+#endif
+}
+
+/*
+Runs in ADL are mostly shorter than 32 bytes, so the AVX2 loop seldom gets through a whole chunk before handing over to
+the SSE2 one, and only adds a call that cannot be inlined. bench_char_scan finds no gain from it beyond run-to-run noise,
+and a loss on some machines, so SSE2 is used unless AVX2 is asked for.
+*/
+Vector_width default_vector_width() {
+    Vector_width supported = detect_vector_width();
+    return supported < VECTOR_SSE2 ? supported : VECTOR_SSE2;
+}
+
+Vector_width current_vector_width = default_vector_width();
+
+}
+
+Vector_width get_supported_vector_width() {
+    return detect_vector_width();
+}
+
+Vector_width get_vector_width() {
+    return current_vector_width;
+}
+
+void set_vector_width(Vector_width width) {
+    // Never go wider than the CPU can actually run
+    current_vector_width = width < get_supported_vector_width() ? width : get_supported_vector_width();
+}
+
+std::size_t skip_identifier_run(const char *text, std::size_t pos, std::size_t length) {
+#ifdef CHAR_SCAN_X86
+    if (current_vector_width == VECTOR_AVX2) pos = skip_run_avx2<identifier_mask_avx2>(text, pos, length);
+    if (current_vector_width != VECTOR_NONE) pos = skip_run_sse2<identifier_mask_sse2>(text, pos, length);
+#endif
+    return skip_run_scalar(text, pos, length, CK_IDENTIFIER);
+}
+
+std::size_t skip_space_run(const char *text, std::size_t pos, std::size_t length) {
+#ifdef CHAR_SCAN_X86
+    if (current_vector_width == VECTOR_AVX2) pos = skip_run_avx2<space_mask_avx2>(text, pos, length);
+    if (current_vector_width != VECTOR_NONE) pos = skip_run_sse2<space_mask_sse2>(text, pos, length);
+#endif
+    return skip_run_scalar(text, pos, length, CK_SPACE);
+}
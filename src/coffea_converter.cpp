@@ -7,7 +7,7 @@
 #include <string>
 
 
-std::string CoffeaConverter::handle_union_empty(AnalysisCommand command) {
+std::string CoffeaConverter::handle_union_empty(const AnalysisCommand &command) {
     std::stringstream command_text;
 
     std::string dest_vec = command.get_argument(0);
@@ -17,7 +17,7 @@ std::string CoffeaConverter::handle_union_empty(AnalysisCommand command) {
 }
 
 
-std::string CoffeaConverter::handle_union_merge(AnalysisCommand command, std::string adding_name) {
+std::string CoffeaConverter::handle_union_merge(const AnalysisCommand &command, std::string adding_name) {
     std::stringstream command_text;
 
     std::string dest_vec = command.get_argument(0);
@@ -50,7 +50,7 @@ std::string CoffeaConverter::existing_definitions_string() {
 /**
     Adds an index tag to a particle, as NanoAOD handles 4-vector indices in this way
 */
-std::string CoffeaConverter::index_particle(AnalysisCommand command, bool is_named, std::string part_text) {
+std::string CoffeaConverter::index_particle(const AnalysisCommand &command, bool is_named, std::string part_text) {
     if (command.get_num_arguments() - is_named >= 4) {
         std::stringstream idx_text;
         idx_text << part_text << "[" << command.get_argument(2+is_named) << ":" << command.get_argument(3+is_named) << "]";
@@ -65,30 +65,30 @@ std::string CoffeaConverter::index_particle(AnalysisCommand command, bool is_nam
     }
 }
 
-void CoffeaConverter::add_particle(AnalysisCommand command, std::string name) {
+void CoffeaConverter::add_particle(const AnalysisCommand &command, std::string name) {
     bool is_named = false;
     if (command.get_instruction() == ADD_PART_NAMED) is_named = true;
     std::stringstream command_text;
 
     std::string indexed_if_needed = index_particle(command, is_named, name);
 
-    command_text << var_mappings[command.get_argument(1+is_named)] << (var_mappings[command.get_argument(1+is_named)] != "" ? " + " : "") << indexed_if_needed;
-    var_mappings[command.get_argument(0)] = command_text.str();
+    command_text << var_mappings[command.get_argument_symbol(1+is_named)] << (var_mappings[command.get_argument_symbol(1+is_named)] != "" ? " + " : "") << indexed_if_needed;
+    var_mappings[command.get_argument_symbol(0)] = command_text.str();
 }  
 
-void CoffeaConverter::sub_particle(AnalysisCommand command, std::string name) {
+void CoffeaConverter::sub_particle(const AnalysisCommand &command, std::string name) {
     bool is_named = false;
     if (command.get_instruction() == ADD_PART_NAMED) is_named = true;
     std::stringstream command_text;
 
     std::string indexed_if_needed = index_particle(command, is_named, name);
-    command_text << var_mappings[command.get_argument(1+is_named)] << " - " << indexed_if_needed;
+    command_text << var_mappings[command.get_argument_symbol(1+is_named)] << " - " << indexed_if_needed;
 }
 
-void CoffeaConverter::append_4vector_label(AnalysisCommand command, std::string suffix) {
+void CoffeaConverter::append_4vector_label(const AnalysisCommand &command, std::string suffix) {
 
-    std::string output = command.get_argument(0);
-    std::string input = var_mappings[command.get_argument(1)];
+    Symbol output = command.get_argument_symbol(0);
+    std::string input = var_mappings[command.get_argument_symbol(1)];
 
     std::stringstream command_text;
     command_text << input << "." << suffix;
@@ -98,13 +98,13 @@ void CoffeaConverter::append_4vector_label(AnalysisCommand command, std::string
 
 }
 
-std::string CoffeaConverter::binary_command(AnalysisCommand command, std::string op) {
+std::string CoffeaConverter::binary_command(const AnalysisCommand &command, std::string op) {
     std::stringstream text;
-    text << var_mappings[command.get_argument(1)] << op << var_mappings[command.get_argument(2)];
+    text << var_mappings[command.get_argument_symbol(1)] << op << var_mappings[command.get_argument_symbol(2)];
     return text.str();
 }
 
-std::string CoffeaConverter::command_convert(AnalysisCommand command) {
+std::string CoffeaConverter::command_convert(const AnalysisCommand &command) {
 
     AnalysisLevelInstruction inst = command.get_instruction();
     std::stringstream command_text;
@@ -115,92 +115,92 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
             command_text << "# making histogram " << command.get_argument(1) << "\n";
             command_text << "\n_histogram" << command.get_argument(0) << " = Hist(axis.Regular(";
             for (int i = 2; i < 5; i++) {
-                command_text << var_mappings[command.get_argument(i)] << ",";
+                command_text << var_mappings[command.get_argument_symbol(i)] << ",";
             }
             command_text << "name='dim1'))";
-            command_text << "\n_histogram" << command.get_argument(0) << ".fill(dim1=" << var_mappings[command.get_argument(5)] << ")";
+            command_text << "\n_histogram" << command.get_argument(0) << ".fill(dim1=" << var_mappings[command.get_argument_symbol(5)] << ")";
             return command_text.str();
         case HIST_2D:
             command_text << "# making histogram " << command.get_argument(1) << "\n";
             command_text << "\n_histogram" << command.get_argument(0) << " = Hist(axes=(axis.Regular(";
             for (int i = 2; i < 5; i++) {
-                command_text << var_mappings[command.get_argument(i)] << ",";
+                command_text << var_mappings[command.get_argument_symbol(i)] << ",";
             }
             command_text << "name='dim1'), axis.Regular(";
             for (int i = 6; i < 9; i++) {
-                command_text << var_mappings[command.get_argument(i)] << ", ";
+                command_text << var_mappings[command.get_argument_symbol(i)] << ", ";
             }
             command_text << "name='dim2')))";
-            command_text << "\n_histogram" << command.get_argument(0) << ".fill(dim1=" << var_mappings[command.get_argument(5)] << ", ";
-            command_text << "dim2=" << var_mappings[command.get_argument(9)] << ")";
+            command_text << "\n_histogram" << command.get_argument(0) << ".fill(dim1=" << var_mappings[command.get_argument_symbol(5)] << ", ";
+            command_text << "dim2=" << var_mappings[command.get_argument_symbol(9)] << ")";
             return command_text.str();      
         case USE_HIST:
             
             return "";
         case CREATE_HIST_LIST:
             command_text << "\n_histogram_list" << command.get_argument(0) << " = []";
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();
         case ADD_HIST_TO_LIST:
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
-            command_text << "\n_histogram_list" << var_mappings[command.get_argument(1)] << ".append(_histogram" << command.get_argument(2) << ")";
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
+            command_text << "\n_histogram_list" << var_mappings[command.get_argument_symbol(1)] << ".append(_histogram" << command.get_argument(2) << ")";
             return command_text.str();
         case USE_HIST_LIST: //TODO: change
-            command_text << "\nuse_histo_list(_histogram_list" << var_mappings[command.get_argument(0)] << ", _histogram_node_" << command.get_argument(1) << ")";
+            command_text << "\nuse_histo_list(_histogram_list" << var_mappings[command.get_argument_symbol(0)] << ", _histogram_node_" << command.get_argument(1) << ")";
             return command_text.str();
 
         case CREATE_REGION:
             command_text << command.get_argument(0) << " = (events == 0) | (events != 0) \n";
 
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();
         case MERGE_REGIONS:
-            // command_text << "_groups" << var_mappings[command.get_argument(2)] << " = combine_without_duplicates(_groups" << var_mappings[command.get_argument(1)] << ", _groups" << var_mappings[command.get_argument(2)] << ")\n";
-            command_text << var_mappings[command.get_argument(2)] << " = " << var_mappings[command.get_argument(2)] << " & " << var_mappings[command.get_argument(1)] << "\n";
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(2)];
+            // command_text << "_groups" << var_mappings[command.get_argument_symbol(2)] << " = combine_without_duplicates(_groups" << var_mappings[command.get_argument_symbol(1)] << ", _groups" << var_mappings[command.get_argument_symbol(2)] << ")\n";
+            command_text << var_mappings[command.get_argument_symbol(2)] << " = " << var_mappings[command.get_argument_symbol(2)] << " & " << var_mappings[command.get_argument_symbol(1)] << "\n";
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(2)];
             return command_text.str();
         case CUT_REGION:
-            command_text << var_mappings[command.get_argument(1)] << " = "<< var_mappings[command.get_argument(1)] << " & " << var_mappings[command.get_argument(2)] << ""; 
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            command_text << var_mappings[command.get_argument_symbol(1)] << " = "<< var_mappings[command.get_argument_symbol(1)] << " & " << var_mappings[command.get_argument_symbol(2)] << ""; 
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_ALIAS:
         {
-            if (var_mappings.count(command.get_argument(1)) == 0) var_mappings[command.get_argument(1)] = command.get_argument(1);
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            if (var_mappings.count(command.get_argument_symbol(1)) == 0) var_mappings[command.get_argument_symbol(1)] = command.get_argument(1);
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return "";
         }
         case ADD_EXTERNAL:
         {
             std::string fn_name_with_quotes = command.get_argument(1);
             std::string fn_name_wo_quotes = fn_name_with_quotes.substr(1,fn_name_with_quotes.size()-2);
-            var_mappings[command.get_argument(0)] = fn_name_wo_quotes;
+            var_mappings[command.get_argument_symbol(0)] = fn_name_wo_quotes;
             return "";
         }
         case CREATE_MASK:
         {
-            command_text << "\n" << command.get_argument(0) << " = ak.Array(np.empty((ak.num(" << var_mappings[command.get_argument(1)] << ", axis=1))))\n"; 
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            command_text << "\n" << command.get_argument(0) << " = ak.Array(np.empty((ak.num(" << var_mappings[command.get_argument_symbol(1)] << ", axis=1))))\n"; 
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
 
             existing_definitions.push_back(command.get_argument(0));
             return command_text.str();
         }
         case LIMIT_MASK:
         {   
-            command_text << var_mappings[command.get_argument(1)] << " = " << var_mappings[command.get_argument(1)] << " & " << var_mappings[command.get_argument(2)] << "";
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            command_text << var_mappings[command.get_argument_symbol(1)] << " = " << var_mappings[command.get_argument_symbol(1)] << " & " << var_mappings[command.get_argument_symbol(2)] << "";
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         }
         case APPLY_MASK:
         {
-            command_text << command.get_argument(0) << " = " << var_mappings[command.get_argument(2)] << "[" << var_mappings[command.get_argument(1)] << "] \n";
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            command_text << command.get_argument(0) << " = " << var_mappings[command.get_argument_symbol(2)] << "[" << var_mappings[command.get_argument_symbol(1)] << "] \n";
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();
         }
         case BEGIN_EXPRESSION:
             return "";
         case END_EXPRESSION:
         {
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return "";
         }
             return "END_EXPRESSION";
@@ -209,72 +209,72 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
         case END_IF:
             return "END_IF";
         case EXPR_RAISE:
-            var_mappings[command.get_argument(0)] = binary_command(command, "**");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "**");
             return "";
         case EXPR_MULTIPLY:
-            var_mappings[command.get_argument(0)] = binary_command(command, "*");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "*");
             return "";
         case EXPR_DIVIDE:
-            var_mappings[command.get_argument(0)] = binary_command(command, "/");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "/");
             return "";
         case EXPR_ADD:
-            var_mappings[command.get_argument(0)] = binary_command(command, "+");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "+");
             return "";
         case EXPR_SUBTRACT:
-            var_mappings[command.get_argument(0)] = binary_command(command, "-");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "-");
             return "";
         case EXPR_LT:
-            var_mappings[command.get_argument(0)] = binary_command(command, "<");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "<");
             return "";
         case EXPR_LE:
-            var_mappings[command.get_argument(0)] = binary_command(command, "<=");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "<=");
             return "";
         case EXPR_GT:
-            var_mappings[command.get_argument(0)] = binary_command(command, ">");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, ">");
             return "";
         case EXPR_GE:
-            var_mappings[command.get_argument(0)] = binary_command(command, ">=");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, ">=");
             return "";
         case EXPR_EQ:
-            var_mappings[command.get_argument(0)] = binary_command(command, "==");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "==");
             return "";
         case EXPR_NE:
-            var_mappings[command.get_argument(0)] = binary_command(command, "!=");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "!=");
             return "";
         case EXPR_AMPERSAND:
-            var_mappings[command.get_argument(0)] = binary_command(command, "&");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "&");
             return "";
         case EXPR_PIPE:
-            var_mappings[command.get_argument(0)] = binary_command(command, "|");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "|");
             return "";
         case EXPR_AND:
-            var_mappings[command.get_argument(0)] = binary_command(command, "&&");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "&&");
             return "";
         case EXPR_OR:
-            var_mappings[command.get_argument(0)] = binary_command(command, "||");
+            var_mappings[command.get_argument_symbol(0)] = binary_command(command, "||");
             return "";
         case EXPR_WITHIN:
-            command_text << "((" << var_mappings[command.get_argument(1)] << ">=" << var_mappings[command.get_argument(2)] << ")&&(" << var_mappings[command.get_argument(1)] << "<=" << var_mappings[command.get_argument(3)] << "))";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "((" << var_mappings[command.get_argument_symbol(1)] << ">=" << var_mappings[command.get_argument_symbol(2)] << ")&&(" << var_mappings[command.get_argument_symbol(1)] << "<=" << var_mappings[command.get_argument_symbol(3)] << "))";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case EXPR_OUTSIDE:
-            command_text << "((" << var_mappings[command.get_argument(1)] << "<=" << var_mappings[command.get_argument(2)] << ")||(" << var_mappings[command.get_argument(1)] << ">=" << var_mappings[command.get_argument(3)] << "))";
-            var_mappings[command.get_argument(0)] = command_text.str();           
+            command_text << "((" << var_mappings[command.get_argument_symbol(1)] << "<=" << var_mappings[command.get_argument_symbol(2)] << ")||(" << var_mappings[command.get_argument_symbol(1)] << ">=" << var_mappings[command.get_argument_symbol(3)] << "))";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();           
             return "";
         case EXPR_NEGATE:
-            command_text << "-(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "-(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case EXPR_LOGICAL_NOT:
-            command_text << "!(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "!(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
 
         case FUNC_BTAG:
         {
             append_4vector_label(command, "btagDeepFlavB");
-            command_text << "(" << var_mappings[command.get_argument(0)] << " > 0.3040)";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "(" << var_mappings[command.get_argument_symbol(0)] << " > 0.3040)";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         }
         case FUNC_PT:
@@ -310,7 +310,7 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
 
         case MAKE_EMPTY_PARTICLE:
         {
-            var_mappings[command.get_argument(0)] = "";
+            var_mappings[command.get_argument_symbol(0)] = "";
             return "";
         }
         case ADD_PART_ELECTRON:
@@ -344,8 +344,8 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
             add_particle(command, "FatJet");
             return "";
         case ADD_PART_NAMED:
-            if (var_mappings.count(command.get_argument(1)) == 0) var_mappings[command.get_argument(1)] = command.get_argument(1);
-            add_particle(command, var_mappings[command.get_argument(1)]);
+            if (var_mappings.count(command.get_argument_symbol(1)) == 0) var_mappings[command.get_argument_symbol(1)] = command.get_argument(1);
+            add_particle(command, var_mappings[command.get_argument_symbol(1)]);
             return "";
         case SUB_PART_ELECTRON:
             sub_particle(command, "Electron");
@@ -386,44 +386,44 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
             raise_non_implemented_conversion_exception("FUNC_ALLOF");
             return "FUNC_ALLOF";
         case FUNC_SQRT:
-            command_text << "sqrt(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "sqrt(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_ABS:
-            command_text << "abs(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "abs(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_COS:
-            command_text << "cos(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "cos(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_SIN:
-            command_text << "sin(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "sin(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_TAN:
-            command_text << "tan(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "tan(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_SINH:
-            command_text << "sinh(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "sinh(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_COSH:
-            command_text << "cosh(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "cosh(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_TANH:
-            command_text << "tanh(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "tanh(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_EXP:
-            command_text << "exp(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "exp(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_LOG:
-            command_text << "log(" << var_mappings[command.get_argument(1)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "log(" << var_mappings[command.get_argument_symbol(1)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_AVE:
             raise_non_implemented_conversion_exception("FUNC_AVE");
@@ -435,53 +435,53 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
             raise_non_implemented_conversion_exception("FUNC_NAMED");
             return "FUNC_NAMED";
         case MAKE_EMPTY_UNION:
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             command_text << handle_union_empty(command);
             existing_definitions.push_back(command.get_argument(0));
             return command_text.str();        
         case ADD_NAMED_TO_UNION:
-            command_text << handle_union_merge(command, var_mappings[command.get_argument(2)]);
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            command_text << handle_union_merge(command, var_mappings[command.get_argument_symbol(2)]);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();        
         case ADD_ELECTRON_TO_UNION:
             command_text << handle_union_merge(command, "Electron");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_MUON_TO_UNION:
             command_text << handle_union_merge(command, "Muon");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_TAU_TO_UNION:
             command_text << handle_union_merge(command, "Tau");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_TRACK_TO_UNION:
             command_text << handle_union_merge(command, "IsoTrack");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_PHOTON_TO_UNION:
             command_text << handle_union_merge(command, "Photon");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_QGJET_TO_UNION:
             command_text << handle_union_merge(command, "QGJet");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_METLV_TO_UNION:
             command_text << handle_union_merge(command, "METLV");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_GEN_TO_UNION:
             command_text << handle_union_merge(command, "GenPart");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_JET_TO_UNION:
             command_text << handle_union_merge(command, "Jet");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case ADD_FJET_TO_UNION:
             command_text << handle_union_merge(command, "FatJet");
-            var_mappings[command.get_argument(0)] = var_mappings[command.get_argument(1)];
+            var_mappings[command.get_argument_symbol(0)] = var_mappings[command.get_argument_symbol(1)];
             return command_text.str();
         case FUNC_FLAVOR:
             append_4vector_label(command, "partonFlavor");
@@ -526,8 +526,8 @@ std::string CoffeaConverter::command_convert(AnalysisCommand command) {
             raise_non_implemented_conversion_exception("FUNC_DETA");
             return "FUNC_DETA";
         case FUNC_SIZE:
-            command_text << "ak.num(" << var_mappings[command.get_argument(1)] << ", axis=1)";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "ak.num(" << var_mappings[command.get_argument_symbol(1)] << ", axis=1)";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         default:
             std::stringstream error;
@@ -544,7 +544,7 @@ void CoffeaConverter::initialize_all_particles() {
     for (auto it = part_names.begin(); it != part_names.end(); ++it) {
         std::stringstream ss;
         ss << "events." << *it;
-        var_mappings[*it] = ss.str();
+        var_mappings[intern_symbol(*it)] = ss.str();
     }
 
 }
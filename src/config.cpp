@@ -12,7 +12,13 @@ Config::Config(std::string filename): default_entries({
         {"MET", "PuppiMET"}, 
         {"infile", "infile.root"},
         {"cutflow", "all"},
-        {"eventlist", "none"}
+        {"eventlist", "none"},
+        {"astcache", "none"},
+        {"parsethreads", "1"},
+        {"sharedexpressions", "off"},
+        {"alilthreads", "1"},
+        {"cse", "off"},
+        {"fold", "off"}
     }) {
     read_config_file(filename);
 }
@@ -70,6 +76,12 @@ void Config::read_config_file(std::string filename) {
 
 }
 
+// Entries missing from an older config file take their default
 std::string Config::get_argument(std::string in) {
-    return config_entries[in];
+    auto found = config_entries.find(in);
+    if (found != config_entries.end()) return found->second;
+
+    auto fallback = default_entries.find(in);
+    if (fallback != default_entries.end()) return fallback->second;
+    return "";
 }
@@ -1,4 +1,5 @@
 #include "exceptions.hpp"
+#include <sstream>
 
 void raise_lexing_exception(PToken token) {
     std::stringstream stream;
@@ -7,6 +8,13 @@ void raise_lexing_exception(PToken token) {
     throw LexingException(stream.str().c_str());
 }
 
+void raise_editing_exception(std::string error) {
+    std::stringstream stream;
+    stream << "Failed to edit the input: " << error << std::endl;
+
+    throw LexingException(stream.str().c_str());
+}
+
 void raise_parsing_exception(std::string error, PToken token) {
     std::stringstream stream;
     stream << "Failed to parse \"" << token->get_lexeme() << "\", at line " << token->get_line() << ", column " << token->get_column() << ": " << error << std::endl;
@@ -31,4 +39,11 @@ void raise_non_implemented_conversion_exception(std::string inst, std::string co
     }
 
     throw AnalysisLevelConversionException(stream.str().c_str());
+}
+
+void raise_alil_reading_exception(std::string error, std::string location) {
+    std::stringstream stream;
+    stream << "Failed to read ALIL, at " << location << ": " << error << std::endl;
+
+    throw ALILReadingException(stream.str().c_str());
 }
\ No newline at end of file
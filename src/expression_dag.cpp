@@ -0,0 +1,132 @@
+#include "expression_dag.hpp"
+
+#include <cassert>
+#include <utility>
+
+// Mix one more word into a hash, boost::hash_combine style but 64 bits wide
+static std::uint64_t mix(std::uint64_t hash, std::uint64_t value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
+ExpressionDAG::ExpressionDAG(const FlatAST &ast): ids(ast.size(), NO_EXPR_ID), occurrences(0) {
+
+    // Whether each node is an EXPRESSION or CONDITION or lies within one; a parent always comes before its children
+    std::vector<bool> in_expression(ast.size(), false);
+    for (Flat_index node = 0; node < ast.size(); ++node) {
+        AST_type type = ast.get_ast_type(node);
+        Flat_index parent = ast.get_parent(node);
+        in_expression[node] = type == EXPRESSION || type == CONDITION || (parent != NO_FLAT_NODE && in_expression[parent]);
+    }
+
+    find_contextual_names(ast, in_expression);
+
+    // Walking backwards, the children of every node are interned before the node itself
+    std::vector<Expr_id> children;
+    for (Flat_index node = ast.size(); node-- > 0; ) {
+        if (!in_expression[node]) continue;
+
+        children.clear();
+        for (Flat_index child = ast.get_first_child(node); child != NO_FLAT_NODE; child = ast.get_next_sibling(child)) {
+            children.push_back(ids[child]);
+        }
+
+        ids[node] = intern(ast, node, children.data(), children.size());
+        occurrences++;
+    }
+}
+
+void ExpressionDAG::find_contextual_names(const FlatAST &ast, const std::vector<bool> &in_expression) {
+
+    // The names each block gives to what it defines, and the particles a composite names within itself
+    std::unordered_map<Symbol, int> definitions;
+
+    for (Flat_index node = 0; node < ast.size(); ++node) {
+        if (in_expression[node]) continue;
+
+        AST_type type = ast.get_ast_type(node);
+        Flat_index first_child = ast.get_first_child(node);
+
+        bool names_block = type == OBJECT || type == DEFINITION || type == COMPOSITE || type == TABLE_DEF || type == REGION || type == HISTO_LIST;
+        if (names_block && first_child != NO_FLAT_NODE && ast.has_token(first_child)) {
+            definitions[ast.get_symbol(first_child)]++;
+        }
+
+        // Only known within the composite that names them, and free to mean something else in the next one
+        if (type == NAMED_PARTICLE_LIST) {
+            for (Flat_index child = first_child; child != NO_FLAT_NODE; child = ast.get_next_sibling(child)) {
+                if (ast.has_token(child) && ast.get_token(child)->get_token_type() == VARNAME) contextual_names.insert(ast.get_symbol(child));
+            }
+        }
+    }
+
+    for (auto it = definitions.begin(); it != definitions.end(); ++it) {
+        if (it->second > 1) contextual_names.insert(it->first);
+    }
+}
+
+Expr_id ExpressionDAG::intern(const FlatAST &ast, Flat_index node, const Expr_id *children, std::uint32_t num_children) {
+
+    AST_type type = ast.get_ast_type(node);
+    bool has_token = ast.has_token(node);
+    PToken token = has_token ? ast.get_token(node) : PToken();
+    Token_type token_type = has_token ? token->get_token_type() : LEXER_ERROR;
+    Symbol symbol = has_token ? token->get_symbol() : NO_SYMBOL;
+
+    std::uint64_t hash = mix(type, has_token);
+    hash = mix(hash, token_type);
+    hash = mix(hash, symbol);
+    for (std::uint32_t i = 0; i < num_children; ++i) hash = mix(hash, children[i]);
+
+    auto [first, last] = buckets.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        const Expr_node &candidate = nodes[it->second];
+
+        if (candidate.type != type || candidate.has_token != has_token) continue;
+        if (candidate.token_type != token_type || candidate.symbol != symbol) continue;
+        if (candidate.num_children != num_children) continue;
+
+        bool same_children = true;
+        for (std::uint32_t i = 0; i < num_children && same_children; ++i) {
+            same_children = child_ids[candidate.first_child + i] == children[i];
+        }
+        if (same_children) return it->second;
+    }
+
+    bool contextual = has_token && (token_type == THIS || contextual_names.count(symbol) != 0);
+    for (std::uint32_t i = 0; i < num_children; ++i) contextual = contextual || nodes[children[i]].contextual;
+
+    Expr_id id = nodes.size();
+    nodes.push_back({type, has_token, token_type, symbol, static_cast<std::uint32_t>(child_ids.size()), num_children, contextual});
+    child_ids.insert(child_ids.end(), children, children + num_children);
+    buckets.insert({hash, id});
+
+    return id;
+}
+
+Expr_id ExpressionDAG::id_of(PNode node) const {
+    std::uint32_t position = node->get_flat_position();
+    if (position >= ids.size()) return NO_EXPR_ID;
+    return ids[position];
+}
+
+const Expr_node &ExpressionDAG::get_node(Expr_id id) const {
+    assert(id < nodes.size());
+    return nodes[id];
+}
+
+Expr_id ExpressionDAG::get_child(Expr_id id, std::uint32_t pos) const {
+    assert(pos < get_node(id).num_children);
+    return child_ids[get_node(id).first_child + pos];
+}
+
+bool ExpressionDAG::is_contextual(Expr_id id) const {
+    return get_node(id).contextual;
+}
+
+std::size_t ExpressionDAG::size() const {
+    return nodes.size();
+}
+
+std::size_t ExpressionDAG::num_occurrences() const {
+    return occurrences;
+}
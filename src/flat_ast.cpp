@@ -0,0 +1,189 @@
+#include "flat_ast.hpp"
+
+#include <cassert>
+#include <utility>
+
+// AST_type is stored in a byte
+static_assert(NUM_AST_TYPES <= 256);
+
+FlatAST::FlatAST(PNode root, std::shared_ptr<const TokenArena> in_tokens): tokens(in_tokens) {
+
+    // Pre-order walk with an explicit stack of (node, parent) pairs, so that deep trees cannot overflow the call stack.
+    // Children are pushed in reverse so that they come off the stack, and so into the arrays, in order.
+    std::vector<std::pair<PNode, Flat_index>> pending = {{root, NO_FLAT_NODE}};
+    // The most recently placed child of each node, to link its next sibling onto
+    std::vector<Flat_index> last_children;
+
+    while (!pending.empty()) {
+        auto [node, parent] = pending.back();
+        pending.pop_back();
+
+        Flat_index index = types.size();
+        node->flat_position = index;
+
+        types.push_back(node->get_ast_type());
+        token_indices.push_back(node->has_token() ? node->get_token().get_index() : NO_TOKEN_INDEX);
+        first_children.push_back(NO_FLAT_NODE);
+        next_siblings.push_back(NO_FLAT_NODE);
+        parents.push_back(parent);
+        last_children.push_back(NO_FLAT_NODE);
+
+        if (parent != NO_FLAT_NODE) {
+            if (last_children[parent] == NO_FLAT_NODE) first_children[parent] = index;
+            else next_siblings[last_children[parent]] = index;
+            last_children[parent] = index;
+        }
+
+        auto &children = node->get_children();
+        for (auto it = children.end(); it != children.begin(); ) {
+            --it;
+            pending.push_back({*it, index});
+        }
+    }
+}
+
+Flat_index FlatAST::size() const {
+    return types.size();
+}
+
+Flat_index FlatAST::get_root() const {
+    return 0;
+}
+
+AST_type FlatAST::get_ast_type(Flat_index node) const {
+    return static_cast<AST_type>(types[node]);
+}
+
+bool FlatAST::has_token(Flat_index node) const {
+    return token_indices[node] != NO_TOKEN_INDEX;
+}
+
+Token_index FlatAST::get_token_index(Flat_index node) const {
+    return token_indices[node];
+}
+
+PToken FlatAST::get_token(Flat_index node) const {
+    Token_index index = token_indices[node];
+    if (index == NO_TOKEN_INDEX) return PToken();
+    if (index == END_OF_FILE_INDEX) return TokenArena::end_of_file();
+    return tokens->get(index);
+}
+
+Symbol FlatAST::get_symbol(Flat_index node) const {
+    if (!has_token(node)) return NO_SYMBOL;
+    return get_token(node)->get_symbol();
+}
+
+Flat_index FlatAST::get_first_child(Flat_index node) const {
+    return first_children[node];
+}
+
+Flat_index FlatAST::get_next_sibling(Flat_index node) const {
+    return next_siblings[node];
+}
+
+Flat_index FlatAST::get_parent(Flat_index node) const {
+    return parents[node];
+}
+
+Flat_index FlatAST::get_num_children(Flat_index node) const {
+    Flat_index count = 0;
+    for (Flat_index child = first_children[node]; child != NO_FLAT_NODE; child = next_siblings[child]) count++;
+    return count;
+}
+
+Flat_index FlatAST::get_child(Flat_index node, Flat_index pos) const {
+    Flat_index child = first_children[node];
+    while (pos-- > 0) {
+        assert(child != NO_FLAT_NODE);
+        child = next_siblings[child];
+    }
+    return child;
+}
+
+FlatASTVisitor::FlatASTVisitor(const FlatAST &in_ast): ast(in_ast) {}
+
+void FlatASTVisitor::visit(Flat_index node) {
+    switch (ast.get_ast_type(node)) {
+        case OBJECT:
+            return visit_object(node);
+        case DEFINITION:
+            return visit_definition(node);
+        case REGION:
+            return visit_region(node);
+        case COMPOSITE:
+            return visit_composite(node);
+        case CONDITION:
+            return visit_condition(node);
+        case IF_STATEMENT:
+            return visit_if(node);
+        case OBJECT_SELECT:
+            return visit_object_select(node);
+        case OBJECT_REJECT:
+            return visit_object_reject(node);
+        case REGION_SELECT:
+            return visit_region_select(node);
+        case REGION_REJECT:
+            return visit_region_reject(node);
+        case REGION_USE:
+            return visit_use(node);
+        case HISTO_LIST:
+            return visit_histo_list(node);
+        case HISTOGRAM: case HISTOLIST_HISTOGRAM:
+            return visit_histogram(node);
+        case HISTO_USE:
+            return visit_histo_use(node);
+        case PARTICLE_SUM:
+            return visit_particle_sum(node);
+        case EXPRESSION:
+            return visit_expression(node);
+        case TABLE_DEF:
+            return visit_table_def(node);
+        case BIN_CMD:
+            return visit_bin(node);
+        case BINS_CMD:
+            return visit_bin_list(node);
+        case WEIGHT_CMD:
+            return visit_weight(node);
+
+        default:
+            return visit_children(node);
+    }
+}
+
+void FlatASTVisitor::visit_children(Flat_index node) {
+    for (Flat_index child = ast.get_first_child(node); child != NO_FLAT_NODE; child = ast.get_next_sibling(child)) {
+        visit(child);
+    }
+}
+
+void FlatASTVisitor::visit_children_after_index(Flat_index node, int index) {
+    int i = 0;
+    for (Flat_index child = ast.get_first_child(node); child != NO_FLAT_NODE; child = ast.get_next_sibling(child)) {
+        if (i > index) {
+            visit(child);
+        }
+        i++;
+    }
+}
+
+void FlatASTVisitor::visit_object(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_region(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_definition(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_composite(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_object_select(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_object_reject(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_region_select(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_region_reject(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_use(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_expression(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_if(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_condition(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_histo_use(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_histogram(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_histo_list(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_particle_sum(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_table_def(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_bin(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_bin_list(Flat_index node) { visit_children(node); }
+void FlatASTVisitor::visit_weight(Flat_index node) { visit_children(node); }
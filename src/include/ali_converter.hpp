@@ -3,10 +3,16 @@
 
 #include "ast_visitor.hpp"
 #include "config.hpp"
+#include "expression_dag.hpp"
+#include "flat_ast.hpp"
 #include "lexer.hpp"
 #include "tokens.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -226,43 +232,86 @@ enum AnalysisLevelInstruction {
 
 };
 
+// Instructions are stored in 16 bits
+static_assert(SUB_PART_NAMED <= UINT16_MAX);
+
+// Arguments a command holds without allocating; the few commands with more, such as histograms, keep the rest on the heap
+constexpr int INLINE_ARGUMENTS = 4;
+
+/*
+One ALIL instruction, kept small so that long command lists stay compact and cheap to walk: a 16-bit opcode,
+interned arguments held inline, and the index of the token it was lowered from in the lexer's TokenArena.
+*/
 class AnalysisCommand {
     private:
-        AnalysisLevelInstruction instruction;
-
-        std::string dest_argument;
-        std::vector<std::string> source_arguments;
+        std::uint16_t instruction;
+        std::uint8_t num_arguments;
         bool has_dest_argument_yet;
+        // NO_TOKEN_INDEX if the command was not lowered from a particular token
+        Token_index source_location;
+
+        // The destination, if there is one, is argument 0, followed by the sources in order
+        Symbol inline_arguments[INLINE_ARGUMENTS];
+        std::unique_ptr<std::vector<Symbol>> spilled_arguments;
 
-        std::weak_ptr<Token> source_token;
-        bool has_source_token;
+        Symbol &argument_slot(int pos);
+        const Symbol &argument_slot(int pos) const;
+        void push_argument(Symbol arg);
     public:
-        AnalysisCommand(AnalysisLevelInstruction inst, std::weak_ptr<Token> tok);
+        AnalysisCommand(AnalysisLevelInstruction inst, PToken tok);
         AnalysisCommand(AnalysisLevelInstruction inst);
-
-        void add_dest_argument(std::string arg);
-        void add_source_argument(std::string arg);
-
-        AnalysisLevelInstruction get_instruction();
-        std::string get_argument(int pos);
-        int get_num_arguments();
-
-        bool has_dest_argument();
-        std::string get_dest_argument();
-        std::string get_source_argument(int pos);
+        // A command read back from a file, which only knows where its source token was
+        AnalysisCommand(AnalysisLevelInstruction inst, Token_index location);
+
+        AnalysisCommand(const AnalysisCommand &other);
+        AnalysisCommand &operator=(const AnalysisCommand &other);
+        AnalysisCommand(AnalysisCommand &&other) = default;
+        AnalysisCommand &operator=(AnalysisCommand &&other) = default;
+
+        void add_dest_argument(std::string_view arg);
+        void add_source_argument(std::string_view arg);
+        void add_dest_symbol(Symbol arg);
+        void add_source_symbol(Symbol arg);
+
+        AnalysisLevelInstruction get_instruction() const;
+        const std::string &get_argument(int pos) const;
+        Symbol get_argument_symbol(int pos) const;
+        void set_argument_symbol(int pos, Symbol arg);
+        int get_num_arguments() const;
+        Token_index get_source_location() const;
+
+        bool has_dest_argument() const;
+        const std::string &get_dest_argument() const;
+        const std::string &get_source_argument(int pos) const;
     
-        void print_instruction();
-        void print_instruction(int width_of_dest, int width_of_inst);
+        void print_instruction() const;
+        void print_instruction(int width_of_dest, int width_of_inst) const;
+        void print_instruction(std::ostream &out, int width_of_dest, int width_of_inst) const;
         std::string static instruction_to_text(AnalysisLevelInstruction inst);
 };
 
-class ALILConverter : ASTVisitor {
+// Starts the stand-in a block lowered on its own gives for a name it reserves, until the block's place in the command list is known
+constexpr char RELOCATION_MARK = '\x1f';
+// Set in the argument symbol a command keeps for such a stand-in, whose other bits are the name's number within its block
+constexpr Symbol RELOCATED_NAME = 0x80000000u;
+
+// The parts of a name reserved by a block lowered on its own, kept apart until the names before the block are counted
+struct Relocated_name {
+    const char *prefix;
+    // Everything after the number: the scope, and any suffix
+    std::string rest;
+};
+
+class ALILConverter : StaticASTVisitor<ALILConverter> {
     private:
+        friend class StaticASTVisitor<ALILConverter>;
+
         std::vector<AnalysisCommand> command_list;
 
         void clean_command_list();
 
         std::string handle_expression(PNode node);
+        std::string lower_expression(PNode node);
 
         std::string if_operator(PNode node);
 
@@ -283,6 +332,7 @@ class ALILConverter : ASTVisitor {
         std::string literal_value(PNode node);
         std::string keyword_value(PNode node);
 
+        std::string reserve_scoped_name(const char *prefix, const char *suffix = "");
         std::string reserve_scoped_value_name();
         std::string reserve_scoped_limit_name();
         std::string reserve_scoped_region_name();
@@ -307,41 +357,88 @@ class ALILConverter : ASTVisitor {
 
         int highest_var_val;
 
+        // Set on the converters that lower one block each for visitation_parallel
+        bool relocatable_names;
+        // Every name such a converter has reserved, by its number within the block
+        std::vector<Relocated_name> relocated_names;
+
+        // The value each unique expression was lowered to, and the scope it was lowered in, once it has been
+        struct Shared_value {
+            std::string name;
+            std::string scope;
+        };
+
+        // Null unless identical expressions are to be lowered once and shared
+        const ExpressionDAG *expressions;
+        std::vector<Shared_value> shared_values;
+
         int iter_command;
 
         Config &config;
 
     protected:
-        void visit_object(PNode node) override;
-        void visit_if(PNode node) override;
-        void visit_object_select(PNode node) override;
-        void visit_object_reject(PNode node) override;
-        void visit_region_select(PNode node) override;
-        void visit_region_reject(PNode node) override;
-        void visit_composite(PNode node) override;
-        void visit_condition(PNode node) override;
-        void visit_region(PNode node) override;
-        void visit_definition(PNode node) override;
-        void visit_criteria(PNode node) override;
-        void visit_use(PNode node) override;
-        void visit_histogram(PNode node) override;
-        void visit_histo_list(PNode node) override;
-        void visit_histo_use(PNode node) override;
-        void visit_particle_sum(PNode node) override;
-        void visit_expression(PNode node) override;
-        void visit_bin(PNode node) override;
-        void visit_bin_list(PNode node) override;
-        void visit_table_def(PNode node) override;
-        void visit_weight(PNode node) override;
+        void visit_object(PNode node);
+        void visit_if(PNode node);
+        void visit_object_select(PNode node);
+        void visit_object_reject(PNode node);
+        void visit_region_select(PNode node);
+        void visit_region_reject(PNode node);
+        void visit_composite(PNode node);
+        void visit_condition(PNode node);
+        void visit_region(PNode node);
+        void visit_definition(PNode node);
+        void visit_criteria(PNode node);
+        void visit_use(PNode node);
+        void visit_histogram(PNode node);
+        void visit_histo_list(PNode node);
+        void visit_histo_use(PNode node);
+        void visit_particle_sum(PNode node);
+        void visit_expression(PNode node);
+        void visit_bin(PNode node);
+        void visit_bin_list(PNode node);
+        void visit_table_def(PNode node);
+        void visit_weight(PNode node);
 
 
     public:
         ALILConverter(Config &conf);
 
+        // Lower every occurrence of an expression of the DAG to the value of its first occurrence; the DAG must outlive visitation
+        void share_expressions(const ExpressionDAG *dag);
+
         void visitation(PNode root);
+        // Lower the top-level blocks on up to the given number of threads, as each block's dependencies are lowered.
+        // The dependencies are found from the FlatAST of the tree. The commands are the same as visitation's when every
+        // block is defined before it is used; shared expressions are only shared within a block.
+        void visitation_parallel(PNode root, const FlatAST &ast, unsigned threads);
         void print_commands();
 
-        AnalysisCommand next_command();
+        // The lowered commands, or replace them with ones lowered earlier, such as those read back by an ALILReader
+        const std::vector<AnalysisCommand> &get_commands() const;
+        void load_commands(std::vector<AnalysisCommand> commands);
+
+        /*
+        Drop every pure command, such as an EXPR_*, FUNC_* or particle command, that repeats the instruction and sources
+        of an earlier one, and make the later commands read the earlier result instead. Only commands that define an
+        intermediate name exactly once are dropped, so the names the ADL gives are all kept. Gives how many were dropped.
+        */
+        std::size_t eliminate_common_subexpressions();
+
+        /*
+        Drop every command that no region, bin, histogram use, cutflow or event list needs, such as those of objects,
+        definitions and tables nothing refers to. Commands that define nothing are all kept. Gives how many were dropped.
+        */
+        std::size_t eliminate_dead_commands();
+
+        /*
+        Work out every arithmetic, comparison, logical, interval or math function (sqrt, abs, cos, exp, ...) command whose
+        sources are all numeric literals or names of constants, and every identity such as x * 1, x + 0 or not not x,
+        turning each into an ADD_ALIAS of its value or of x. The literals and commands this leaves unused are left for
+        eliminate_dead_commands. Gives how many commands were folded.
+        */
+        std::size_t fold_constants();
+
+        const AnalysisCommand &next_command();
         bool clear_to_next();
 };
 
@@ -0,0 +1,63 @@
+#ifndef ALIL_FILE_H
+#define ALIL_FILE_H
+
+#include "ali_converter.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// Bumped whenever the layout of a binary ALIL file changes
+constexpr std::uint32_t ALIL_FORMAT_VERSION = 1;
+
+/*
+Writes lowered commands out, so that a backend can later be run on them without the ADL being lexed, parsed and lowered again.
+*/
+class ALILWriter {
+    private:
+        std::ostream &out;
+
+    public:
+        ALILWriter(std::ostream &in_out);
+
+        // The listing print_commands shows, one command per line, with the destination and instruction columns lined up
+        void write_text(const std::vector<AnalysisCommand> &commands);
+
+        /*
+        A little-endian binary file, exact for any argument text:
+            char[8]  "ADLALIL\0"
+            uint32   ALIL_FORMAT_VERSION
+            uint32   number of distinct arguments, then for each of them:
+                uint32   length, then the bytes of its text
+            uint32   number of commands, then for each of them:
+                uint16   instruction
+                uint8    number of arguments
+                uint8    1 if argument 0 is the destination, else 0
+                uint32   index of the source token, 0xfffffffe if there is none
+                uint32   index of each argument among the distinct ones
+        */
+        void write_binary(const std::vector<AnalysisCommand> &commands);
+};
+
+/*
+Reads back the commands an ALILWriter wrote, in either format; a binary file is told apart by its magic.
+The text format holds no source locations, and cannot tell an argument containing ") (" from two arguments,
+so only the binary format round-trips every command exactly.
+Malformed input raises an ALILReadingException naming the line or command at fault.
+*/
+class ALILReader {
+    private:
+        std::string_view data;
+
+        std::vector<AnalysisCommand> read_text();
+        std::vector<AnalysisCommand> read_binary();
+
+    public:
+        // The data must outlive the reader, but not the commands it reads
+        ALILReader(std::string_view in_data);
+
+        std::vector<AnalysisCommand> read();
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "node.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Bumped whenever the layout of a cache file changes
+constexpr std::uint32_t AST_CACHE_FORMAT_VERSION = 1;
+
+/*
+A directory of parsed trees, each stored in a binary file named after a hash of the ADL text it was parsed from and
+of the parser version, so that the same file is only ever lexed and parsed once.
+A cache file holds the tokens the tree refers to, followed by the nodes in pre-order with their types, tokens and
+child counts. A file that is missing, truncated or written by another version is treated as a miss.
+*/
+class ASTCache {
+    private:
+        std::string directory;
+
+        std::string path_for_hash(std::uint64_t content_hash) const;
+
+    public:
+        ASTCache(std::string in_directory);
+
+        // The file that holds the tree parsed from these contents
+        std::string path_for(std::string_view contents) const;
+
+        // Fill an empty tree with the one parsed from these contents, giving false on a miss and leaving the tree untouched
+        bool load(std::string_view contents, Tree &tree) const;
+        // Write the tree parsed from these contents to the cache, giving false if it could not be written
+        bool store(std::string_view contents, Tree &tree) const;
+};
+
+#endif
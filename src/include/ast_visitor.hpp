@@ -49,4 +49,118 @@ class ASTVisitor {
 
 };
 
+/*
+Counterpart of ASTVisitor whose dispatch is resolved at compile time: a visitor derives from StaticASTVisitor<itself>
+and defines the visit_* hooks it needs, hiding the defaults here, which walk the children. visit() calls the hooks
+through the derived type, with no virtual calls, so the compiler can inline them into the switch.
+A visitor that keeps its hooks private or protected must befriend StaticASTVisitor<itself>.
+*/
+template <typename Derived>
+class StaticASTVisitor {
+    private:
+        Derived &derived() {
+            return static_cast<Derived &>(*this);
+        }
+
+    protected:
+        void visit_object(PNode node) { visit_children(node); }
+        void visit_region(PNode node) { visit_children(node); }
+        void visit_definition(PNode node) { visit_children(node); }
+        void visit_composite(PNode node) { visit_children(node); }
+
+        void visit_criteria(PNode node) { visit_children(node); }
+
+        void visit_object_select(PNode node) { visit_children(node); }
+        void visit_object_reject(PNode node) { visit_children(node); }
+
+        void visit_region_select(PNode node) { visit_children(node); }
+        void visit_region_reject(PNode node) { visit_children(node); }
+
+        void visit_use(PNode node) { visit_children(node); }
+
+        void visit_expression(PNode node) { visit_children(node); }
+
+        void visit_if(PNode node) { visit_children(node); }
+        void visit_condition(PNode node) { visit_children(node); }
+
+        void visit_histo_use(PNode node) { visit_children(node); }
+        void visit_histogram(PNode node) { visit_children(node); }
+        void visit_histo_list(PNode node) { visit_children(node); }
+
+        void visit_particle_sum(PNode node) { visit_children(node); }
+
+        void visit_table_def(PNode node) { visit_children(node); }
+
+        void visit_bin(PNode node) { visit_children(node); }
+        void visit_bin_list(PNode node) { visit_children(node); }
+
+        void visit_weight(PNode node) { visit_children(node); }
+
+    public:
+        // Dispatches on the same node types as ASTVisitor::visit
+        void visit(PNode node) {
+            switch (node->get_ast_type()) {
+                case OBJECT:
+                    return derived().visit_object(node);
+                case DEFINITION:
+                    return derived().visit_definition(node);
+                case REGION:
+                    return derived().visit_region(node);
+                case COMPOSITE:
+                    return derived().visit_composite(node);
+                case CONDITION:
+                    return derived().visit_condition(node);
+                case IF_STATEMENT:
+                    return derived().visit_if(node);
+                case OBJECT_SELECT:
+                    return derived().visit_object_select(node);
+                case OBJECT_REJECT:
+                    return derived().visit_object_reject(node);
+                case REGION_SELECT:
+                    return derived().visit_region_select(node);
+                case REGION_REJECT:
+                    return derived().visit_region_reject(node);
+                case REGION_USE:
+                    return derived().visit_use(node);
+                case HISTO_LIST:
+                    return derived().visit_histo_list(node);
+                case HISTOGRAM: case HISTOLIST_HISTOGRAM:
+                    return derived().visit_histogram(node);
+                case HISTO_USE:
+                    return derived().visit_histo_use(node);
+                case PARTICLE_SUM:
+                    return derived().visit_particle_sum(node);
+                case EXPRESSION:
+                    return derived().visit_expression(node);
+                case TABLE_DEF:
+                    return derived().visit_table_def(node);
+                case BIN_CMD:
+                    return derived().visit_bin(node);
+                case BINS_CMD:
+                    return derived().visit_bin_list(node);
+                case WEIGHT_CMD:
+                    return derived().visit_weight(node);
+
+                default:
+                    return visit_children(node);
+            }
+        }
+
+        void visit_children(PNode node) {
+            for (auto it = node->get_children().begin(); it != node->get_children().end(); ++it) {
+                visit(*it);
+            }
+        }
+
+        void visit_children_after_index(PNode node, int index) {
+            int i = 0;
+            for (auto it = node->get_children().begin(); it != node->get_children().end(); ++it) {
+                if (i > index) {
+                    visit(*it);
+                }
+                i++;
+            }
+        }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef AST_WRITER_H
+#define AST_WRITER_H
+
+#include "node.hpp"
+
+#include <cstdint>
+#include <ostream>
+
+// Bumped whenever the layout of a binary dump changes
+constexpr std::uint32_t AST_DUMP_FORMAT_VERSION = 1;
+
+/*
+Streams a tree to an output stream as it walks it, one node at a time, in pre-order.
+Every format numbers the nodes the same way: the root is 1, and each node is numbered before its children.
+The walks keep an explicit stack, so trees of any depth can be written.
+*/
+class ASTWriter {
+    private:
+        std::ostream &out;
+
+    public:
+        ASTWriter(std::ostream &in_out);
+
+        // A graphviz digraph, with each terminal labelled by its lexeme and each nonterminal by its type
+        void write_dot(PNode root);
+
+        /*
+        One JSON object per line and per node:
+            {"id":2,"parent":1,"type":"TERMINAL","children":0,"token":"VARNAME","lexeme":"pt","line":3,"column":10}
+        The parent of the root is 0; token, lexeme, line and column are only present on nodes that have a token.
+        */
+        void write_json_lines(PNode root);
+
+        /*
+        A little-endian binary dump:
+            char[8]  "ADLDUMP\0"
+            uint32   AST_DUMP_FORMAT_VERSION
+            then one record per node, until the end of the stream:
+            uint32   parent id, 0 for the root
+            uint16   AST type
+            uint16   token type, 0xffff if the node has no token
+            uint32   number of children
+            int32    line, int32 column, uint32 lexeme length, lexeme bytes; only if the node has a token
+        */
+        void write_binary(PNode root);
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CHAR_SCAN_H
+#define CHAR_SCAN_H
+
+#include <array>
+#include <cstddef>
+
+// What the lexer needs to know about a byte when splitting a line into tokens, as bit flags
+enum Char_kind : unsigned char {
+    CK_SPACE = 1,
+    CK_SYMBOL = 2,
+    // Letters, digits and underscores, the bulk of every identifier and number
+    CK_IDENTIFIER = 4,
+};
+
+constexpr std::array<unsigned char, 256> make_char_kinds() {
+    std::array<unsigned char, 256> kinds {};
+
+    for (int c = 0; c < 256; c++) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r') kinds[c] |= CK_SPACE;
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_') kinds[c] |= CK_IDENTIFIER;
+    }
+
+    for (char c : {'=', '!', '~', '<', '>', '(', ')', '[', ']', '{', '}', ':', '&', '|', '+', '-', '*', '/', '?', '^', ',', '.'}) {
+        kinds[static_cast<unsigned char>(c)] |= CK_SYMBOL;
+    }
+
+    return kinds;
+}
+
+inline constexpr std::array<unsigned char, 256> char_kinds = make_char_kinds();
+
+inline bool has_char_kind(char c, Char_kind kind) {
+    return (char_kinds[static_cast<unsigned char>(c)] & kind) != 0;
+}
+
+// Which instructions the run skippers below use: SSE2 where the CPU has it by default, or forced for comparison
+enum Vector_width {
+    VECTOR_NONE,
+    VECTOR_SSE2,
+    VECTOR_AVX2,
+};
+
+// The widest the CPU can run, which set_vector_width never goes past
+Vector_width get_supported_vector_width();
+Vector_width get_vector_width();
+void set_vector_width(Vector_width width);
+
+// Give the first position at or after pos, and at most length, whose byte is not of the given kind
+std::size_t skip_identifier_run(const char *text, std::size_t pos, std::size_t length);
+std::size_t skip_space_run(const char *text, std::size_t pos, std::size_t length);
+
+#endif
@@ -15,22 +15,22 @@ class CoffeaConverter : public ALILToFrameworkCompiler {
         std::unique_ptr<ALILConverter> alil;
 
         std::vector<std::string> existing_definitions;
-        std::unordered_map<std::string, std::string> var_mappings;
+        std::unordered_map<Symbol, std::string> var_mappings;
         std::unordered_map<std::string, std::vector<std::string>> region_groups;
 
         std::unordered_set<std::string> needs_btag;
         std::unordered_set<std::string> empty_union_names;
 
         void initialize_all_particles();
-        std::string command_convert(AnalysisCommand command);
-        std::string binary_command(AnalysisCommand command, std::string op);
-        void append_4vector_label(AnalysisCommand command, std::string suffix);
-        void sub_particle(AnalysisCommand command, std::string name);
-        void add_particle(AnalysisCommand command, std::string name);
-        std::string index_particle(AnalysisCommand command, bool is_named, std::string part_text);
+        std::string command_convert(const AnalysisCommand &command);
+        std::string binary_command(const AnalysisCommand &command, std::string op);
+        void append_4vector_label(const AnalysisCommand &command, std::string suffix);
+        void sub_particle(const AnalysisCommand &command, std::string name);
+        void add_particle(const AnalysisCommand &command, std::string name);
+        std::string index_particle(const AnalysisCommand &command, bool is_named, std::string part_text);
         std::string existing_definitions_string();
-        std::string handle_union_merge(AnalysisCommand command, std::string adding_name);
-        std::string handle_union_empty(AnalysisCommand command);
+        std::string handle_union_merge(const AnalysisCommand &command, std::string adding_name);
+        std::string handle_union_empty(const AnalysisCommand &command);
 
 
     public:
@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include <string>
 #include "lexer.hpp"
 
@@ -16,7 +17,14 @@ class AnalysisLevelConversionException : public std::runtime_error {
         AnalysisLevelConversionException(const char* what) : runtime_error(what) {}
 };
 
+class ALILReadingException : public std::runtime_error {
+    public:
+        ALILReadingException(const char* what) : runtime_error(what) {}
+};
+
 void raise_lexing_exception(PToken token);
+void raise_editing_exception(std::string error);
 void raise_parsing_exception(std::string error, PToken token);
 void raise_analysis_conversion_exception(std::string error, PToken token);
-void raise_non_implemented_conversion_exception(std::string inst, std::string context="");
\ No newline at end of file
+void raise_non_implemented_conversion_exception(std::string inst, std::string context="");
+void raise_alil_reading_exception(std::string error, std::string location);
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef EXPRESSION_DAG_H
+#define EXPRESSION_DAG_H
+
+#include "flat_ast.hpp"
+#include "node.hpp"
+#include "symbol_table.hpp"
+#include "tokens.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Names one unique expression of an ExpressionDAG
+typedef std::uint32_t Expr_id;
+
+// Held by nodes that are not part of any expression
+constexpr Expr_id NO_EXPR_ID = UINT32_MAX;
+
+// One unique expression: the AST type, token and children that every occurrence of it shares
+struct Expr_node {
+    AST_type type;
+    bool has_token;
+    Token_type token_type;
+    Symbol symbol;
+    // The ids of the children are child_ids[first_child, first_child + num_children)
+    std::uint32_t first_child;
+    std::uint32_t num_children;
+    // Set if the expression refers to the enclosing object through `this`, or to a name that is defined more than once
+    // or only within a composite, and so may mean something else in each block
+    bool contextual;
+};
+
+/*
+The expressions of a tree, hash-consed: every EXPRESSION and CONDITION subtree is interned bottom-up by
+its (type, token, children), so that structurally identical subtrees anywhere in the file get the same Expr_id.
+It is built from the FlatAST of the tree in one backward sweep over its arrays, in which every node comes after
+its parent, so ids are handed out in reverse pre-order and the same file always numbers its expressions the
+same way. The tree itself is left as it is.
+*/
+class ExpressionDAG {
+    private:
+        std::vector<Expr_node> nodes;
+        std::vector<Expr_id> child_ids;
+
+        // Every occurrence, by its position in the FlatAST, and NO_EXPR_ID for the nodes outside expressions
+        std::vector<Expr_id> ids;
+        std::size_t occurrences;
+        // Unique expressions by their hash; colliding ones are told apart by comparing them
+        std::unordered_multimap<std::uint64_t, Expr_id> buckets;
+
+        // Names that mean something else depending on the block they are used in
+        std::unordered_set<Symbol> contextual_names;
+
+        void find_contextual_names(const FlatAST &ast, const std::vector<bool> &in_expression);
+        Expr_id intern(const FlatAST &ast, Flat_index node, const Expr_id *children, std::uint32_t num_children);
+
+    public:
+        ExpressionDAG(const FlatAST &ast);
+
+        // The id of an expression node of the tree the FlatAST was made from, or NO_EXPR_ID
+        Expr_id id_of(PNode node) const;
+
+        const Expr_node &get_node(Expr_id id) const;
+        Expr_id get_child(Expr_id id, std::uint32_t pos) const;
+        bool is_contextual(Expr_id id) const;
+
+        // Unique expressions, and the tree nodes they stand for
+        std::size_t size() const;
+        std::size_t num_occurrences() const;
+};
+
+#endif
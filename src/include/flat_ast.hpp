@@ -0,0 +1,99 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "lexer.hpp"
+#include "node.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Position of a node in a FlatAST
+typedef std::uint32_t Flat_index;
+
+// Marks a missing child, sibling or parent
+constexpr Flat_index NO_FLAT_NODE = UINT32_MAX;
+
+/*
+A compact copy of a Tree, as parallel arrays indexed by Flat_index, at 17 bytes a node.
+Nodes are laid out in pre-order: the root is 0, a node's first child directly follows it, and every subtree
+is contiguous, so a whole-tree pass is a single forward sweep over the arrays. Each Node of the tree is told its
+position, so that what a pass over the arrays finds can be looked up again from the tree.
+*/
+class FlatAST {
+    private:
+        std::vector<std::uint8_t> types;
+        std::vector<Token_index> token_indices;
+        std::vector<Flat_index> first_children;
+        std::vector<Flat_index> next_siblings;
+        std::vector<Flat_index> parents;
+
+        std::shared_ptr<const TokenArena> tokens;
+
+    public:
+        FlatAST(PNode root, std::shared_ptr<const TokenArena> in_tokens);
+
+        Flat_index size() const;
+        Flat_index get_root() const;
+
+        AST_type get_ast_type(Flat_index node) const;
+        bool has_token(Flat_index node) const;
+        Token_index get_token_index(Flat_index node) const;
+        PToken get_token(Flat_index node) const;
+        Symbol get_symbol(Flat_index node) const;
+
+        Flat_index get_first_child(Flat_index node) const;
+        Flat_index get_next_sibling(Flat_index node) const;
+        Flat_index get_parent(Flat_index node) const;
+
+        Flat_index get_num_children(Flat_index node) const;
+        Flat_index get_child(Flat_index node, Flat_index pos) const;
+};
+
+// Counterpart of ASTVisitor for a FlatAST. Every hook walks the children unless overridden.
+class FlatASTVisitor {
+    protected:
+        const FlatAST &ast;
+
+        virtual void visit_object(Flat_index node);
+        virtual void visit_region(Flat_index node);
+        virtual void visit_definition(Flat_index node);
+        virtual void visit_composite(Flat_index node);
+
+        virtual void visit_object_select(Flat_index node);
+        virtual void visit_object_reject(Flat_index node);
+
+        virtual void visit_region_select(Flat_index node);
+        virtual void visit_region_reject(Flat_index node);
+
+        virtual void visit_use(Flat_index node);
+
+        virtual void visit_expression(Flat_index node);
+
+        virtual void visit_if(Flat_index node);
+        virtual void visit_condition(Flat_index node);
+
+        virtual void visit_histo_use(Flat_index node);
+        virtual void visit_histogram(Flat_index node);
+        virtual void visit_histo_list(Flat_index node);
+
+        virtual void visit_particle_sum(Flat_index node);
+
+        virtual void visit_table_def(Flat_index node);
+
+        virtual void visit_bin(Flat_index node);
+        virtual void visit_bin_list(Flat_index node);
+
+        virtual void visit_weight(Flat_index node);
+
+    public:
+        FlatASTVisitor(const FlatAST &in_ast);
+        virtual ~FlatASTVisitor() = default;
+
+        void visit(Flat_index node);
+
+        void visit_children(Flat_index node);
+        void visit_children_after_index(Flat_index node, int index);
+};
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include "tokens.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+Reserved words and symbols of ADL, looked up through a perfect hash that is built entirely at compile time.
+
+Most keywords are case-insensitive and are written here in uppercase. A few (the header tags, the systematics and some particle attributes) are only
+recognised when spelled exactly as written, and are marked as case-sensitive. The hash is always taken over the uppercased token, so no two
+entries may share an uppercase spelling.
+*/
+
+struct Keyword {
+    std::string_view text;
+    Token_type type;
+    bool case_sensitive;
+};
+
+constexpr Keyword ci_keyword(std::string_view text, Token_type type) { return Keyword{text, type, false}; }
+constexpr Keyword cs_keyword(std::string_view text, Token_type type) { return Keyword{text, type, true}; }
+
+constexpr Keyword adl_keywords[] = {
+    // Top level ADL syntax
+    ci_keyword("DEF", DEF), ci_keyword("DEFINE", DEF),
+    ci_keyword("ALGORITHM", ALGO), ci_keyword("ALGO", ALGO), ci_keyword("REGION", ALGO),
+    ci_keyword("HISTOLIST", HISTOLIST),
+    ci_keyword("INFO", ADLINFO),
+    ci_keyword("OBJ", OBJ), ci_keyword("OBJECT", OBJ),
+    ci_keyword("COMP", COMP), ci_keyword("COMPOSITE", COMP),
+
+    ci_keyword("CMD", SELECT), ci_keyword("CUT", SELECT), ci_keyword("SELECT", SELECT),
+    ci_keyword("REJECT", REJEC),
+
+    // Header info tags
+    cs_keyword("experiment", PAP_EXPERIMENT),
+    cs_keyword("id", PAP_ID),
+    ci_keyword("TITLE", PAP_TITLE),
+    cs_keyword("publication", PAP_PUBLICATION),
+    cs_keyword("sqrtS", PAP_SQRTS),
+    cs_keyword("lumi", PAP_LUMI),
+    cs_keyword("arXiv", PAP_ARXIV),
+    cs_keyword("hepdata", PAP_HEPDATA),
+    cs_keyword("doi", PAP_DOI),
+
+    ci_keyword("PARTICLE", PARTICLE_KEYWORD), ci_keyword("CANDIDATE", PARTICLE_KEYWORD),
+    ci_keyword("EXTERN", EXTERNAL), ci_keyword("EXTERNAL", EXTERNAL),
+    ci_keyword("CORRECTIONLIB", CORRECTIONLIB),
+
+    cs_keyword("systematic", SYSTEMATIC),
+    cs_keyword("ttree", SYST_TTREE),
+    cs_keyword("weightMc", SYST_WEIGHT_MC),
+    cs_keyword("weightPileup", SYST_WEIGHT_PILEUP),
+    cs_keyword("weightJvt", SYST_WEIGHT_JVT),
+    cs_keyword("weightLeptonSF", SYST_WEIGHT_LEPTON_SF),
+    cs_keyword("weightBTagSF", SYST_WEIGHT_BTAG_SF),
+    cs_keyword("RunYear", RUNYEAR),
+    cs_keyword("mcChannelNumber", MC_CHANNEL_NUMBER),
+    ci_keyword("EVENTNO", EVENT_NO),
+    ci_keyword("RUNNO", RUN_NO),
+    ci_keyword("LBNO", LB_NO),
+    cs_keyword("OME", OME),
+
+    ci_keyword("PRINT", PRINT),
+    ci_keyword("IF", IF),
+    ci_keyword("THEN", THEN),
+    ci_keyword("ELSE", ELSE),
+    ci_keyword("DO", DO),
+    ci_keyword("ON", TRUE), ci_keyword("TRUE", TRUE),
+    ci_keyword("OFF", FALSE), ci_keyword("FALSE", FALSE),
+    ci_keyword("NVARS", NVARS),
+    ci_keyword("ERRORS", ERRORS),
+    ci_keyword("TABLETYPE", TABLETYPE),
+    ci_keyword("TAKE", TAKE), ci_keyword("USING", TAKE),
+    ci_keyword("HISTO", HISTO), ci_keyword("HIST", HISTO),
+    ci_keyword("WEIGHT", WEIGHT),
+    ci_keyword("TABLE", TABLE),
+    ci_keyword("SKIPHISTOS", SKIP_HISTO),
+    ci_keyword("SKIPEFS", SKIP_EFFS),
+
+    // Particle types
+    ci_keyword("GEN", GEN),
+    ci_keyword("ELE", ELECTRON), ci_keyword("ELECTRON", ELECTRON),
+    ci_keyword("MUO", MUON), ci_keyword("MUON", MUON),
+    ci_keyword("TAU", TAU),
+    ci_keyword("TRK", TRACK),
+    ci_keyword("PHO", PHOTON), ci_keyword("PHOTON", PHOTON),
+    ci_keyword("JET", JET),
+    ci_keyword("FJET", FJET), ci_keyword("FATJET", FJET),
+    ci_keyword("QGJET", QGJET),
+    ci_keyword("MET", METLV), ci_keyword("METLV", METLV),
+
+    // Within-object block helper
+    ci_keyword("THIS", THIS),
+
+    // Particle extra keywords
+    cs_keyword("daughters", CONSTITUENTS), cs_keyword("constituents", CONSTITUENTS),
+
+    ci_keyword("BIN", BIN),
+    ci_keyword("BINS", BINS),
+
+    cs_keyword("genPartIdx", GENPART_IDX),
+
+    ci_keyword("UNION", UNION),
+    ci_keyword("ALIAS", ALIAS),
+
+    // Id functions
+    ci_keyword("PDGID", PDG_ID), ci_keyword("PDG_ID", PDG_ID),
+    ci_keyword("STATUSFLAGS", STATUS_FLAGS),
+
+    ci_keyword("ISTIGHT", IS_TIGHT),
+    ci_keyword("ISMEDIUM", IS_MEDIUM),
+    ci_keyword("ISLOOSE", IS_LOOSE),
+
+    ci_keyword("MINIISO", MINI_ISO),
+    ci_keyword("ABSISO", ABS_ISO),
+
+    cs_keyword("dxy", DXY), ci_keyword("D0", DXY),
+    cs_keyword("dz", DZ),
+
+    ci_keyword("PHI", PHI),
+    ci_keyword("ETA", ETA),
+    ci_keyword("RAP", RAPIDITY),
+
+    ci_keyword("CHARGE", CHARGE),
+    ci_keyword("MASS", MASS),
+    ci_keyword("MSOFTDROP", MSOFTDROP),
+    ci_keyword("THETA", THETA),
+
+    ci_keyword("PT", PT),
+    ci_keyword("PZ", PZ),
+    ci_keyword("DR", DR), ci_keyword("DELTAR", DR),
+    ci_keyword("DPHI", DPHI), ci_keyword("DELTAPHI", DPHI),
+    ci_keyword("DETA", DETA), ci_keyword("DELTAETA", DETA),
+
+    ci_keyword("DISTINCT", DISTINCT),
+
+    ci_keyword("DRHADAMARD", DR_HADAMARD), ci_keyword("DELTARHADAMARD", DR_HADAMARD),
+    ci_keyword("DETAHADAMARD", DETA_HADAMARD), ci_keyword("DELTAETAHADAMARD", DETA_HADAMARD),
+    ci_keyword("DPHIHADAMARD", DPHI_HADAMARD), ci_keyword("DELTAPHIHADAMARD", DPHI_HADAMARD),
+
+    ci_keyword("SIZE", NUMOF), ci_keyword("COUNT", NUMOF), ci_keyword("NUMOF", NUMOF),
+
+    // Global analysis tokens
+    ci_keyword("ALL", ALL),
+    ci_keyword("NONE", NONE),
+
+    // Comparison operators
+    cs_keyword("==", EQ), ci_keyword("EQ", EQ),
+    cs_keyword("!=", NE), ci_keyword("NE", NE),
+    cs_keyword("~!", MAXIMIZE),
+    cs_keyword("~=", MINIMIZE),
+    cs_keyword("<=", LE), ci_keyword("LE", LE),
+    cs_keyword(">=", GE), ci_keyword("GE", GE),
+    cs_keyword("<", LT), ci_keyword("LT", LT),
+    cs_keyword(">", GT), ci_keyword("GT", GT),
+
+    // Logical operators
+    ci_keyword("AND", AND), cs_keyword("&&", AND),
+    ci_keyword("OR", OR), cs_keyword("||", OR),
+    ci_keyword("NOT", NOT),
+    ci_keyword("WITHIN", WITHIN), ci_keyword("IN", WITHIN),
+    ci_keyword("OUTSIDE", OUTSIDE),
+
+    cs_keyword("-", MINUS),
+    cs_keyword("+", PLUS),
+    cs_keyword("*", MULTIPLY),
+    cs_keyword("/", DIVIDE),
+
+    cs_keyword("&", AMPERSAND),
+    cs_keyword("|", PIPE),
+    cs_keyword(":", COLON),
+    cs_keyword("^", RAISED_TO_POWER),
+
+    cs_keyword(".", DOT_INDEX),
+    cs_keyword("->", ARROW_INDEX),
+
+    cs_keyword("(", OPEN_PAREN),
+    cs_keyword(")", CLOSE_PAREN),
+    cs_keyword("[", OPEN_SQUARE_BRACE),
+    cs_keyword("]", CLOSE_SQUARE_BRACE),
+    cs_keyword("{", OPEN_CURLY_BRACE),
+    cs_keyword("}", CLOSE_CURLY_BRACE),
+    cs_keyword("?", QUESTION),
+    cs_keyword("=", ASSIGN),
+    cs_keyword("_", UNDERSCORE),
+
+    // Purely mathematical functions
+    ci_keyword("DESCEND", DESCEND), ci_keyword("DESCENDING", DESCEND), ci_keyword("DECREASING", DESCEND),
+    ci_keyword("TAN", TAN),
+    ci_keyword("SIN", SIN),
+    ci_keyword("COS", COS),
+    ci_keyword("SINH", SINH),
+    ci_keyword("COSH", COSH),
+    ci_keyword("TANH", TANH),
+    ci_keyword("EXP", EXP),
+    ci_keyword("LOG", LOG),
+    ci_keyword("ABS", ABS),
+    ci_keyword("SQRT", SQRT),
+
+    // Functions on variable lists
+    ci_keyword("AVE", AVE),
+    ci_keyword("SUM", SUM),
+    ci_keyword("ADD", ADD),
+    ci_keyword("SAVE", SAVE),
+    ci_keyword("CSV", CSV),
+    ci_keyword("ANY", ANYOF), ci_keyword("ANYOF", ANYOF),
+    ci_keyword("ALLOF", ALLOF),
+
+    ci_keyword("ASCEND", ASCEND), ci_keyword("ASCENDING", ASCEND), ci_keyword("INCREASING", ASCEND),
+
+    ci_keyword("ANYOCCURRENCES", ANYOCCURRENCES),
+
+    ci_keyword("SORT", SORT),
+    ci_keyword("COMB", COMB), ci_keyword("CARTESIAN", COMB),
+    ci_keyword("DISJOINT", DISJOINT),
+    ci_keyword("DIRECT", DIRECT),
+    ci_keyword("MIN", MIN),
+    ci_keyword("MAX", MAX),
+    ci_keyword("FIRST", FIRST),
+    ci_keyword("SECOND", SECOND),
+    cs_keyword("+-", PM), cs_keyword("-+", PM),
+
+    cs_keyword(",", COMMA),
+
+    // these letters are keywords in ADL, and so are their own tokens
+    ci_keyword("Q", LETTER_Q), // charge
+    ci_keyword("E", LETTER_E), // energy
+    ci_keyword("P", LETTER_P), // momentum
+    ci_keyword("M", LETTER_M), // mass
+};
+
+constexpr std::size_t NUM_KEYWORDS = sizeof(adl_keywords) / sizeof(adl_keywords[0]);
+
+// the hash table has a power-of-two number of slots, and keys are split over a quarter as many displacement buckets
+constexpr std::size_t KEYWORD_SLOTS = 512;
+constexpr std::size_t KEYWORD_BUCKETS = KEYWORD_SLOTS / 4;
+constexpr std::uint16_t KEYWORD_EMPTY_SLOT = 0xFFFF;
+
+constexpr char ascii_uppercase(char c) {
+    return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
+constexpr std::size_t longest_keyword() {
+    std::size_t longest = 0;
+    for (std::size_t i = 0; i < NUM_KEYWORDS; i++) {
+        if (adl_keywords[i].text.size() > longest) longest = adl_keywords[i].text.size();
+    }
+    return longest;
+}
+
+constexpr std::size_t KEYWORD_MAX_LENGTH = longest_keyword();
+
+// FNV-1a over the uppercased characters, so that every spelling of a case-insensitive keyword lands in the same place
+constexpr std::uint32_t keyword_hash(const char *text, std::size_t length) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(ascii_uppercase(text[i]));
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// final slot of a key whose bucket has been given a displacement
+constexpr std::size_t keyword_slot(std::uint32_t hash, std::uint16_t displacement) {
+    std::uint32_t mixed = hash + displacement * 0x9E3779B9u;
+    mixed ^= mixed >> 16;
+    mixed *= 0x85EBCA6Bu;
+    mixed ^= mixed >> 13;
+    return mixed & (KEYWORD_SLOTS - 1);
+}
+
+struct Keyword_table {
+    std::array<std::uint16_t, KEYWORD_BUCKETS> displacements;
+    std::array<std::uint16_t, KEYWORD_SLOTS> slots;
+    bool is_perfect;
+};
+
+/*
+Hash-and-displace construction: keys are grouped into buckets by their hash, and the largest buckets are placed first. Each bucket searches for the
+smallest displacement that sends all of its keys to distinct free slots, so a lookup is one hash, one displacement read and one comparison.
+*/
+constexpr Keyword_table build_keyword_table() {
+    Keyword_table table {};
+
+    std::array<std::uint32_t, NUM_KEYWORDS> hashes {};
+    std::array<std::size_t, KEYWORD_BUCKETS> bucket_sizes {};
+    std::array<std::size_t, KEYWORD_BUCKETS> bucket_order {};
+
+    for (std::size_t i = 0; i < KEYWORD_SLOTS; i++) table.slots[i] = KEYWORD_EMPTY_SLOT;
+
+    for (std::size_t i = 0; i < NUM_KEYWORDS; i++) {
+        hashes[i] = keyword_hash(adl_keywords[i].text.data(), adl_keywords[i].text.size());
+        bucket_sizes[hashes[i] % KEYWORD_BUCKETS]++;
+    }
+
+    // insertion sort of the buckets, largest first
+    for (std::size_t i = 0; i < KEYWORD_BUCKETS; i++) {
+        std::size_t j = i;
+        while (j > 0 && bucket_sizes[bucket_order[j-1]] < bucket_sizes[i]) {
+            bucket_order[j] = bucket_order[j-1];
+            j--;
+        }
+        bucket_order[j] = i;
+    }
+
+    for (std::size_t b = 0; b < KEYWORD_BUCKETS; b++) {
+        std::size_t bucket = bucket_order[b];
+        if (bucket_sizes[bucket] == 0) break;
+
+        bool placed = false;
+        for (std::uint16_t displacement = 0; displacement < KEYWORD_EMPTY_SLOT && !placed; displacement++) {
+
+            std::array<std::size_t, NUM_KEYWORDS> trial {};
+            std::size_t num_trial = 0;
+            bool fits = true;
+
+            for (std::size_t i = 0; i < NUM_KEYWORDS && fits; i++) {
+                if (hashes[i] % KEYWORD_BUCKETS != bucket) continue;
+
+                std::size_t slot = keyword_slot(hashes[i], displacement);
+                if (table.slots[slot] != KEYWORD_EMPTY_SLOT) fits = false;
+                for (std::size_t t = 0; t < num_trial; t++) {
+                    if (trial[t] == slot) fits = false;
+                }
+                trial[num_trial++] = slot;
+            }
+
+            if (!fits) continue;
+
+            num_trial = 0;
+            for (std::size_t i = 0; i < NUM_KEYWORDS; i++) {
+                if (hashes[i] % KEYWORD_BUCKETS != bucket) continue;
+                table.slots[trial[num_trial++]] = static_cast<std::uint16_t>(i);
+            }
+            table.displacements[bucket] = displacement;
+            placed = true;
+        }
+
+        if (!placed) return table;
+    }
+
+    table.is_perfect = true;
+    return table;
+}
+
+constexpr Keyword_table keyword_table = build_keyword_table();
+
+static_assert(keyword_table.is_perfect, "No displacement places every ADL keyword in its own slot - increase KEYWORD_SLOTS");
+
+// Give the keyword type of a token, or LEXER_ERROR if the token is not a reserved word or symbol
+inline Token_type lookup_keyword(const char *text, std::size_t length) {
+    if (length == 0 || length > KEYWORD_MAX_LENGTH) return LEXER_ERROR;
+
+    std::uint32_t hash = keyword_hash(text, length);
+    std::uint16_t index = keyword_table.slots[keyword_slot(hash, keyword_table.displacements[hash % KEYWORD_BUCKETS])];
+    if (index == KEYWORD_EMPTY_SLOT) return LEXER_ERROR;
+
+    const Keyword &keyword = adl_keywords[index];
+    if (keyword.text.size() != length) return LEXER_ERROR;
+
+    for (std::size_t i = 0; i < length; i++) {
+        char c = keyword.case_sensitive ? text[i] : ascii_uppercase(text[i]);
+        if (c != keyword.text[i]) return LEXER_ERROR;
+    }
+
+    return keyword.type;
+}
+
+inline Token_type lookup_keyword(const std::string &token) {
+    return lookup_keyword(token.data(), token.size());
+}
+
+#endif
@@ -1,64 +1,171 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "source_buffer.hpp"
+#include "symbol_table.hpp"
 #include "tokens.hpp"
-#include <regex>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <istream>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
 
+// The name of a token type, as it is printed
+std::string token_type_to_string(Token_type type);
+
 class Token {
     private:
         Token_type type;
-        std::string lexeme;
+        // A view into the SourceBuffer the token was lexed from
+        std::string_view lexeme;
+        Symbol symbol;
         int line_number;
         int column_number;
     public:
         Token(Token_type);
-        void set_data(int line, int column, std::string actual_lexeme);
-        int get_line();
-        int get_column();
-        Token_type get_token_type();
-        std::string get_token_type_as_string();
-        std::string get_lexeme();
+        void set_data(int line, int column, std::string_view actual_lexeme, Symbol actual_symbol);
+        int get_line() const;
+        int get_column() const;
+        Token_type get_token_type() const;
+        std::string get_token_type_as_string() const;
+        std::string get_lexeme() const;
+        std::string_view get_lexeme_view() const;
+        Symbol get_symbol() const;
 };
 
+// Tokens are addressed by their position in the TokenArena
+typedef std::uint32_t Token_index;
+
+// Refers to the shared end of file token, which is not stored in any arena
+constexpr Token_index END_OF_FILE_INDEX = UINT32_MAX;
+// Held by a handle that refers to no token at all
+constexpr Token_index NO_TOKEN_INDEX = UINT32_MAX - 1;
+
+class TokenArena;
+
+// A lightweight, copyable reference to a token in a TokenArena: an arena pointer and an index, with no refcount.
+// A default-constructed handle refers to no token at all.
+class TokenHandle {
+    private:
+        const TokenArena *arena;
+        Token_index index;
+    public:
+        TokenHandle();
+        TokenHandle(const TokenArena *in_arena, Token_index in_index);
+
+        const Token *operator->() const;
+        const Token &operator*() const;
+        explicit operator bool() const;
+
+        Token_index get_index() const;
+};
+
+typedef TokenHandle PToken;
+
+// Every token of one source, stored contiguously in lexing order, together with the source they view into
+class TokenArena {
+    private:
+        std::vector<Token> tokens;
+        PSource source;
+        // Lines read from a stream or edited in, rather than held by the SourceBuffer; a deque, so earlier lines never move as it grows
+        std::deque<std::string> streamed_lines;
+
+        static const Token end_of_file_token;
+
+    public:
+        TokenArena(PSource in_source);
+
+        Token_index add(Token_type type, int line, int column, std::string_view lexeme);
+        // Add a token whose lexeme has already been interned
+        Token_index add(Token_type type, int line, int column, std::string_view lexeme, Symbol symbol);
+        void reserve(Token_index count);
+        Token_index size() const;
+        PToken get(Token_index index) const;
+        PSource get_source() const;
+        std::string_view retain_line(std::string line);
+
+        Token_index first_on_line(int line) const;
+        // The tokens taken out are added to `removed`, if given
+        void splice(Token_index first, Token_index last, const TokenArena &replacement, int line_shift, TokenArena *removed = nullptr);
+
+        static const Token &get_end_of_file();
+        static PToken end_of_file();
+
+        friend class TokenHandle;
+};
+
+// The outcome of re-lexing part of the input: tokens [first, first + removed) of the old arena were replaced by
+// tokens [first, first + inserted) of the new one, and every later token moved along by inserted - removed
+struct Token_splice {
+    Token_index first;
+    Token_index removed;
+    Token_index inserted;
+};
+
+// How many parser-visible tokens the lexer can hold ahead of the parser, the most that peek() can look
+constexpr std::size_t LOOKAHEAD_CAPACITY = 4;
+
 class Lexer {
     private:
-        Token_type identify_token(std::string &token);
-        void lex_token(std::string &token, int &line_number, int &column_number);
-        std::vector<std::shared_ptr<Token>> tokens;
-        std::vector<std::shared_ptr<Token>> non_whitespace_tokens;
-        std::vector<std::shared_ptr<Token>>::iterator current_token;
-        bool verbose;
-        bool is_symbol (char c);
-        bool is_delimiter (char c);
-        std::string convert_to_uppercase(std::string &input);
+        Token_type identify_token(std::string_view token);
+        void lex_token(std::string_view token, int line_number, int column_number);
+        void lex_line(std::string_view content);
+        void lex_lines(std::string_view text);
+        bool lex_next_line();
+        bool fill_lookahead(std::size_t count);
 
+        std::shared_ptr<TokenArena> tokens;
+        // What the last relex_lines replaced, for undo_relex to put back
+        std::unique_ptr<TokenArena> relex_removed;
+        Token_splice relex_splice;
+        int relex_line_shift;
+        // Where further lines come from when streaming, or null once everything is in the arena
+        std::istream *stream;
+        int line;
 
-        std::regex reg_int;
-        std::regex reg_decimal;
-        std::regex reg_scientific;
-        std::regex reg_varname;
-        std::regex reg_string;
+        // The next arena token that has not yet been passed through the whitespace filter
+        Token_index next_unfiltered;
+        // Ring buffer of filtered tokens that have been lexed but not yet consumed by next()
+        std::array<Token_index, LOOKAHEAD_CAPACITY> lookahead;
+        std::size_t lookahead_start;
+        std::size_t lookahead_count;
 
-        std::regex reg_whitespace;
+        bool verbose;
+        bool is_symbol (char c);
+        bool is_delimiter (char c);
+        Token_type scan_literal(std::string_view token);
 
     public: 
         Lexer();
         void reset();
-        std::shared_ptr<Token> next();
+        PToken next();
 
         void expect_and_consume(Token_type type);
         void expect_and_consume(Token_type type, std::string error);
 
-        std::shared_ptr<Token> peek(int lookahead);
+        PToken peek(int lookahead);
         void read_lines(std::string filename, bool is_verbose = false);
+        void read_source(PSource in_source, bool is_verbose = false);
+        void open_stream(std::istream &in, bool is_verbose = false);
+        Token_splice relex_lines(int first_line, int last_line, std::string replacement);
+        // Put back the tokens the last relex_lines replaced, as if it had never been called
+        void undo_relex();
+        std::shared_ptr<const TokenArena> get_tokens();
         void print();
-        void erase_whitespace();
-};
-
-typedef std::shared_ptr<Token> PToken;
 
+        // Lex whatever is left of a streamed input, so that every token is in the arena
+        void lex_remaining();
+        // A lexer with a position of its own over the same tokens, which must already all be lexed
+        std::unique_ptr<Lexer> replay() const;
+        // The arena index of the token that next() would give, or END_OF_FILE_INDEX if the input is over
+        Token_index position();
+        // Carry on from the given arena token, as if every token before it had been consumed
+        void seek(Token_index index);
+        // One past the last arena token that has been looked at, through peek() or next()
+        Token_index get_furthest_read() const;
+};
 
-#endif
\ No newline at end of file
+#endif
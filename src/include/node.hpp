@@ -1,6 +1,9 @@
 #ifndef NODE_H
 #define NODE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -107,50 +110,127 @@ enum AST_type{
 
 };
 
+// The number of AST types, for tables indexed by AST_type
+constexpr std::size_t NUM_AST_TYPES = USER_FUNCTION + 1;
+
+// The name of an AST type, as it is printed
+std::string AST_type_to_string(AST_type type);
+
+class Node;
+
+// Nodes are owned by the NodeArena of their Tree, and referred to by plain pointers that stay valid as long as the Tree does
+typedef Node *PNode;
+
+// Bump allocator for the nodes of one tree, and for the child lists that outgrow their nodes.
+// Nothing is freed until the whole arena goes, all at once, with the tree.
+class NodeArena {
+    private:
+        std::vector<std::unique_ptr<std::max_align_t[]>> blocks;
+        std::size_t block_used;
+        std::size_t block_capacity;
+
+    public:
+        NodeArena();
+        NodeArena(const NodeArena &) = delete;
+        NodeArena &operator=(const NodeArena &) = delete;
+
+        void *allocate(std::size_t bytes);
+};
+
+// How many children a node holds without going back to the arena; enough for every binary operator
+constexpr std::uint32_t INLINE_CHILDREN = 3;
+
+// Child list of a node, stored in the node itself until it outgrows INLINE_CHILDREN
+class NodeChildren {
+    private:
+        std::uint32_t count;
+        std::uint32_t capacity;
+        // Null while the children still fit inline
+        PNode *overflow;
+        PNode inline_children[INLINE_CHILDREN];
+
+    public:
+        NodeChildren();
+
+        void push_back(PNode child, NodeArena &arena);
+        // Forget every child, keeping the storage for the next ones
+        void clear();
+
+        PNode *begin();
+        PNode *end();
+        std::size_t size() const;
+        bool empty() const;
+        PNode &operator[](std::size_t pos);
+        PNode &back();
+};
+
 class Node {
     private:
-        Node(AST_type in);
-        std::vector<std::shared_ptr<Node>> children;
-        std::weak_ptr<Node> m_parent;
-        int line_number;
-        int column_number;
+        Node(AST_type in, NodeArena *in_arena);
+        NodeArena *arena;
+        NodeChildren children;
+        PNode m_parent;
         AST_type type;
 
-        std::shared_ptr<Token> relevant_token;
+        PToken relevant_token;
         bool has_relevant_token;
 
-        int unique_id;
+        // Where the node was placed by the last FlatAST made of its tree, or UINT32_MAX if none has been
+        std::uint32_t flat_position;
 
     public:
-        Node(AST_type in, std::shared_ptr<Node> parent);
-        Node(AST_type in, std::shared_ptr<Node> parent, std::shared_ptr<Token> tok);
+        Node(AST_type in, PNode parent);
+        Node(AST_type in, PNode parent, PToken tok);
         
-        void set_parent(std::shared_ptr<Node> parent);
-        std::weak_ptr<Node> get_parent();
+        void set_parent(PNode parent);
+        PNode get_parent();
 
-        void add_child(std::shared_ptr<Node> child);
-        std::vector<std::shared_ptr<Node>> &get_children();
+        void add_child(PNode child);
+        void clear_children();
+        NodeChildren &get_children();
         
-        void set_token(std::shared_ptr<Token> tok);
-        std::shared_ptr<Token> get_token();
+        void set_token(PToken tok);
+        PToken get_token();
         bool has_token();
+        Symbol get_symbol();
 
         AST_type get_ast_type();
         std::string get_ast_type_as_string();
+
+        std::uint32_t get_flat_position();
         
         friend class Tree;
+        friend class FlatAST;
+        friend PNode make_node(AST_type in, PNode parent);
+        friend PNode make_node(AST_type in, PNode parent, PToken tok);
 };
 
-typedef std::shared_ptr<Node> PNode;
+// Create a node in the same arena as its parent
+PNode make_node(AST_type in, PNode parent);
+PNode make_node(AST_type in, PNode parent, PToken tok);
+
+class FlatAST;
 
 class Tree {
     private:
-        std::shared_ptr<Node> root;
+        // Every node of the tree, root included, lives in this arena
+        std::unique_ptr<NodeArena> nodes;
+        PNode root;
+        // The tokens of the tree live in this arena, so it must live as long as the tree does
+        std::shared_ptr<const TokenArena> tokens;
+        // Arenas retained before, which nodes left in the node arena, such as blocks a reparse discarded, may still refer to
+        std::vector<std::shared_ptr<const TokenArena>> earlier_tokens;
+        // Arenas taken over from other trees, whose nodes may have been grafted onto this one
+        std::vector<std::unique_ptr<NodeArena>> adopted_nodes;
 
     public:
         Tree(AST_type in);
-        std::shared_ptr<Node> get_root();
+        PNode get_root();
+        void retain_tokens(std::shared_ptr<const TokenArena> in_tokens);
+        // Take over every node of another tree, so that its subtrees can be moved onto this one; the other tree must not be used again
+        void adopt_nodes(Tree &other);
+        FlatAST flatten();
 
 };
 
-#endif
\ No newline at end of file
+#endif
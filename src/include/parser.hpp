@@ -2,14 +2,64 @@
 #define PARSER_H
 
 #include "lexer.hpp"
+#include "flat_ast.hpp"
 #include "node.hpp"
 
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The tokens that one top-level block was parsed from, as arena indices
+struct Block_span {
+    // The first token of the block
+    Token_index start;
+    // The token after the block, or the arena size if the block ends the input
+    Token_index end;
+    // One past the last token the parser looked at while parsing the block, which is beyond the end
+    Token_index reach;
+};
+
+// A block parsed ahead of the BLOCKS loop, to be taken as it is if the loop reaches its start
+struct Parsed_block {
+    PNode block = nullptr;
+    Block_span span = {0, 0, 0};
+    bool used = false;
+};
+
+// The top-level blocks an incremental reparse threw away, and those it parsed in their place.
+// Every other block of the tree is the very same node as before.
+struct Block_changes {
+    std::vector<PNode> removed;
+    std::vector<PNode> inserted;
+};
+
+// An operator of parse_operator_expression still waiting for its right operand, or, with no operator node, a
+// parenthesis still open, holding the minimum binding power to go back to once it closes
+struct Pending_operator {
+    PNode lhs;
+    PNode op_node;
+    int min_power;
+};
+
+// Bumped whenever a change to the grammar changes the trees built from the same input
+constexpr std::uint32_t PARSER_VERSION = 1;
+
 class Parser {
     private:
         std::unique_ptr<Lexer> lexer;
         Tree tree;
+        // The tokens of each child of the root, in the same order
+        std::vector<Block_span> block_spans;
+        // The source of a tree that was not parsed here, to be lexed if it is ever edited
+        PSource unlexed_source;
+        // Shared by every call of parse_operator_expression, each above the entries of the calls it is nested in
+        std::vector<Pending_operator> operator_stack;
 
         void parse_blocks(PNode parent);
+        PNode parse_block(PNode parent);
+        Block_span finish_block_span(Token_index start);
+        void parse_blocks_reusing(std::vector<Parsed_block> &ready, std::vector<PNode> *parsed);
 
         PNode parse_info(PNode parent);
         PNode parse_region(PNode parent);
@@ -54,7 +104,7 @@ class Parser {
 
         void parse_histogram(PNode parent);
 
-        PNode precedence_climber(PNode parent, int min_precedence);
+        PNode parse_operator_expression(PNode parent, int min_power);
         PNode parse_primary_expression(PNode parent);
         PNode parse_expression(PNode parent);
 
@@ -70,19 +120,25 @@ class Parser {
         PNode parse_region_command_weight(PNode parent);
         PNode parse_region_command_histo(PNode parent);
 
-        void print_children_and_yourself(PNode node, int *top_number);
-
-
     public:
         Parser(Lexer *lex);
         
         void parse();
+        // Parse the top-level blocks on up to the given number of threads, giving the same tree as parse()
+        void parse_parallel(unsigned threads);
+        // Edit lines of the input and parse again only the top-level blocks the edit touches, as Lexer::relex_lines edits the tokens
+        Block_changes reparse_lines(int first_line, int last_line, std::string replacement);
+        // Give the source that a tree put in place by other means, such as the AST cache, was built from, for reparse_lines to edit
+        void set_unlexed_source(PSource source);
 
         void parse_input();
 
         void print_parse_dot();
+        void print_parse_dot(std::ostream &out);
 
         PNode get_root();
+        Tree &get_tree();
+        FlatAST get_flat_ast();
 
 
 };
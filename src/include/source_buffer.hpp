@@ -0,0 +1,35 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// The full text of one ADL source, held in place for as long as anything refers to it.
+// Token lexemes are views into this buffer, so it is shared between the Lexer and the Tree built from its tokens.
+class SourceBuffer {
+    private:
+        const char *data;
+        std::size_t size;
+        bool is_mapped;
+        // Backing store for sources that cannot be mapped, such as pipes and stdin
+        std::string owned_contents;
+
+        void read_stream(std::istream &in);
+
+    public:
+        SourceBuffer(std::string filename);
+        SourceBuffer(std::istream &in);
+        ~SourceBuffer();
+
+        SourceBuffer(const SourceBuffer &) = delete;
+        SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+        std::string_view get_contents() const;
+        bool is_memory_mapped() const;
+};
+
+typedef std::shared_ptr<const SourceBuffer> PSource;
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// An interned string: equal symbols always have equal text, so they can be compared and hashed as integers
+typedef std::uint32_t Symbol;
+
+// Carried by tokens that are never interned, such as whitespace and comments
+constexpr Symbol NO_SYMBOL = UINT32_MAX;
+
+// Interns every distinct string once, for the lexer, the parser and the ALIL alike
+class SymbolTable {
+    private:
+        // A deque, so that the interned text never moves as more is added; the index keys are views into it
+        std::deque<std::string> texts;
+        std::unordered_map<std::string_view, Symbol> index;
+
+        // Only taken while the table is shared between threads, so that the lexer never pays for it
+        mutable std::shared_mutex mutex;
+        std::atomic<bool> shared_between_threads{false};
+
+        Symbol intern_locked(std::string_view text);
+
+    public:
+        Symbol intern(std::string_view text);
+        // The symbol of text already interned, or NO_SYMBOL; never adds the text
+        Symbol find(std::string_view text) const;
+        const std::string &get_text(Symbol symbol) const;
+        std::size_t size() const;
+
+        // Make the table safe to use from several threads at once, or stop doing so; only call this while a single thread uses it
+        void share_between_threads(bool shared);
+};
+
+// The single table shared by the whole pipeline
+SymbolTable &get_symbol_table();
+
+inline Symbol intern_symbol(std::string_view text) {
+    return get_symbol_table().intern(text);
+}
+
+inline Symbol find_symbol(std::string_view text) {
+    return get_symbol_table().find(text);
+}
+
+inline const std::string &symbol_text(Symbol symbol) {
+    return get_symbol_table().get_text(symbol);
+}
+
+#endif
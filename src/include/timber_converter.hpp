@@ -13,7 +13,7 @@ class TimberConverter : public ALILToFrameworkCompiler {
     private:
 
         std::vector<std::string> existing_definitions;
-        std::unordered_map<std::string, std::string> var_mappings;
+        std::unordered_map<Symbol, std::string> var_mappings;
         std::unordered_map<std::string, std::vector<std::string>> region_groups;
 
         std::unordered_set<std::string> empty_union_names;
@@ -25,35 +25,40 @@ class TimberConverter : public ALILToFrameworkCompiler {
         std::unordered_map<std::string, std::vector<std::string>> comb_map;
 
         std::string met_name;
+
+        // Each argument symbol seen so far, by symbol, with the characters Python names cannot hold replaced; NO_SYMBOL if not seen yet
+        std::vector<Symbol> python_names;
+        Symbol python_name(Symbol symbol);
  
-        std::string command_convert(AnalysisCommand command);
+        std::string command_convert(const AnalysisCommand &original);
 
 
         std::string lorentzify(std::string name);
-        std::string binary_command(AnalysisCommand command, std::string op);
+        std::string binary_command(const AnalysisCommand &command, std::string op);
 
         std::string generate_4vector_label(std::string input, std::string prefix, std::string suffix);
         std::string generate_4vector_label(std::string input, std::string suffix);
 
-        void append_4vector_label(AnalysisCommand command, std::string suffix, std::string suffix_if_lv = "");
-        void append_4vector_label(AnalysisCommand command, std::string prefix, std::string suffix, std::string prefix_if_lv, std::string suffix_if_lv);
+        void append_4vector_label(const AnalysisCommand &command, std::string suffix, std::string suffix_if_lv = "");
+        void append_4vector_label(const AnalysisCommand &command, std::string prefix, std::string suffix, std::string prefix_if_lv, std::string suffix_if_lv);
 
-        std::string one_argument_function(AnalysisCommand command, std::string function_name);
-        std::string sub_particle(AnalysisCommand command, std::string name);
-        std::string add_particle(AnalysisCommand command, std::string name, bool negative = false);
-        std::string index_particle(AnalysisCommand command, bool is_named, std::string part_text);
+        std::string one_argument_function(const AnalysisCommand &command, std::string function_name);
+        std::string sub_particle(const AnalysisCommand &command, std::string name);
+        std::string add_particle(const AnalysisCommand &command, std::string name, bool negative = false);
+        std::string index_particle(const AnalysisCommand &command, bool is_named, std::string part_text);
         std::string existing_definitions_string();
-        std::string add_all_relevant_tags_for_object(AnalysisCommand command);
+        std::string add_all_relevant_tags_for_object(const AnalysisCommand &command);
 
-        std::string add_all_relevant_tags_for_union_merge(AnalysisCommand command, std::string adding_name);
-        std::string add_all_relevant_tags_for_union_empty(AnalysisCommand command);
+        std::string add_all_relevant_tags_for_union_merge(const AnalysisCommand &command, std::string adding_name);
+        std::string add_all_relevant_tags_for_union_empty(const AnalysisCommand &command);
 
-        std::string add_structure_for_comb_empty(AnalysisCommand command);
-        std::string add_structure_for_comb_merge(AnalysisCommand command, std::string adding_name);
+        std::string add_structure_for_comb_empty(const AnalysisCommand &command);
+        std::string add_structure_for_comb_merge(const AnalysisCommand &command, std::string adding_name);
         std::string add_comb_argument(std::string new_name, std::string name_of_comb, std::string val, bool disjoint=false);
 
 
         std::string get_mapping_if_exists(std::string str);
+        std::string get_mapping_if_exists(Symbol symbol);
 
 
     public:
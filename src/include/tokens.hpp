@@ -1,6 +1,8 @@
 #ifndef TOKENS_H
 #define TOKENS_H
 
+#include <cstddef>
+
 enum Token_type {
     LEXER_ERROR, // type to signify that a lexing error has occurred
     LEXER_COMMENT,
@@ -236,4 +238,7 @@ enum Token_type {
 
 };
 
+// The number of token types, for tables indexed by Token_type
+constexpr std::size_t NUM_TOKEN_TYPES = HID + 1;
+
 #endif
@@ -1,327 +1,336 @@
 #include "lexer.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <iostream>
+#include <istream>
 #include <iterator>
 #include <memory>
 #include <ostream>
-#include <regex>
 #include <sstream>
 #include <vector>
 
+#include "char_scan.hpp"
 #include "exceptions.hpp"
+#include "keywords.hpp"
 #include "tokens.hpp"
 
-Token::Token(Token_type in): type(in) {}
+Token::Token(Token_type in): type(in), symbol(NO_SYMBOL), line_number(0), column_number(0) {}
 
-void Token::set_data(int line, int column, std::string actual_lexeme) {
+void Token::set_data(int line, int column, std::string_view actual_lexeme, Symbol actual_symbol) {
     line_number = line;
     column_number = column;
     lexeme = actual_lexeme;
+    symbol = actual_symbol;
 }
 
-int Token::get_line() {
+int Token::get_line() const {
     return line_number;
 }
-int Token::get_column() {
+int Token::get_column() const {
     return column_number;
 }
-Token_type Token::get_token_type() {
+Token_type Token::get_token_type() const {
     return type;
 }
-std::string Token::get_lexeme() {
+std::string Token::get_lexeme() const {
+    return std::string(lexeme);
+}
+std::string_view Token::get_lexeme_view() const {
     return lexeme;
 }
+Symbol Token::get_symbol() const {
+    return symbol;
+}
 
-// Is the character an inherently delimiting symbol?
-bool Lexer::is_symbol (char c) {
-    if (c == '=' || c == '!' || c == '!' || c == '~' || c == '<' || c == '>' || c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}' || c == ':' || c == '&' || c == '|' || c == '+' || c == '-' || c == '*' || c == '/' || c == '?' || c == '^' || c == ',' || c == '.') return true;
-    return false;
+TokenHandle::TokenHandle(): arena(nullptr), index(NO_TOKEN_INDEX) {}
+
+TokenHandle::TokenHandle(const TokenArena *in_arena, Token_index in_index): arena(in_arena), index(in_index) {}
+
+const Token *TokenHandle::operator->() const {
+    return &**this;
 }
 
-// Is the character a delimiting space?
-bool Lexer::is_delimiter (char c) {
-    std::string s(1, c);
-    if (std::regex_match(s, reg_whitespace)) return true;
+const Token &TokenHandle::operator*() const {
+    if (index == END_OF_FILE_INDEX) return TokenArena::get_end_of_file();
+    return arena->tokens[index];
+}
 
-    return false;
+TokenHandle::operator bool() const {
+    return index != NO_TOKEN_INDEX;
 }
 
-std::string Lexer::convert_to_uppercase(std::string &input) {
-    std::string uppercase;
-    for (auto it = input.begin(); it != input.end(); ++it) {
-            char c = *it;
+Token_index TokenHandle::get_index() const {
+    return index;
+}
 
-            // If lowercase ASCII letter, make it uppercase
-            if (c >= 'a' && c <= 'z') c -= 32;
+// Shared by every lexer, so that running off the end never needs a fresh allocation
+const Token TokenArena::end_of_file_token(LEXER_END_OF_FILE);
 
-            uppercase += c;
-        }
-    return uppercase;
+TokenArena::TokenArena(PSource in_source): source(in_source) {}
+
+Token_index TokenArena::add(Token_type type, int line, int column, std::string_view lexeme) {
+    Symbol symbol = NO_SYMBOL;
+    switch (type) {
+        // Layout and comments never reach the parser, so there is no point interning them
+        case LEXER_ERROR: case LEXER_NEWLINE: case LEXER_COMMENT: case LEXER_SPACE:
+            break;
+        default:
+            symbol = intern_symbol(lexeme);
+            break;
+    }
+
+    return add(type, line, column, lexeme, symbol);
 }
 
-Lexer::Lexer() {
-    current_token = tokens.begin();
+Token_index TokenArena::add(Token_type type, int line, int column, std::string_view lexeme, Symbol symbol) {
+    tokens.emplace_back(type);
+    tokens.back().set_data(line, column, lexeme, symbol);
+    return tokens.size() - 1;
+}
 
-    reg_int = std::regex("-{0,1}[0-9]+");
-    reg_decimal = std::regex("-{0,1}[0-9]*\\.[0-9]+");
-    reg_scientific = std::regex("-{0,1}[0-9]+\\.{0,1}[0-9]*[Ee][-+]{0,1}[0-9]+");
-    reg_varname = std::regex("[A-Za-z][A-Za-z0-9_]*");
-    reg_string= std::regex("\"[^\"]*\"");
+void TokenArena::reserve(Token_index count) {
+    tokens.reserve(count);
+}
 
-    reg_whitespace = std::regex("\\s");
+Token_index TokenArena::size() const {
+    return tokens.size();
+}
 
+PToken TokenArena::get(Token_index index) const {
+    return TokenHandle(this, index);
 }
 
-Token_type Lexer::identify_token(std::string &token) {
-    std::string uppercase_token = convert_to_uppercase(token);
+PSource TokenArena::get_source() const {
+    return source;
+}
 
-    if (verbose) std::cout << "Lexing " << token << std::endl;
-    
-    // If we start with a hash, then this is instantly a comment
-    if (token.front() == '#') return LEXER_COMMENT;
-    if (std::regex_match(token, std::regex("\\s+"))) return LEXER_SPACE;
-
-    // Top level ADL syntax
-    if (uppercase_token == "DEF" || uppercase_token == "DEFINE") return DEF;
-    if (uppercase_token == "ALGORITHM" || uppercase_token == "ALGO" || uppercase_token == "REGION") return ALGO;
-    if (uppercase_token == "HISTOLIST") return HISTOLIST;
-    if (uppercase_token == "INFO") return ADLINFO;
-    if (uppercase_token == "OBJ" || uppercase_token == "OBJECT") return OBJ;
-    if (uppercase_token == "COMP" || uppercase_token == "COMPOSITE") return COMP;
-
-
-    if (uppercase_token == "CMD" || uppercase_token == "CUT" || uppercase_token == "SELECT") return SELECT;
-    if (uppercase_token == "REJECT") return REJEC;
-
-    // Header info tags
-    if (token == "experiment") return PAP_EXPERIMENT;
-    if (token == "id") return PAP_ID;
-    if (uppercase_token == "TITLE") return PAP_TITLE;
-    if (token == "publication") return PAP_PUBLICATION;
-    if (token == "sqrtS") return PAP_SQRTS;
-    if (token == "lumi" ) return PAP_LUMI;
-    if (token == "arXiv") return PAP_ARXIV;
-    if (token == "hepdata") return PAP_HEPDATA;
-    if (token == "doi"   ) return PAP_DOI;
-    
-    if (uppercase_token == "PARTICLE" || uppercase_token == "CANDIDATE") return PARTICLE_KEYWORD; // keyword that allows definitions to be of particles and not functions
-    if (uppercase_token == "EXTERN" || uppercase_token  == "EXTERNAL") return EXTERNAL; // keyword that allows arbitrary external functions to be included
-    if (uppercase_token == "CORRECTIONLIB") return CORRECTIONLIB;
-
-    if (token == "systematic") return SYSTEMATIC;
-    if (token == "ttree") return SYST_TTREE;
-    if (token == "weightMc") return SYST_WEIGHT_MC;
-    if (token == "weightPileup") return SYST_WEIGHT_PILEUP;
-    if (token == "weightJvt") return SYST_WEIGHT_JVT;
-    if (token == "weightLeptonSF") return SYST_WEIGHT_LEPTON_SF;
-    if (token == "weightBTagSF") return SYST_WEIGHT_BTAG_SF;
-    if (token == "RunYear") return RUNYEAR;
-    if (token == "mcChannelNumber") return MC_CHANNEL_NUMBER;
-    if (uppercase_token == "EVENTNO") return EVENT_NO;
-    if (uppercase_token == "RUNNO") return RUN_NO;
-    if (uppercase_token == "LBNO") return LB_NO;
-    if (token == "OME") return OME;
-
-    if (uppercase_token == "PRINT") return PRINT;
-    if (uppercase_token == "IF") return IF;
-    if (uppercase_token == "THEN") return THEN;
-    if (uppercase_token == "ELSE") return ELSE;
-    if (uppercase_token == "DO") return DO;
-    if (uppercase_token == "ON" || uppercase_token == "TRUE") return TRUE; 
-    if (uppercase_token == "OFF" || uppercase_token == "FALSE") return FALSE; 
-    if (uppercase_token == "NVARS") return NVARS;
-    if (uppercase_token == "ERRORS") return ERRORS;
-    if (uppercase_token == "TABLETYPE") return TABLETYPE;
-    if (uppercase_token == "TAKE"  || uppercase_token == "USING") return TAKE;
-    if (uppercase_token == "HISTO" || uppercase_token == "HIST") return HISTO;
-    if (uppercase_token == "WEIGHT") return WEIGHT;
-    if (uppercase_token == "TABLE") return TABLE;
-    if (uppercase_token == "SKIPHISTOS") return SKIP_HISTO;
-    if (uppercase_token == "SKIPEFS") return SKIP_EFFS;
-
-    // Particle types
-    if (uppercase_token == "GEN") return GEN;
-    if (uppercase_token == "ELE"|| uppercase_token == "ELECTRON"|| token == "electron") return ELECTRON;
-    if (uppercase_token == "MUO" || uppercase_token == "MUON"| token == "muon") return MUON;
-    if (uppercase_token == "TAU") return TAU;
-    if (uppercase_token == "TRK") return TRACK;
-    if (uppercase_token == "PHO" || uppercase_token == "PHOTON") return PHOTON;
-    if (uppercase_token == "JET") return JET;
-    if (uppercase_token == "FJET"|| uppercase_token == "FATJET") return FJET;
-    if (uppercase_token == "QGJET") return QGJET;
-    if (uppercase_token == "MET" || uppercase_token == "METLV") return METLV;
-
-
-    // Within-object block helper
-    if (uppercase_token == "THIS") return THIS;
+std::string_view TokenArena::retain_line(std::string line) {
+    streamed_lines.push_back(std::move(line));
+    return streamed_lines.back();
+}
 
-    
-    // Particle extra keywords
-    if (token == "daughters" || token == "constituents") return CONSTITUENTS;
+// Tokens are in line order, so the first token of a line is found by binary search; a line past the end gives size()
+Token_index TokenArena::first_on_line(int line) const {
+    auto found = std::lower_bound(tokens.begin(), tokens.end(), line, [](const Token &tok, int in_line) {
+        return tok.get_line() < in_line;
+    });
+    return found - tokens.begin();
+}
+
+// Replace tokens [first, last) with every token of the replacement, moving all tokens after them down by line_shift lines
+void TokenArena::splice(Token_index first, Token_index last, const TokenArena &replacement, int line_shift, TokenArena *removed) {
+    if (removed != nullptr) removed->tokens.insert(removed->tokens.end(), tokens.begin() + first, tokens.begin() + last);
+
+    for (Token_index i = last; i < tokens.size(); i++) {
+        Token &tok = tokens[i];
+        tok.set_data(tok.get_line() + line_shift, tok.get_column(), tok.get_lexeme_view(), tok.get_symbol());
+    }
+
+    tokens.erase(tokens.begin() + first, tokens.begin() + last);
+    tokens.insert(tokens.begin() + first, replacement.tokens.begin(), replacement.tokens.end());
+}
+
+const Token &TokenArena::get_end_of_file() {
+    return end_of_file_token;
+}
 
+PToken TokenArena::end_of_file() {
+    return TokenHandle(nullptr, END_OF_FILE_INDEX);
+}
 
-    if (uppercase_token == "BIN") return BIN;
-    if (uppercase_token == "BINS") return BINS;
+/*
+Literal scanner
+---
+
+Numbers, names, strings and whitespace are recognised by a small DFA rather than by regular expressions. Each byte is mapped to a character class, and
+the transition table is indexed by (state, class). The accepted languages are exactly those of the patterns the lexer has always used:
+
+    INTEGER     -?[0-9]+
+    DECIMAL     -?[0-9]*\.[0-9]+
+    SCIENTIFIC  -?[0-9]+\.?[0-9]*[Ee][-+]?[0-9]+
+    VARNAME     [A-Za-z][A-Za-z0-9_]*
+    STRING      "[^"]*"
+    LEXER_SPACE \s+
+
+*/
+enum Char_class : unsigned char {
+    CC_OTHER,
+    CC_DIGIT,
+    CC_EXPONENT,
+    CC_LETTER,
+    CC_UNDERSCORE,
+    CC_MINUS,
+    CC_PLUS,
+    CC_DOT,
+    CC_QUOTE,
+    CC_SPACE,
+
+    NUM_CHAR_CLASSES
+};
+
+enum Scan_state : unsigned char {
+    SCAN_START,
+    SCAN_SIGN,          // -
+    SCAN_INT,           // -12
+    SCAN_LEAD_DOT,      // -.
+    SCAN_INT_DOT,       // -12.
+    SCAN_FRAC_NO_INT,   // -.5, which can never take an exponent
+    SCAN_FRAC,          // -12.5
+    SCAN_EXP,           // -12.5e
+    SCAN_EXP_SIGN,      // -12.5e+
+    SCAN_EXP_DIGITS,    // -12.5e+3
+    SCAN_IDENT,
+    SCAN_STRING_BODY,
+    SCAN_STRING_END,
+    SCAN_SPACE,
+    SCAN_DEAD,
+
+    NUM_SCAN_STATES
+};
+
+constexpr std::array<Char_class, 256> make_char_classes() {
+    std::array<Char_class, 256> classes {};
+
+    for (int c = 0; c < 256; c++) {
+        if (c >= '0' && c <= '9') classes[c] = CC_DIGIT;
+        else if (c == 'e' || c == 'E') classes[c] = CC_EXPONENT;
+        else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) classes[c] = CC_LETTER;
+        else if (c == '_') classes[c] = CC_UNDERSCORE;
+        else if (c == '-') classes[c] = CC_MINUS;
+        else if (c == '+') classes[c] = CC_PLUS;
+        else if (c == '.') classes[c] = CC_DOT;
+        else if (c == '"') classes[c] = CC_QUOTE;
+        else if (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r') classes[c] = CC_SPACE;
+        else classes[c] = CC_OTHER;
+    }
 
-    if (token == "genPartIdx") return GENPART_IDX;
+    return classes;
+}
 
+typedef std::array<std::array<Scan_state, NUM_CHAR_CLASSES>, NUM_SCAN_STATES> Scan_table;
 
-    if (uppercase_token == "UNION") return UNION;
-    if (uppercase_token == "ALIAS") return ALIAS;
+constexpr Scan_table make_scan_table() {
+    Scan_table table {};
 
-    // Tagging functions
-    // if (uppercase_token == "BTAG") return IS_BTAG;
-    // if (uppercase_token == "CTAG") return IS_CTAG;
-    // if (uppercase_token == "TAUTAG") return IS_TAUTAG;
-    // if (uppercase_token == "FLAVOR" | uppercase_token == "BTAGGER") return FLAVOR;
+    for (int state = 0; state < NUM_SCAN_STATES; state++) {
+        for (int cc = 0; cc < NUM_CHAR_CLASSES; cc++) {
+            table[state][cc] = SCAN_DEAD;
+        }
+    }
 
-    // Id functions
-    if (uppercase_token == "PDGID" || uppercase_token == "PDG_ID") return PDG_ID;
-    // if (uppercase_token == "JETID") return JET_ID;
+    table[SCAN_START][CC_MINUS] = SCAN_SIGN;
+    table[SCAN_START][CC_DIGIT] = SCAN_INT;
+    table[SCAN_START][CC_DOT] = SCAN_LEAD_DOT;
+    table[SCAN_START][CC_LETTER] = SCAN_IDENT;
+    table[SCAN_START][CC_EXPONENT] = SCAN_IDENT;
+    table[SCAN_START][CC_QUOTE] = SCAN_STRING_BODY;
+    table[SCAN_START][CC_SPACE] = SCAN_SPACE;
 
+    table[SCAN_SIGN][CC_DIGIT] = SCAN_INT;
+    table[SCAN_SIGN][CC_DOT] = SCAN_LEAD_DOT;
 
-    if (uppercase_token == "STATUSFLAGS") return STATUS_FLAGS;
+    table[SCAN_INT][CC_DIGIT] = SCAN_INT;
+    table[SCAN_INT][CC_DOT] = SCAN_INT_DOT;
+    table[SCAN_INT][CC_EXPONENT] = SCAN_EXP;
 
-    if (uppercase_token == "ISTIGHT" ) return IS_TIGHT;
-    if (uppercase_token == "ISMEDIUM") return IS_MEDIUM;
-    if (uppercase_token == "ISLOOSE" ) return IS_LOOSE;
+    table[SCAN_LEAD_DOT][CC_DIGIT] = SCAN_FRAC_NO_INT;
 
-    if (uppercase_token == "MINIISO") return MINI_ISO;
-    if (uppercase_token == "ABSISO") return ABS_ISO;
+    table[SCAN_INT_DOT][CC_DIGIT] = SCAN_FRAC;
+    table[SCAN_INT_DOT][CC_EXPONENT] = SCAN_EXP;
 
-    if (token == "dxy"||uppercase_token == "D0") return DXY;
-    if (token == "dz") return DZ;
+    table[SCAN_FRAC_NO_INT][CC_DIGIT] = SCAN_FRAC_NO_INT;
 
-    if (uppercase_token == "PHI") return PHI;//functions
-    if (uppercase_token == "ETA") return ETA;
-    if (uppercase_token == "RAP") return RAPIDITY;
+    table[SCAN_FRAC][CC_DIGIT] = SCAN_FRAC;
+    table[SCAN_FRAC][CC_EXPONENT] = SCAN_EXP;
 
-    if (uppercase_token == "CHARGE") return CHARGE;
-    if (uppercase_token == "MASS") return MASS;
+    table[SCAN_EXP][CC_MINUS] = SCAN_EXP_SIGN;
+    table[SCAN_EXP][CC_PLUS] = SCAN_EXP_SIGN;
+    table[SCAN_EXP][CC_DIGIT] = SCAN_EXP_DIGITS;
 
-    if (uppercase_token == "MSOFTDROP") return MSOFTDROP;
+    table[SCAN_EXP_SIGN][CC_DIGIT] = SCAN_EXP_DIGITS;
 
-    if (uppercase_token == "THETA") return THETA;
+    table[SCAN_EXP_DIGITS][CC_DIGIT] = SCAN_EXP_DIGITS;
 
-    if (uppercase_token == "PT") return PT;
-    if (uppercase_token == "PZ") return PZ;
-    if (uppercase_token == "DR" || uppercase_token == "DELTAR") return DR;
-    if (uppercase_token == "DPHI" || uppercase_token == "DELTAPHI") return DPHI;
-    if (uppercase_token == "DETA" || uppercase_token == "DELTAETA") return DETA;
+    table[SCAN_IDENT][CC_LETTER] = SCAN_IDENT;
+    table[SCAN_IDENT][CC_EXPONENT] = SCAN_IDENT;
+    table[SCAN_IDENT][CC_DIGIT] = SCAN_IDENT;
+    table[SCAN_IDENT][CC_UNDERSCORE] = SCAN_IDENT;
 
-    if (uppercase_token == "DISTINCT") return DISTINCT;
+    // anything but a quote continues the string, and nothing may follow the closing quote
+    for (int cc = 0; cc < NUM_CHAR_CLASSES; cc++) {
+        table[SCAN_STRING_BODY][cc] = SCAN_STRING_BODY;
+    }
+    table[SCAN_STRING_BODY][CC_QUOTE] = SCAN_STRING_END;
 
-    if (uppercase_token == "DRHADAMARD" || uppercase_token == "DELTARHADAMARD") return DR_HADAMARD;
-    if (uppercase_token == "DETAHADAMARD" || uppercase_token == "DELTAETAHADAMARD") return DETA_HADAMARD;
-    if (uppercase_token == "DPHIHADAMARD" || uppercase_token == "DELTAPHIHADAMARD") return DPHI_HADAMARD;
+    table[SCAN_SPACE][CC_SPACE] = SCAN_SPACE;
 
-    if (uppercase_token == "SIZE" || uppercase_token == "COUNT" || uppercase_token == "NUMOF") return NUMOF;//no arg funcs 
+    return table;
+}
 
-    // Global analysis tokens
-    if (uppercase_token == "ALL") return ALL;
-    if (uppercase_token == "NONE") return NONE;
+constexpr std::array<Token_type, NUM_SCAN_STATES> make_scan_accepts() {
+    std::array<Token_type, NUM_SCAN_STATES> accepts {};
 
-    // Comparison operators
-    if (token == "=="|| uppercase_token == "EQ") return EQ;
-    if (token == "!="|| uppercase_token == "NE") return NE;
-    if (token == "~!") return MAXIMIZE;
-    if (token == "~=") return MINIMIZE;
-    if (token == "<="|| uppercase_token == "LE") return LE;
-    if (token == ">="|| uppercase_token == "GE") return GE;
-    if (token == "<"|| uppercase_token == "LT") return LT;
-    if (token == ">"|| uppercase_token == "GT") return GT;
+    for (int state = 0; state < NUM_SCAN_STATES; state++) {
+        accepts[state] = LEXER_ERROR;
+    }
 
-    // Logical operators
-    if (uppercase_token == "AND" || token == "&&") return AND;
-    if (uppercase_token == "OR" || token == "||") return OR;
-    if (uppercase_token == "NOT") return NOT;
-    if (uppercase_token == "WITHIN" || uppercase_token == "IN") return WITHIN;
-    if (uppercase_token == "OUTSIDE") return OUTSIDE;
+    accepts[SCAN_INT] = INTEGER;
+    accepts[SCAN_FRAC_NO_INT] = DECIMAL;
+    accepts[SCAN_FRAC] = DECIMAL;
+    accepts[SCAN_EXP_DIGITS] = SCIENTIFIC;
+    accepts[SCAN_IDENT] = VARNAME;
+    accepts[SCAN_STRING_END] = STRING;
+    accepts[SCAN_SPACE] = LEXER_SPACE;
 
-    
-    if (token == "-") return MINUS;
-    if (token == "+") return PLUS;
-    if (token == "*") return MULTIPLY;
-    if (token == "/") return DIVIDE;
-
-    if (token == "&") return AMPERSAND;
-    if (token == "|") return PIPE;
-    if (token == ":") return COLON;
-    if (token == "^") return RAISED_TO_POWER;
-
-    //  A dot, likely used to index an attribute e.g. particle.m
-    if (token == ".") return DOT_INDEX;
-    if (token == "->") return ARROW_INDEX;
-
-    if (token == "(") return OPEN_PAREN;
-    if (token == ")") return CLOSE_PAREN;
-    if (token == "[") return OPEN_SQUARE_BRACE;
-    if (token == "]") return CLOSE_SQUARE_BRACE;
-    if (token == "{") return OPEN_CURLY_BRACE;
-    if (token == "}") return CLOSE_CURLY_BRACE;
-    if (token == "?") return QUESTION;
-    if (token == "=") return ASSIGN;
-    if (token == "_") return UNDERSCORE;
-
-
-    // Purely mathematical functions
-    if (uppercase_token == "DESCEND" || uppercase_token == "DESCENDING" || uppercase_token == "DECREASING") return DESCEND;
-    if (uppercase_token == "TAN") return TAN;
-    if (uppercase_token == "SIN") return SIN;
-    if (uppercase_token == "COS") return COS;
-    if (uppercase_token == "SINH") return SINH;
-    if (uppercase_token == "COSH") return COSH;
-    if (uppercase_token == "TANH") return TANH;
-    if (uppercase_token == "EXP") return EXP;
-    if (uppercase_token == "LOG") return LOG;
-    if (uppercase_token == "ABS") return ABS;
-    if (uppercase_token == "SQRT") return SQRT;
-
-    // Functions on variable lists
-    if (uppercase_token == "AVE") return AVE;
-    if (uppercase_token == "SUM") return SUM;
-    if (uppercase_token == "ADD") return ADD;
-    if (uppercase_token == "SAVE") return SAVE;
-    if (uppercase_token == "CSV") return CSV;
-    if (uppercase_token == "ANY" || uppercase_token == "ANYOF") return ANYOF;
-    if (uppercase_token == "ALLOF" || uppercase_token ==  "ALL") return ALLOF;
-
-    if (uppercase_token == "ASCEND" || uppercase_token == "ASCENDING" || uppercase_token == "INCREASING") return ASCEND;
- 
-    if (uppercase_token == "ANYOCCURRENCES") return ANYOCCURRENCES;
-    
-    if (uppercase_token == "SORT") return SORT;
-    if (uppercase_token == "COMB" || uppercase_token=="CARTESIAN") return COMB;
-    if (uppercase_token == "DISJOINT") return DISJOINT;
-    if (uppercase_token == "DIRECT") return DIRECT;
-    if (uppercase_token == "MIN") return MIN;
-    if (uppercase_token == "MAX") return MAX;
-    if (uppercase_token == "FIRST") return FIRST;
-    if (uppercase_token == "SECOND") return SECOND;
-    if (token == "+-"|| token == "-+") return PM;
+    return accepts;
+}
 
-    if (token == ",") return COMMA;
+constexpr std::array<Char_class, 256> char_classes = make_char_classes();
+constexpr Scan_table scan_table = make_scan_table();
+constexpr std::array<Token_type, NUM_SCAN_STATES> scan_accepts = make_scan_accepts();
 
-    // these letters are keywords in ADL, and so are their own tokens
-    if (uppercase_token == "Q") return LETTER_Q; // charge
-    if (uppercase_token == "E") return LETTER_E; // energy
-    if (uppercase_token == "P") return LETTER_P; // momentum
-    if (uppercase_token == "M") return LETTER_M; // mass
+// Run the DFA over the whole token, giving the literal type it matches, or LEXER_ERROR if it matches none
+Token_type Lexer::scan_literal(std::string_view token) {
+    Scan_state state = SCAN_START;
 
-    // We have as of yet failed to lex this - if this is a number, we lex it
-    if (std::regex_match(token, reg_int)) return INTEGER;
-    if (std::regex_match(token, reg_decimal)) return DECIMAL;
-    if (std::regex_match(token, reg_scientific)) return SCIENTIFIC;
+    for (auto it = token.begin(); it != token.end() && state != SCAN_DEAD; ++it) {
+        state = scan_table[state][char_classes[static_cast<unsigned char>(*it)]];
+    }
 
-    // It definintely isn't a number - maybe it's a variable name format
-    if (std::regex_match(token, reg_varname)) return VARNAME;
+    return scan_accepts[state];
+}
 
-    // Not that either - maybe it's just a valid string
-    if (std::regex_match(token, reg_string)) return STRING;
+// Is the character an inherently delimiting symbol?
+bool Lexer::is_symbol (char c) {
+    return has_char_kind(c, CK_SYMBOL);
+}
 
-    // Not any sort of valid object, so far as this can tell. Assume this is invalid text, and end our tokenization.
-    return LEXER_ERROR;
+// Is the character a delimiting space?
+bool Lexer::is_delimiter (char c) {
+    return has_char_kind(c, CK_SPACE);
+}
+
+Lexer::Lexer(): tokens(std::make_shared<TokenArena>(nullptr)), relex_splice{0, 0, 0}, relex_line_shift(0), stream(nullptr), line(0), next_unfiltered(0), lookahead_start(0), lookahead_count(0) {}
+
+Token_type Lexer::identify_token(std::string_view token) {
+    if (verbose) std::cout << "Lexing " << token << std::endl;
+    
+    // If we start with a hash, then this is instantly a comment
+    if (token.front() == '#') return LEXER_COMMENT;
+
+    // Literal shapes are found in the same pass, and only used if no keyword claims the token first
+    Token_type literal_type = scan_literal(token);
+    if (literal_type == LEXER_SPACE) return LEXER_SPACE;
+
+    // Reserved words and symbols, through the compile-time perfect hash in keywords.hpp
+    Token_type keyword_type = lookup_keyword(token.data(), token.size());
+    if (keyword_type != LEXER_ERROR) return keyword_type;
+
+    // We have as of yet failed to lex this - it is a number, a variable name or a string if the scanner accepted it.
+    // Otherwise it is not any sort of valid object, so far as this can tell, and is LEXER_ERROR, which ends our tokenization.
+    return literal_type;
 }
 
 std::string token_type_to_string(Token_type type) {
@@ -543,177 +552,309 @@ std::string token_type_to_string(Token_type type) {
     }
 }
 
-std::string Token::get_token_type_as_string() {
+std::string Token::get_token_type_as_string() const {
     return token_type_to_string(type);
 }
 
-void Lexer::lex_token(std::string &token, int &line_number, int &column_number) {
+void Lexer::lex_token(std::string_view token, int line_number, int column_number) {
 
     // Do not lex an empty token
     if (token.size() == 0) return;
 
-    auto tok = std::make_shared<Token>(identify_token(token));
-    tok->set_data(line_number, column_number, token);
+    Token_index index = tokens->add(identify_token(token), line_number, column_number, token);
 
-    if (tok->get_token_type() == LEXER_ERROR) {
-        raise_lexing_exception(tok);
+    if (tokens->get(index)->get_token_type() == LEXER_ERROR) {
+        raise_lexing_exception(tokens->get(index));
     }
+}
 
-    tokens.push_back(tok);
+void Lexer::read_lines(std::string filename, bool is_verbose) {
+    read_source(std::make_shared<const SourceBuffer>(filename), is_verbose);
+}
 
-    // move the lexer along
-    column_number += token.length();
-    token.clear();
+void Lexer::read_source(PSource in_source, bool is_verbose) {
+
+    verbose = is_verbose;
+    tokens = std::make_shared<TokenArena>(in_source);
+    stream = nullptr;
+    line = 0;
+    reset();
+
+    lex_lines(in_source->get_contents());
 }
 
-void Lexer::read_lines(std::string filename, bool is_verbose) {
+void Lexer::lex_lines(std::string_view text) {
+    while (!text.empty()) {
+        // Split off the next line, as getline would: the newline itself is dropped, and a final newline does not start an empty line
+        std::size_t line_end = text.find('\n');
+        lex_line(text.substr(0, line_end));
+        text.remove_prefix(line_end == std::string_view::npos ? text.size() : line_end + 1);
+    }
+}
+
+/*
+Incremental re-lexing
+---
+
+No token ever spans a newline, since comments and quotes both end with their line, so the tokens of a run of lines
+can be replaced without touching any other line. The replacement text is kept by the arena for its lexemes to view,
+the lines are lexed into a scratch arena, and that is spliced in place of the old tokens of those lines.
+
+Handles into the arena taken before the splice, such as those in an AST, refer to the old token positions and
+must be refreshed from the returned Token_splice.
+
+*/
+Token_splice Lexer::relex_lines(int first_line, int last_line, std::string replacement) {
+    // A streamed input has to be complete before any of it can be edited
+    while (lex_next_line());
+
+    // An empty range, with last_line one before first_line, inserts the replacement before first_line
+    if (first_line < 1 || last_line < first_line - 1 || last_line > line) {
+        raise_editing_exception("lines " + std::to_string(first_line) + " to " + std::to_string(last_line) + " are not within the " + std::to_string(line) + " lines of the input");
+    }
+
+    int total_lines = line;
+    std::string_view text = tokens->retain_line(std::move(replacement));
+
+    std::shared_ptr<TokenArena> edited = tokens;
+    tokens = std::make_shared<TokenArena>(nullptr);
+    line = first_line - 1;
+
+    try {
+        lex_lines(text);
+    } catch (...) {
+        // A malformed token leaves the existing tokens as they were
+        tokens = edited;
+        line = total_lines;
+        throw;
+    }
+
+    std::shared_ptr<TokenArena> relexed = tokens;
+    int new_line_count = line - (first_line - 1);
+    int line_shift = new_line_count - (last_line - first_line + 1);
+
+    tokens = edited;
+    line = total_lines + line_shift;
+
+    Token_index first = tokens->first_on_line(first_line);
+    Token_index last = tokens->first_on_line(last_line + 1);
+    relex_removed = std::make_unique<TokenArena>(nullptr);
+    tokens->splice(first, last, *relexed, line_shift, relex_removed.get());
+
+    reset();
+
+    relex_splice = {first, last - first, relexed->size()};
+    relex_line_shift = line_shift;
+    return relex_splice;
+}
+
+void Lexer::undo_relex() {
+    assert(relex_removed);
+
+    tokens->splice(relex_splice.first, relex_splice.first + relex_splice.inserted, *relex_removed, -relex_line_shift);
+    line -= relex_line_shift;
+    relex_removed.reset();
+
+    reset();
+}
+
+void Lexer::open_stream(std::istream &in, bool is_verbose) {
 
     verbose = is_verbose;
+    tokens = std::make_shared<TokenArena>(nullptr);
+    stream = &in;
+    line = 0;
+    reset();
+}
 
-    std::ifstream read_file(filename);
+bool Lexer::lex_next_line() {
+    if (stream == nullptr) return false;
 
     std::string content;
+    if (!std::getline(*stream, content)) {
+        // The stream is exhausted, and everything it held is now in the arena
+        stream = nullptr;
+        return false;
+    }
 
-    int line = 0;
-    while (std::getline(read_file, content)) {
-        line++;
+    lex_line(tokens->retain_line(std::move(content)));
+    return true;
+}
 
-        std::string running_token;
+void Lexer::lex_line(std::string_view content) {
+    line++;
 
-        bool is_commented_out = false;
-        bool is_quoted_out = false;
+    // Every character of the line belongs to exactly one token, so the running token is always the span from token_start up to the current character
+    std::size_t token_start = 0;
 
-        int column = 1;
-        for (auto it = content.begin(); it != content.end(); ++it) {
-            char current_char = *it;
+    for (std::size_t i = 0; i < content.size(); ++i) {
+        char current_char = content[i];
 
-            // If we have a comment start symbol, this entire line from here on must be one comment token
-            if (current_char == '#' && !is_commented_out) {
-                lex_token(running_token, line, column);
-                is_commented_out = true;
-                running_token += current_char;
-                continue;
+        // If we have a comment start symbol, this entire line from here on must be one comment token, lexed once the line is over
+        if (current_char == '#') {
+            lex_token(content.substr(token_start, i - token_start), line, token_start + 1);
+            token_start = i;
+            break;
+        }
 
-            } else if (is_commented_out) {
-                // If this line is commented out, this is all just one comment
-                running_token += current_char;
+        if (current_char == '"') {
+            // We are now beginning a quoted scope, within which everything up to and including the closing quote is this same token
+            lex_token(content.substr(token_start, i - token_start), line, token_start + 1);
+            token_start = i;
+
+            std::size_t closing_quote = content.find_first_of("\"#", i + 1);
+            // An unclosed quote runs to the end of the line
+            if (closing_quote == std::string_view::npos) break;
+            // A comment cuts the quote short, as it would anywhere else
+            if (content[closing_quote] == '#') {
+                i = closing_quote - 1;
                 continue;
             }
 
-            // if we have a quote character, and we are in a quote scope, then we have ceased to be so.
-            if (is_quoted_out && current_char == '"') {
-                running_token += current_char;
-                lex_token(running_token, line, column);
-                is_quoted_out = false;
-                continue;
-            } else if (current_char == '"') {
-                // We are now beginning a quoted scope, within which we want to always add characters to this same token
-                lex_token(running_token, line, column);
-                is_quoted_out = true;
-                running_token += current_char;
-                continue;
-            } else if(is_quoted_out) {
-                // If we are in a quote, we simply add until the quote is over
-                running_token += current_char;
-                continue;
-            }
+            lex_token(content.substr(token_start, closing_quote + 1 - token_start), line, token_start + 1);
+            token_start = closing_quote + 1;
+            i = closing_quote;
+            continue;
+        }
 
-            bool delimiter = is_delimiter(current_char);
-            bool symbol = is_symbol(current_char);
+        // Inside a run of identifier characters or of whitespace nothing happens until the run ends, so skip straight to its end
+        if (token_start != i) {
+            char prev_char = content[i - 1];
+            std::size_t run_end = i;
 
-            if (current_char == '(' || current_char == ')' || current_char == ','|| current_char == '{' || current_char == '}' || current_char == '[' || current_char == ']') {
-                // Exception: commas and brackets of all kinds must be allowed to be stacked adjacent to whatever, and that must unequivocably be its own token - there is never a situation in which this should not be the case
-                lex_token(running_token, line, column);
-                running_token += current_char;
-                lex_token(running_token, line, column);
-                continue;
-            }
+            if (has_char_kind(prev_char, CK_IDENTIFIER)) run_end = skip_identifier_run(content.data(), i, content.size());
+            else if (has_char_kind(prev_char, CK_SPACE)) run_end = skip_space_run(content.data(), i, content.size());
 
-            // if the running string is empty, we add this character to the running string and await further input
-            if (running_token.size() <= 0) {
-                running_token += current_char;
+            if (run_end != i) {
+                i = run_end - 1;
                 continue;
             }
+        }
 
-            char prev_char = running_token.back();
+        bool delimiter = is_delimiter(current_char);
+        bool symbol = is_symbol(current_char);
+
+        if (current_char == '(' || current_char == ')' || current_char == ','|| current_char == '{' || current_char == '}' || current_char == '[' || current_char == ']') {
+            // Exception: commas and brackets of all kinds must be allowed to be stacked adjacent to whatever, and that must unequivocably be its own token - there is never a situation in which this should not be the case
+            lex_token(content.substr(token_start, i - token_start), line, token_start + 1);
+            lex_token(content.substr(i, 1), line, i + 1);
+            token_start = i + 1;
+            continue;
+        }
 
-            bool previous_delimiter = is_delimiter(prev_char);
-            bool previous_symbol = is_symbol(prev_char);
+        // if the running token is empty, this character starts it and we await further input
+        if (token_start == i) {
+            continue;
+        }
 
-            char next_char = std::next(it) != content.end() ? *std::next(it) : ' ';
+        char prev_char = content[i - 1];
 
-            // if the running token is of the same type as the current char, then we add it to the string and keep going
-            if (delimiter != previous_delimiter || symbol != previous_symbol) {
+        bool previous_delimiter = is_delimiter(prev_char);
+        bool previous_symbol = is_symbol(prev_char);
 
-                bool was_negative_sign_for_number = prev_char == '-' && current_char >= '0' && current_char <= '9';
-                bool was_decimal_point_for_number = prev_char == '.' && current_char >= '0' && current_char <= '9';
-                bool is_decimal_point_in_number = current_char == '.' && next_char <= '9' && next_char >= '0';
+        char next_char = i + 1 < content.size() ? content[i + 1] : ' ';
 
-                if (!was_negative_sign_for_number && !was_decimal_point_for_number && !is_decimal_point_in_number) {
-                    // Otherwise, we do not have compatible symbols, so this clearly must be the end of a running token
-                    lex_token(running_token, line, column);
-                }
-            } 
-            running_token = running_token + current_char;
-        }
-        // The line is over, we lex the remainder
-        lex_token(running_token, line, column);
+        // if the running token is of the same type as the current char, then we add it to the string and keep going
+        if (delimiter != previous_delimiter || symbol != previous_symbol) {
 
-        auto endline = std::make_shared<Token>(LEXER_NEWLINE);
-        endline->set_data(line, column, "\n");
-        tokens.push_back(endline);
+            bool was_negative_sign_for_number = prev_char == '-' && current_char >= '0' && current_char <= '9';
+            bool was_decimal_point_for_number = prev_char == '.' && current_char >= '0' && current_char <= '9';
+            bool is_decimal_point_in_number = current_char == '.' && next_char <= '9' && next_char >= '0';
 
-        // Return to the start of the next line
+            if (!was_negative_sign_for_number && !was_decimal_point_for_number && !is_decimal_point_in_number) {
+                // Otherwise, we do not have compatible symbols, so this clearly must be the end of a running token
+                lex_token(content.substr(token_start, i - token_start), line, token_start + 1);
+                token_start = i;
+            }
+        } 
     }
+    // The line is over, we lex the remainder
+    lex_token(content.substr(token_start), line, token_start + 1);
+
+    tokens->add(LEXER_NEWLINE, line, content.size() + 1, "\n");
+}
 
-    read_file.close();
+std::shared_ptr<const TokenArena> Lexer::get_tokens() {
+    return tokens;
 }
 
 void Lexer::print() {
-    // erase_whitespace();
+    // A streamed input is only lexed as far as it has been read, so finish it off first
+    lex_remaining();
 
-    for (auto it = tokens.begin(); it != tokens.end(); ++it) {
-        std::shared_ptr tok = *it;
+    for (Token_index i = 0; i < tokens->size(); ++i) {
+        PToken tok = tokens->get(i);
         if (tok->get_token_type() == LEXER_NEWLINE) {
             std::cout << std::endl;
             continue;
         }
-        std::cout << tok->get_token_type() << ": " << tok->get_lexeme() << "," << " ";
+        std::cout << tok->get_token_type() << ": " << tok->get_lexeme_view() << "," << " ";
     }
 }
 
-void Lexer::erase_whitespace() {
+void Lexer::lex_remaining() {
+    while (lex_next_line());
+}
+
+std::unique_ptr<Lexer> Lexer::replay() const {
+    assert(stream == nullptr);
+
+    auto copy = std::make_unique<Lexer>();
+    copy->tokens = tokens;
+    copy->line = line;
+    copy->verbose = false;
+    return copy;
+}
+
+Token_index Lexer::position() {
+    if (!fill_lookahead(1)) return END_OF_FILE_INDEX;
+    return lookahead[lookahead_start];
+}
+
+Token_index Lexer::get_furthest_read() const {
+    return next_unfiltered;
+}
+
+void Lexer::seek(Token_index index) {
+    next_unfiltered = index;
+    lookahead_start = 0;
+    lookahead_count = 0;
+}
 
-    non_whitespace_tokens.clear();
+void Lexer::reset() {
+    next_unfiltered = 0;
+    lookahead_start = 0;
+    lookahead_count = 0;
+}
 
-    for (auto it = tokens.begin(); it != tokens.end(); ++it) {
+// Make sure at least `count` parser-visible tokens are waiting in the lookahead buffer, lexing further lines on demand.
+// Returns false if the input ends first.
+bool Lexer::fill_lookahead(std::size_t count) {
+    while (lookahead_count < count) {
+        if (next_unfiltered == tokens->size() && !lex_next_line()) return false;
 
-        auto tok = *it;
-        switch (tok->get_token_type()) {
+        Token_index index = next_unfiltered++;
+        switch (tokens->get(index)->get_token_type()) {
             // If this is a whitespace or comment, don't even consider it in parsing
             case LEXER_ERROR: case LEXER_NEWLINE: case LEXER_COMMENT: case LEXER_SPACE:
                 break;
             default:
-                non_whitespace_tokens.push_back(tok);
+                lookahead[(lookahead_start + lookahead_count) % LOOKAHEAD_CAPACITY] = index;
+                lookahead_count++;
                 break;
         }
     }
-
+    return true;
 }
 
-void Lexer::reset() {
-    erase_whitespace();
-    current_token = non_whitespace_tokens.begin();
-}
+PToken Lexer::next() {
+    if (!fill_lookahead(1)) return TokenArena::end_of_file();
 
-std::shared_ptr<Token> Lexer::next() {
-    if (current_token == non_whitespace_tokens.end()) return 
-    std::make_shared<Token>(LEXER_END_OF_FILE);
+    Token_index index = lookahead[lookahead_start];
+    lookahead_start = (lookahead_start + 1) % LOOKAHEAD_CAPACITY;
+    lookahead_count--;
 
-    auto tok = *current_token;
-    ++current_token;
-
-    return tok;
+    return tokens->get(index);
 }
 
 void Lexer::expect_and_consume(Token_type type, std::string error) {
@@ -734,18 +875,12 @@ void Lexer::expect_and_consume(Token_type type) {
 }
 
 
-std::shared_ptr<Token> Lexer::peek(int lookahead) {
-    auto ahead_tok_it = current_token;
-
-    while (lookahead > 0) {
-        ++ahead_tok_it;
-        lookahead--;
-        if (ahead_tok_it == non_whitespace_tokens.end()) return 
-        std::make_shared<Token>(LEXER_END_OF_FILE);
+PToken Lexer::peek(int distance) {
+    if (static_cast<std::size_t>(distance) >= LOOKAHEAD_CAPACITY) {
+        raise_parsing_exception("Parser looked further ahead than the lexer buffers", peek(0));
     }
 
-    if (ahead_tok_it == non_whitespace_tokens.end()) return 
-    std::make_shared<Token>(LEXER_END_OF_FILE);
+    if (!fill_lookahead(distance + 1)) return TokenArena::end_of_file();
 
-    return *ahead_tok_it;
+    return tokens->get(lookahead[(lookahead_start + distance) % LOOKAHEAD_CAPACITY]);
 }
@@ -1,72 +1,201 @@
 #include "ali_converter.hpp"
+#include "alil_file.hpp"
+#include "ast_cache.hpp"
+#include "ast_writer.hpp"
 #include "coffea_converter.hpp"
 #include "config.hpp"
+#include "expression_dag.hpp"
+#include "flat_ast.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "source_buffer.hpp"
 #include "timber_converter.hpp"
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <utility>
+#include <vector>
+
+// Run the passes over the lowered commands that the config and command line ask for
+static void optimize(ALILConverter &alil, Config &config, bool keep_dead) {
+    if (config.get_argument("fold") == "on") {
+        std::size_t folded = alil.fold_constants();
+        if (folded > 0) std::cerr << "Constant folding simplified " << folded << " ALIL commands" << std::endl;
+    }
+
+    if (!keep_dead) {
+        std::size_t before = alil.get_commands().size();
+        std::size_t removed = alil.eliminate_dead_commands();
+        if (removed > 0) std::cerr << "Dead code elimination removed " << removed << " of " << before << " ALIL commands" << std::endl;
+    }
+
+    if (config.get_argument("cse") == "on") {
+        std::size_t before = alil.get_commands().size();
+        std::size_t removed = alil.eliminate_common_subexpressions();
+        std::cerr << "Common subexpression elimination removed " << removed << " of " << before << " ALIL commands" << std::endl;
+    }
+}
+
+// Print the lowered commands, or compile them for the backend the argument names
+static int emit(std::unique_ptr<ALILConverter> alil, const std::string &argument, Config &config) {
+    if (argument == "alil") {
+        alil->print_commands();
+        return 0;
+    }
+
+    if (argument == "alilbin") {
+        ALILWriter(std::cout).write_binary(alil->get_commands());
+        return 0;
+    }
+
+    std::unique_ptr<ALILToFrameworkCompiler> final_state_compiler;
+
+    if (argument == "timber") {
+        final_state_compiler = std::make_unique<TimberConverter>(alil.release(), config);
+    }
+    
+    if (argument == "coffea") {
+        final_state_compiler = std::make_unique<CoffeaConverter>(alil.release(), config);    
+    }
+
+    if (!final_state_compiler) {
+        std::cerr << "Error: invalid argument: " << argument << std::endl;
+        return -1;
+    }
+
+    final_state_compiler->print();
+    return 0;
+}
 
 int main(int argc, char** argv) {
 
     std::string argument;
 
-    if (argc < 2) {
-        std::cerr << "Usage: main FILENAME.adl [genconfig]|[timber]|[coffea]|[lex]|[parse]|[alil] " << std::endl;
+    // Flags may go anywhere on the command line; everything else is taken in order
+    bool keep_dead = false;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--keep-dead") keep_dead = true;
+        else positional.push_back(arg);
+    }
+
+    if (positional.size() < 1) {
+        std::cerr << "Usage: main [--keep-dead] FILENAME.adl|FILENAME.alil|- [genconfig]|[timber]|[coffea]|[lex]|[parse]|[parsejson]|[parsebin]|[alil]|[alilbin] " << std::endl;
         return -1;
     }
 
-    std::string filename(argv[1]);
+    std::string filename(positional[0]);
     Config config("config.txt");
 
-    if (argc > 2) argument = std::string(argv[2]);
+    if (positional.size() > 1) argument = positional[1];
     else argument = "timber";
 
     if (argument == "genconfig") {
         return 0;
     }
 
-    std::unique_ptr<Lexer> lexer = std::make_unique<Lexer>();
-
-    lexer->read_lines(filename);
+    // ALIL saved by an earlier run, as text or binary, goes straight to the backend without being lexed, parsed or lowered
+    const std::string alil_extension = ".alil";
+    if (filename.size() > alil_extension.size() && filename.compare(filename.size() - alil_extension.size(), alil_extension.size(), alil_extension) == 0) {
+        if (argument == "lex" || argument == "parse" || argument == "parsejson" || argument == "parsebin") {
+            std::cerr << "Error: " << filename << " is already lowered to ALIL, so it cannot be given to " << argument << std::endl;
+            return -1;
+        }
+
+        SourceBuffer source(filename);
+        std::unique_ptr<ALILConverter> alil = std::make_unique<ALILConverter>(config);
+        alil->load_commands(ALILReader(source.get_contents()).read());
+        optimize(*alil, config, keep_dead);
+        return emit(std::move(alil), argument, config);
+    }
 
-    if (argument == "lex") {
-        lexer->print();
-        return 0;
+    std::unique_ptr<Lexer> lexer = std::make_unique<Lexer>();
+    std::unique_ptr<Parser> parser;
+
+    // More than one parse thread splits the top-level blocks between them; the tree is the same either way
+    int parse_threads = std::atoi(config.get_argument("parsethreads").c_str());
+    auto run_parser = [parse_threads](Parser &p) {
+        if (parse_threads > 1) p.parse_parallel(parse_threads);
+        else p.parse();
+    };
+
+    // Parsed trees are cached by the contents of the file, when the config names a cache directory.
+    // A streamed input is never cached, as it would have to be read in full before parsing could start.
+    std::string cache_directory = config.get_argument("astcache");
+    if (filename != "-" && argument != "lex" && cache_directory != "none" && !cache_directory.empty()) {
+        ASTCache cache(cache_directory);
+        PSource source = std::make_shared<const SourceBuffer>(filename);
+        std::string cache_path = cache.path_for(source->get_contents());
+
+        // On a hit the file is never lexed, and the parser is only there to hold the tree
+        parser = std::make_unique<Parser>(lexer.release());
+        if (cache.load(source->get_contents(), parser->get_tree())) {
+            std::cerr << "AST cache hit: " << cache_path << std::endl;
+            parser->set_unlexed_source(source);
+        } else {
+            std::cerr << "AST cache miss: " << cache_path << std::endl;
+
+            lexer = std::make_unique<Lexer>();
+            lexer->read_source(source);
+            parser = std::make_unique<Parser>(lexer.release());
+            run_parser(*parser);
+
+            if (!cache.store(source->get_contents(), parser->get_tree())) {
+                std::cerr << "Warning: could not write the AST cache file " << cache_path << std::endl;
+            }
+        }
+    } else {
+        // A filename of "-" streams the input from stdin, lexing it only as far as the parser has asked for
+        if (filename == "-") lexer->open_stream(std::cin);
+        else lexer->read_lines(filename);
+
+        if (argument == "lex") {
+            lexer->print();
+            return 0;
+        }
+        
+        parser = std::make_unique<Parser>(lexer.release());
+        run_parser(*parser);
     }
-    
-    std::unique_ptr<Parser> parser = std::make_unique<Parser>(lexer.release());
-    parser->parse();
 
     if (argument == "parse") {
         parser->print_parse_dot();
         return 0;
     }
 
-    std::unique_ptr<ALILConverter> alil = std::make_unique<ALILConverter>(config);
-    alil->visitation(parser->get_root());
+    // Dumps of the tree for other tools to read
+    if (argument == "parsejson") {
+        ASTWriter(std::cout).write_json_lines(parser->get_root());
+        return 0;
+    }
 
-    if (argument == "alil") {
-        alil->print_commands();
+    if (argument == "parsebin") {
+        ASTWriter(std::cout).write_binary(parser->get_root());
         return 0;
     }
 
-    std::unique_ptr<ALILToFrameworkCompiler> final_state_compiler;
+    std::unique_ptr<ALILConverter> alil = std::make_unique<ALILConverter>(config);
 
-    if (argument == "timber") {
-        final_state_compiler = std::make_unique<TimberConverter>(alil.release(), config);
-    }
-    
-    if (argument == "coffea") {
-        final_state_compiler = std::make_unique<CoffeaConverter>(alil.release(), config);    
-    }
+    bool share = config.get_argument("sharedexpressions") == "on";
+    int alil_threads = std::atoi(config.get_argument("alilthreads").c_str());
 
-    if (!final_state_compiler) {
-        std::cerr << "Error: invalid argument: " << argument << std::endl;
-        return -1;
+    // The passes over the whole tree below sweep its flat copy, which is only made when one of them runs
+    std::unique_ptr<FlatAST> flat_ast;
+    if (share || alil_threads > 1) flat_ast = std::make_unique<FlatAST>(parser->get_flat_ast());
+
+    // Identical expressions are lowered once and their value reused, when the config asks for it
+    std::unique_ptr<ExpressionDAG> expressions;
+    if (share) {
+        expressions = std::make_unique<ExpressionDAG>(*flat_ast);
+        alil->share_expressions(expressions.get());
     }
 
-    final_state_compiler->print();
-    return 0;
-} 
+    // More than one ALIL thread lowers independent top-level blocks at once. The commands are the same as a serial run's
+    // when every name is defined before it is used, except with shared expressions, which are then only shared within a block.
+    if (alil_threads > 1) alil->visitation_parallel(parser->get_root(), *flat_ast, alil_threads);
+    else alil->visitation(parser->get_root());
+
+    optimize(*alil, config, keep_dead);
+    return emit(std::move(alil), argument, config);
+}
@@ -1,15 +1,94 @@
 
 #include "node.hpp"
+#include "flat_ast.hpp"
+#include <algorithm>
 #include <memory>
+#include <new>
+#include <type_traits>
 
 
 
+// Nodes own nothing outside the arena, so the arena can drop them without running any destructors
+static_assert(std::is_trivially_destructible_v<Node>);
+
+// Large enough that a typical analysis fits in a handful of blocks
+constexpr std::size_t NODE_ARENA_BLOCK_BYTES = 64 * 1024;
+
+NodeArena::NodeArena(): block_used(0), block_capacity(0) {}
+
+void *NodeArena::allocate(std::size_t bytes) {
+    // Keep every allocation aligned for anything, by handing out whole max_align_t slots
+    std::size_t slots = (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+
+    if (block_used + slots > block_capacity) {
+        block_capacity = std::max(slots, NODE_ARENA_BLOCK_BYTES / sizeof(std::max_align_t));
+        blocks.push_back(std::make_unique<std::max_align_t[]>(block_capacity));
+        block_used = 0;
+    }
+
+    void *allocation = blocks.back().get() + block_used;
+    block_used += slots;
+    return allocation;
+}
+
+NodeChildren::NodeChildren(): count(0), capacity(INLINE_CHILDREN), overflow(nullptr) {}
+
+void NodeChildren::push_back(PNode child, NodeArena &arena) {
+    if (count == capacity) {
+        // Out of room: move to a list twice the size in the arena, leaving the old one behind
+        std::uint32_t new_capacity = capacity * 2;
+        PNode *grown = static_cast<PNode *>(arena.allocate(new_capacity * sizeof(PNode)));
+        std::copy(begin(), end(), grown);
+
+        overflow = grown;
+        capacity = new_capacity;
+    }
+
+    begin()[count++] = child;
+}
+
+PNode *NodeChildren::begin() {
+    return overflow != nullptr ? overflow : inline_children;
+}
+
+PNode *NodeChildren::end() {
+    return begin() + count;
+}
+
+std::size_t NodeChildren::size() const {
+    return count;
+}
+
+void NodeChildren::clear() {
+    count = 0;
+}
+
+bool NodeChildren::empty() const {
+    return count == 0;
+}
+
+PNode &NodeChildren::operator[](std::size_t pos) {
+    return begin()[pos];
+}
+
+PNode &NodeChildren::back() {
+    return begin()[count - 1];
+}
+
 // private constructor allows node to have no parent
-Node::Node(AST_type in): type(in), has_relevant_token(false) {}
+Node::Node(AST_type in, NodeArena *in_arena): arena(in_arena), m_parent(nullptr), type(in), has_relevant_token(false), flat_position(UINT32_MAX) {}
 
-Node::Node(AST_type in, std::shared_ptr<Node> parent): type(in), m_parent(parent), has_relevant_token(false) {}
+Node::Node(AST_type in, PNode parent): arena(parent->arena), m_parent(parent), type(in), has_relevant_token(false), flat_position(UINT32_MAX) {}
 
-Node::Node(AST_type in, std::shared_ptr<Node> parent, std::shared_ptr<Token> tok): type(in), m_parent(parent), relevant_token(tok), has_relevant_token(true){}
+Node::Node(AST_type in, PNode parent, PToken tok): arena(parent->arena), m_parent(parent), type(in), relevant_token(tok), has_relevant_token(true), flat_position(UINT32_MAX) {}
+
+PNode make_node(AST_type in, PNode parent) {
+    return new (parent->arena->allocate(sizeof(Node))) Node(in, parent);
+}
+
+PNode make_node(AST_type in, PNode parent, PToken tok) {
+    return new (parent->arena->allocate(sizeof(Node))) Node(in, parent, tok);
+}
 
 
 std::string AST_type_to_string(AST_type type) {
@@ -84,24 +163,28 @@ std::string AST_type_to_string(AST_type type) {
         }
 }
 
-void Node::set_parent(std::shared_ptr<Node> in) {
+void Node::set_parent(PNode in) {
     m_parent = in;
 }
 
-std::weak_ptr<Node> Node::get_parent() {
+PNode Node::get_parent() {
     return m_parent;
 }
 
-void Node::add_child(std::shared_ptr<Node> child) {
+void Node::add_child(PNode child) {
     if (child->get_ast_type() == AST_EPSILON) return;
-    children.push_back((child));
+    children.push_back(child, *arena);
+}
+
+void Node::clear_children() {
+    children.clear();
 }
 
-std::vector<std::shared_ptr<Node>> &Node::get_children() {
+NodeChildren &Node::get_children() {
     return children;
 }
 
-void Node::set_token(std::shared_ptr<Token> tok) {
+void Node::set_token(PToken tok) {
     relevant_token = tok;
     has_relevant_token = true;
 }
@@ -110,10 +193,15 @@ bool Node::has_token() {
     return has_relevant_token;
 }
 
-std::shared_ptr<Token> Node::get_token() {
+PToken Node::get_token() {
     return relevant_token;
 }
 
+Symbol Node::get_symbol() {
+    if (!has_relevant_token) return NO_SYMBOL;
+    return relevant_token->get_symbol();
+}
+
 AST_type Node::get_ast_type() {
     return type;
 }
@@ -122,12 +210,33 @@ std::string Node::get_ast_type_as_string() {
     return AST_type_to_string(type);
 }
 
-Tree::Tree(AST_type in) {
+std::uint32_t Node::get_flat_position() {
+    return flat_position;
+}
+
+Tree::Tree(AST_type in): nodes(std::make_unique<NodeArena>()) {
     // create a node with no parent - the only node that is allowed to have this property
-    root = std::shared_ptr<Node>(new Node(in));
+    root = new (nodes->allocate(sizeof(Node))) Node(in, nodes.get());
 }
 
-std::shared_ptr<Node> Tree::get_root() {
+PNode Tree::get_root() {
     return root;
 }
 
+// Build the compact, array-based copy of this tree
+FlatAST Tree::flatten() {
+    return FlatAST(root, tokens);
+}
+
+void Tree::retain_tokens(std::shared_ptr<const TokenArena> in_tokens) {
+    if (tokens && tokens != in_tokens) earlier_tokens.push_back(tokens);
+    tokens = in_tokens;
+}
+
+void Tree::adopt_nodes(Tree &other) {
+    adopted_nodes.push_back(std::move(other.nodes));
+    for (auto &arena : other.adopted_nodes) adopted_nodes.push_back(std::move(arena));
+    other.adopted_nodes.clear();
+    other.root = nullptr;
+}
+
@@ -1,6 +1,13 @@
 #include "parser.hpp"
+#include "ast_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <iterator>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <iostream>
 
@@ -12,24 +19,24 @@
 
 
 PNode make_terminal(PNode parent, PToken tok) {
-    return PNode(std::make_shared<Node>(TERMINAL, parent, tok));
+    return PNode(make_node(TERMINAL, parent, tok));
 }
 
 void add_two_terminal_children(PNode parent, PToken one, PToken two) {
-    PNode op(std::make_shared<Node>(TERMINAL, parent));
+    PNode op(make_node(TERMINAL, parent));
     parent->add_child(op);
     op->set_token(one);
 
-    PNode source(std::make_shared<Node>(TERMINAL, parent));
+    PNode source(make_node(TERMINAL, parent));
     parent->add_child(source);
     source->set_token(two); 
 }
 
 void add_two_nested_terminal_children(PNode parent, PToken one, PToken two) {
-    PNode one_node(std::make_shared<Node>(TERMINAL, parent, one));
+    PNode one_node(make_node(TERMINAL, parent, one));
     parent->add_child(one_node);
 
-    PNode two_node(std::make_shared<Node>(TERMINAL, one_node, two));
+    PNode two_node(make_node(TERMINAL, one_node, two));
     one_node->add_child(two_node);
 }
 
@@ -43,9 +50,220 @@ Parser::Parser (Lexer *lex): lexer(lex), tree(INPUT) {
 
 void Parser::parse() {
     lexer->reset();
+    block_spans.clear();
+    tree.retain_tokens(lexer->get_tokens());
     parse_input();
 }
 
+// Every keyword that can start a top-level block
+bool is_block_keyword(Token_type t) {
+    switch (t) {
+        case ADLINFO: case DEF: case TABLE: case OBJ: case COMP: case ALGO: case HISTOLIST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+Parse with the top-level blocks spread over a number of threads, building exactly the tree that parse() would.
+
+Every block keyword in the token stream is taken to be the start of a block, and each one is parsed on its own by a
+worker with its own lexer position and its own node arena, recording where its block ended. The serial loop of
+parse_blocks is then run over the results: whenever it reaches a token at which a worker started, it grafts that
+worker's block on and jumps to where the block ended, and anywhere else it parses the block itself. Parsing a block
+depends on nothing but the tokens from its start onwards, so the grafted blocks are the ones the loop would have
+built, and a keyword that turns out to sit inside another block costs only the wasted work on it. A worker that
+failed leaves its block to the loop, which raises the same error as a serial parse.
+*/
+void Parser::parse_parallel(unsigned threads) {
+    // The workers need every token before they can start
+    lexer->lex_remaining();
+    lexer->reset();
+    block_spans.clear();
+    tree.retain_tokens(lexer->get_tokens());
+
+    auto tokens = lexer->get_tokens();
+    std::vector<Token_index> starts;
+    for (Token_index i = 0; i < tokens->size(); i++) {
+        if (is_block_keyword(tokens->get(i)->get_token_type())) starts.push_back(i);
+    }
+
+    threads = std::min<std::size_t>(threads, starts.size());
+    if (threads < 2) {
+        parse_input();
+        return;
+    }
+
+    std::vector<Parsed_block> results(starts.size());
+
+    std::vector<std::unique_ptr<Parser>> workers;
+    for (unsigned t = 0; t < threads; t++) workers.push_back(std::make_unique<Parser>(lexer->replay().release()));
+
+    std::atomic<std::size_t> next_block(0);
+    std::vector<std::thread> pool;
+    for (auto &worker : workers) {
+        pool.emplace_back([&results, &starts, &next_block, parser = worker.get()]() {
+            for (std::size_t b = next_block++; b < starts.size(); b = next_block++) {
+                parser->lexer->seek(starts[b]);
+                try {
+                    PNode block = parser->parse_block(parser->tree.get_root());
+                    results[b].span = parser->finish_block_span(starts[b]);
+                    results[b].block = block;
+                } catch (const std::exception &) {
+                    // Left for the serial loop, to raise in its proper place
+                }
+            }
+        });
+    }
+    for (auto &thread : pool) thread.join();
+
+    for (auto &worker : workers) tree.adopt_nodes(worker->tree);
+
+    // Failed blocks are dropped, so that the loop parses them itself
+    results.erase(std::remove_if(results.begin(), results.end(), [](const Parsed_block &result) { return !result.block; }), results.end());
+    parse_blocks_reusing(results, nullptr);
+}
+
+// The span of the block that started at the given token and has just been parsed
+Block_span Parser::finish_block_span(Token_index start) {
+    // The token the block stopped on is looked at here, as parse_blocks would look at it next anyway
+    Token_index end = lexer->position();
+    if (end == END_OF_FILE_INDEX) end = lexer->get_tokens()->size();
+    return {start, end, lexer->get_furthest_read()};
+}
+
+// The BLOCKS loop of parse_blocks, but taking a ready-made block wherever one starts at the current token instead of parsing it again.
+// The ready blocks must be in token order; those taken are marked used. Blocks the loop parses itself are added to `parsed`, if given.
+void Parser::parse_blocks_reusing(std::vector<Parsed_block> &ready, std::vector<PNode> *parsed) {
+    PNode input_node = tree.get_root();
+    std::size_t b = 0;
+    while (lexer->peek(0)->get_token_type() != LEXER_END_OF_FILE) {
+        Token_index start = lexer->position();
+        while (b < ready.size() && ready[b].span.start < start) b++;
+
+        if (b < ready.size() && ready[b].span.start == start) {
+            ready[b].block->set_parent(input_node);
+            input_node->add_child(ready[b].block);
+            block_spans.push_back(ready[b].span);
+            ready[b].used = true;
+            lexer->seek(ready[b].span.end);
+        } else {
+            PNode block = parse_block(input_node);
+            input_node->add_child(block);
+            block_spans.push_back(finish_block_span(start));
+            if (parsed) parsed->push_back(block);
+        }
+    }
+}
+
+// Move every token of a subtree along by the same number of arena positions
+void shift_tokens(PNode block, std::int64_t shift, const TokenArena &tokens) {
+    std::vector<PNode> pending = {block};
+    while (!pending.empty()) {
+        PNode node = pending.back();
+        pending.pop_back();
+
+        if (node->has_token() && node->get_token().get_index() != END_OF_FILE_INDEX) {
+            node->set_token(tokens.get(node->get_token().get_index() + shift));
+        }
+        for (auto it = node->get_children().begin(); it != node->get_children().end(); ++it) pending.push_back(*it);
+    }
+}
+
+/*
+Replace lines first_line to last_line of the input with the replacement, which may hold any number of lines, and
+bring the tree up to date by parsing again only the top-level blocks that the edit can have changed.
+
+A block is kept as it is if every token the parser looked at for it lies before the edit, and is reused, with its
+tokens moved along, if it starts after the edit. Parsing resumes after the last block kept, and runs as parse_blocks
+would until it reaches the start of a reusable block, from where it takes the remaining blocks as they are. As with
+parse_parallel, the tree is the one a full parse of the edited input would build.
+
+If the edited input fails to lex or parse, the exception is raised with the tree, its tokens and the lexer just as
+they were before the call, so that the caller can carry on from there, such as by editing the same lines again.
+
+Discarded blocks are left in the node arena until the tree goes. A tree that was not parsed by this parser, such as
+one loaded from the AST cache, has no record of its blocks' tokens. Its source, given by set_unlexed_source, is lexed
+on the first edit and the tree is parsed again in full; without one there is no input to edit, and it raises.
+*/
+Block_changes Parser::reparse_lines(int first_line, int last_line, std::string replacement) {
+    PNode input_node = tree.get_root();
+    std::vector<PNode> old_blocks(input_node->get_children().begin(), input_node->get_children().end());
+
+    if (unlexed_source) {
+        lexer->read_source(unlexed_source);
+        tree.retain_tokens(lexer->get_tokens());
+        unlexed_source.reset();
+        block_spans.clear();
+    }
+
+    Token_index old_size = lexer->get_tokens()->size();
+    Token_splice splice = lexer->relex_lines(first_line, last_line, std::move(replacement));
+    Token_index edit_end = splice.first + splice.removed;
+    std::int64_t shift = static_cast<std::int64_t>(splice.inserted) - splice.removed;
+
+    std::vector<Block_span> old_spans = block_spans;
+    bool spans_known = old_spans.size() == old_blocks.size();
+
+    Block_changes changes;
+
+    // A block that ran into the end of the input also depends on nothing more following it
+    auto reach = [old_size](const Block_span &span) {
+        return span.reach >= old_size ? old_size + 1 : span.reach;
+    };
+
+    std::size_t kept = 0;
+    while (spans_known && kept < old_spans.size() && reach(old_spans[kept]) <= splice.first) kept++;
+
+    std::vector<Parsed_block> ready;
+    for (std::size_t b = kept; b < old_blocks.size(); b++) {
+        if (spans_known && old_spans[b].start >= edit_end) {
+            Block_span span = old_spans[b];
+            span.start += shift;
+            span.end += shift;
+            span.reach += shift;
+            ready.push_back({old_blocks[b], span});
+        } else {
+            changes.removed.push_back(old_blocks[b]);
+        }
+    }
+
+    input_node->clear_children();
+    block_spans.clear();
+    for (std::size_t b = 0; b < kept; b++) {
+        input_node->add_child(old_blocks[b]);
+        block_spans.push_back(old_spans[b]);
+    }
+
+    for (auto &block : ready) shift_tokens(block.block, shift, *lexer->get_tokens());
+
+    try {
+        lexer->seek(kept == 0 ? 0 : old_spans[kept - 1].end);
+        parse_blocks_reusing(ready, &changes.inserted);
+    } catch (...) {
+        for (auto &block : ready) shift_tokens(block.block, -shift, *lexer->get_tokens());
+        lexer->undo_relex();
+
+        input_node->clear_children();
+        for (PNode block : old_blocks) {
+            block->set_parent(input_node);
+            input_node->add_child(block);
+        }
+        block_spans = std::move(old_spans);
+        throw;
+    }
+
+    for (auto &block : ready) {
+        if (!block.used) changes.removed.push_back(block.block);
+    }
+    return changes;
+}
+
+void Parser::set_unlexed_source(PSource source) {
+    unlexed_source = source;
+}
+
 
 /*
 INPUT productions:
@@ -85,60 +303,53 @@ BLOCKS productions:
 
 void Parser::parse_blocks(PNode parent) {
 
-        auto tok = lexer->peek(0); 
-        switch(tok->get_token_type()) {
-            // BLOCKS -> INFO BLOCKS
-            case ADLINFO:
-                parent->add_child(parse_info(parent));
-                parse_blocks(parent);
-                return;
+    // BLOCKS is right-recursive, so each block is one more turn of this loop rather than one more nested call
+    // BLOCKS -> epsilon
+    while (lexer->peek(0)->get_token_type() != LEXER_END_OF_FILE) {
+        Token_index start = lexer->position();
+        parent->add_child(parse_block(parent));
+        block_spans.push_back(finish_block_span(start));
+    }
+}
 
-            // BLOCKS -> DEFINITIONS BLOCKS
-            case DEF: 
-                parent->add_child(parse_definition(parent));
-                parse_blocks(parent);
-                return;
+// One block of BLOCKS, chosen by its leading keyword
+PNode Parser::parse_block(PNode parent) {
 
-            // BLOCKS -> TABLE BLOCKS
-            case TABLE:
-                parent->add_child(parse_table(parent));
-                parse_blocks(parent);
-                return;
+    auto tok = lexer->peek(0); 
+    switch(tok->get_token_type()) {
+        // BLOCKS -> INFO BLOCKS
+        case ADLINFO:
+            return parse_info(parent);
 
-            // BLOCKS -> OBJECT BLOCKS
-            case OBJ:
-                parent->add_child(parse_object(parent));
-                parse_blocks(parent);
-                return;
+        // BLOCKS -> DEFINITIONS BLOCKS
+        case DEF: 
+            return parse_definition(parent);
 
-            // BLOCKS -> COMPOSITE BLOCKS
-            case COMP:
-                parent->add_child(parse_composite(parent));
-                parse_blocks(parent);
-                return;
+        // BLOCKS -> TABLE BLOCKS
+        case TABLE:
+            return parse_table(parent);
 
-            // BLOCKS -> REGION BLOCKS
-            case ALGO:
-                parent->add_child(parse_region(parent));
-                parse_blocks(parent);
-                return;
+        // BLOCKS -> OBJECT BLOCKS
+        case OBJ:
+            return parse_object(parent);
 
-            // BLOCKS -> HISTO_LIST BLOCKS
-            case HISTOLIST:
-                parent->add_child(parse_histo_list(parent));
-                parse_blocks(parent);
-                return;
-                
-            // BLOCKS -> epsilon
-            case LEXER_END_OF_FILE:
-                return;
-            
-            // If we have anything but these options and the file has not ended, this is an error state
-            default:
-                raise_parsing_exception("Unexpected token follows a block - expected either a continuation of the previous block or the start of a new one", tok);
-                return;
-        }
+        // BLOCKS -> COMPOSITE BLOCKS
+        case COMP:
+            return parse_composite(parent);
 
+        // BLOCKS -> REGION BLOCKS
+        case ALGO:
+            return parse_region(parent);
+
+        // BLOCKS -> HISTO_LIST BLOCKS
+        case HISTOLIST:
+            return parse_histo_list(parent);
+        
+        // If we have anything but these options and the file has not ended, this is an error state
+        default:
+            raise_parsing_exception("Unexpected token follows a block - expected either a continuation of the previous block or the start of a new one", tok);
+            return nullptr;
+    }
 }
 
 /*
@@ -151,7 +362,7 @@ INFO productions:
 
 PNode Parser::parse_info(PNode parent) {
 
-    PNode info(std::make_shared<Node>(INFO, parent));
+    PNode info(make_node(INFO, parent));
 
     // INFO -> adlinfo ID INITIALIZATIONS
     lexer->expect_and_consume(ADLINFO);
@@ -171,7 +382,7 @@ DEFINITION productions:
 */
 PNode Parser::parse_definition(PNode parent) {
 
-    PNode definition(std::make_shared<Node>(DEFINITION, parent));
+    PNode definition(make_node(DEFINITION, parent));
 
     lexer->expect_and_consume(DEF);
     definition->add_child(parse_id(definition));
@@ -196,7 +407,7 @@ PNode Parser::parse_definition(PNode parent) {
  */
 PNode Parser::parse_object(PNode parent) {
 
-    PNode object(std::make_shared<Node>(OBJECT, parent));
+    PNode object(make_node(OBJECT, parent));
     
     lexer->expect_and_consume(OBJ);
     object->add_child(parse_id(object));
@@ -214,7 +425,7 @@ PNode Parser::parse_object(PNode parent) {
 //TODO: finish composite
 PNode Parser::parse_composite(PNode parent) {
 
-    PNode object(std::make_shared<Node>(COMPOSITE, parent));
+    PNode object(make_node(COMPOSITE, parent));
     
     lexer->expect_and_consume(COMP);
     object->add_child(parse_id(object));
@@ -236,7 +447,7 @@ PNode Parser::parse_composite(PNode parent) {
 PNode Parser::parse_table(PNode parent) {
 
     // TABLE -> table ID tabletype ID nvars integer errors BOOL BIN_OR_BOX_VALUES
-    PNode table(std::make_shared<Node>(TABLE_DEF, parent));
+    PNode table(make_node(TABLE_DEF, parent));
 
     lexer->expect_and_consume(TABLE);
     table->add_child(parse_id(table));
@@ -265,7 +476,7 @@ PNode Parser::parse_table(PNode parent) {
 PNode Parser::parse_region(PNode parent) {
 
     // REGION -> algo ID REGION_COMMANDS
-    PNode region(std::make_shared<Node>(REGION, parent));
+    PNode region(make_node(REGION, parent));
 
     lexer->expect_and_consume(ALGO);
     region->add_child(parse_id(region));
@@ -284,19 +495,20 @@ INITIALIZATIONS productions:
     INITIALIZATIONS -> epsilon
  */
 void Parser::parse_initializations(PNode parent) {
-    PToken next = lexer->peek(0);
-    
-    switch (next->get_token_type()) {
+    while (true) {
+        PToken next = lexer->peek(0);
+        
+        switch (next->get_token_type()) {
 
-        // INITIALIZATONS -> epsilon
-        case ADLINFO: case DEF: case TABLE: case OBJ: case ALGO: case HISTOLIST: case COMP:
-            return;
-        // Anything not in the follow set indicates a continuation
-        // INITIALIZATIONS -> INITIALIZATION INITIALIZATIONS
-        default:
-            parent->add_child(parse_initialization(parent));
-            parse_initializations(parent);
-            return;
+            // INITIALIZATONS -> epsilon
+            case ADLINFO: case DEF: case TABLE: case OBJ: case ALGO: case HISTOLIST: case COMP:
+                return;
+            // Anything not in the follow set indicates a continuation
+            // INITIALIZATIONS -> INITIALIZATION INITIALIZATIONS
+            default:
+                parent->add_child(parse_initialization(parent));
+                break;
+        }
     }
 }
 
@@ -307,7 +519,7 @@ void Parser::parse_initializations(PNode parent) {
 */
 PNode Parser::parse_histo_list(PNode parent) {
     // HISTO_LIST -> histolist ID HISTO_ENTRIES
-    PNode histo_list(std::make_shared<Node>(HISTO_LIST, parent));
+    PNode histo_list(make_node(HISTO_LIST, parent));
 
     lexer->expect_and_consume(HISTOLIST);
     histo_list->add_child(parse_id(histo_list));
@@ -325,19 +537,20 @@ PNode Parser::parse_histo_list(PNode parent) {
 
 */
 void Parser::parse_histo_entries(PNode parent) {
-PToken next = lexer->peek(0);
-    
-    switch (next->get_token_type()) {
+    while (true) {
+        PToken next = lexer->peek(0);
+        
+        switch (next->get_token_type()) {
 
-        // HISTO_ENTRIES ->  HISTO_ENTRY HISTO_ENTRIES
-        case HISTO: 
-            parent->add_child(parse_histo_entry(parent));
-            parse_histo_entries(parent);
-            return;
+            // HISTO_ENTRIES ->  HISTO_ENTRY HISTO_ENTRIES
+            case HISTO: 
+                parent->add_child(parse_histo_entry(parent));
+                break;
 
-        // HISTO_ENTRIES -> epsilon
-        default:
-            return;
+            // HISTO_ENTRIES -> epsilon
+            default:
+                return;
+        }
     }
 }
 
@@ -386,7 +599,7 @@ PNode Parser::parse_initialization(PNode parent) {
         // INITIALIZATION -> skpe = integer
         case SKIP_HISTO: case SKIP_EFFS:
         {   
-            PNode integer_target(std::make_shared<Node>(TERMINAL, parent, lexer->next()));
+            PNode integer_target(make_node(TERMINAL, parent, lexer->next()));
             // Consume terminal equals
             lexer->expect_and_consume(ASSIGN);
             
@@ -401,7 +614,7 @@ PNode Parser::parse_initialization(PNode parent) {
         // INITIALIZATION -> pap_sqrts number
         case PAP_LUMI: case PAP_SQRTS:
         {
-            PNode number_target(std::make_shared<Node>(TERMINAL, parent, lexer->next()));
+            PNode number_target(make_node(TERMINAL, parent, lexer->next()));
             PToken next = lexer->next();
             if (!is_numerical(next->get_token_type())) raise_parsing_exception("Non-numerical value given for numerical field", next); 
 
@@ -412,7 +625,7 @@ PNode Parser::parse_initialization(PNode parent) {
         // INITIALIZATION -> pap_experiment ID
         case PAP_EXPERIMENT: 
         {
-            PNode experiment(std::make_shared<Node>(TERMINAL, parent, lexer->next()));
+            PNode experiment(make_node(TERMINAL, parent, lexer->next()));
             experiment->add_child(parse_id(experiment));
             return experiment;
         }
@@ -425,7 +638,7 @@ PNode Parser::parse_initialization(PNode parent) {
         // INITIALIZATION -> pap_hepdata DESCRIPTION
         case PAP_TITLE: case PAP_PUBLICATION: case PAP_ID: case PAP_ARXIV: case PAP_DOI: case PAP_HEPDATA:
         {
-            PNode description_target(std::make_shared<Node>(TERMINAL, parent, lexer->next()));
+            PNode description_target(make_node(TERMINAL, parent, lexer->next()));
 
             description_target->add_child(parse_description(description_target));
             return description_target;
@@ -456,7 +669,7 @@ PNode Parser::parse_histo_entry(PNode parent) {
 
     // HISTO_ENTRY -> histo HISTOGRAM
     lexer->expect_and_consume(HISTO);
-    PNode histo(std::make_shared<Node>(HISTOLIST_HISTOGRAM, parent));
+    PNode histo(make_node(HISTOLIST_HISTOGRAM, parent));
     parse_histogram(histo);
     return histo;
 }
@@ -492,7 +705,7 @@ PNode Parser::parse_def_rvalue(PNode parent) {
         {
             lexer->expect_and_consume(OPEN_CURLY_BRACE);
 
-            PNode variable_list(std::make_shared<Node>(VARIABLE_LIST, parent));
+            PNode variable_list(make_node(VARIABLE_LIST, parent));
             parse_variable_list(variable_list);
 
             lexer->expect_and_consume(CLOSE_CURLY_BRACE);
@@ -511,7 +724,7 @@ PNode Parser::parse_def_rvalue(PNode parent) {
             lexer->expect_and_consume(COMMA);
 
             lexer->expect_and_consume(OPEN_CURLY_BRACE);
-            PNode var_list(std::make_shared<Node>(VARIABLE_LIST, ome));
+            PNode var_list(make_node(VARIABLE_LIST, ome));
             parse_variable_list(var_list);
             lexer->expect_and_consume(CLOSE_CURLY_BRACE);
 
@@ -531,7 +744,7 @@ PNode Parser::parse_def_rvalue(PNode parent) {
         {
             auto constituents = make_terminal(parent, lexer->next());
 
-            PNode particle_list(std::make_shared<Node>(PARTICLE_LIST, constituents));
+            PNode particle_list(make_node(PARTICLE_LIST, constituents));
             parse_particle_list(particle_list);
             constituents->add_child(particle_list);
 
@@ -571,7 +784,7 @@ PNode Parser::parse_def_rvalue(PNode parent) {
         {
             auto add_particles = make_terminal(parent, lexer->next());
             
-            PNode particle_list(std::make_shared<Node>(PARTICLE_SUM, add_particles));
+            PNode particle_list(make_node(PARTICLE_SUM, add_particles));
             parse_particle_sum(particle_list);
             add_particles->add_child(particle_list);
 
@@ -582,13 +795,13 @@ PNode Parser::parse_def_rvalue(PNode parent) {
         case GEN: case ELECTRON: case MUON: case TAU: case TRACK: case PHOTON: 
         case JET: case FJET: case QGJET: case METLV:
             raise_parsing_exception("Cannot use a particle in a definition without specifying the \"particle\" keyword", tok);
-            return PNode(std::make_shared<Node>(AST_ERROR, parent));
+            return PNode(make_node(AST_ERROR, parent));
         
         case STRING: case VARNAME:
             if (lexer->peek(1)->get_token_type() == OPEN_SQUARE_BRACE)
             {
                 raise_parsing_exception("Cannot use a particle in a definition without specifying the \"particle\" keyword", tok);
-                return PNode(std::make_shared<Node>(AST_ERROR, parent));
+                return PNode(make_node(AST_ERROR, parent));
             }
             // intentional fall-through
 
@@ -628,7 +841,7 @@ void Parser::parse_composite_rvalue(PNode parent) {
 
             lexer->expect_and_consume(OPEN_PAREN);
 
-            PNode particle_list(std::make_shared<Node>(NAMED_PARTICLE_LIST, comb_type));
+            PNode particle_list(make_node(NAMED_PARTICLE_LIST, comb_type));
             comb_type->add_child(particle_list);
 
             parse_named_particle_list(particle_list);
@@ -672,7 +885,7 @@ void Parser::parse_obj_rvalue(PNode parent) {
 
             lexer->expect_and_consume(OPEN_PAREN);
 
-            PNode particle_list(std::make_shared<Node>(PARTICLE_LIST, union_type));
+            PNode particle_list(make_node(PARTICLE_LIST, union_type));
             union_type->add_child(particle_list);
 
             parse_particle_list(particle_list);
@@ -690,7 +903,7 @@ void Parser::parse_obj_rvalue(PNode parent) {
             lexer->expect_and_consume(SORT);
             lexer->expect_and_consume(OPEN_PAREN);
 
-            PNode sort(std::make_shared<Node>(SORT_CMD, parent));
+            PNode sort(make_node(SORT_CMD, parent));
             parent->add_child(sort);
 
             sort->add_child(parse_particle(sort));
@@ -736,7 +949,7 @@ PNode Parser::parse_bool(PNode parent) {
     auto tok = lexer->next();
     if (!(tok->get_token_type() == TRUE) && !(tok->get_token_type() == FALSE)) raise_parsing_exception("Excepted boolean, but token is not interpretable as a boolean", tok);
 
-    PNode boolean(std::make_shared<Node>(TERMINAL, parent));
+    PNode boolean(make_node(TERMINAL, parent));
     boolean->set_token(tok);
     return boolean;
 }
@@ -767,17 +980,19 @@ PNode Parser::parse_id(PNode parent) {
  */
 PNode Parser::parse_description(PNode parent) {
 
-    auto tok = lexer->next();
-    PNode description_str(std::make_shared<Node>(TERMINAL, parent, tok));
-    if (tok->get_token_type() != STRING) {
-        raise_parsing_exception("Excepted string for description", tok);
-    }
-    // DESCRIPTION -> STRING DESCRIPTION
-    if (lexer->peek(0)->get_token_type() == STRING) {
+    while (true) {
+        auto tok = lexer->next();
+        PNode description_str(make_node(TERMINAL, parent, tok));
+        if (tok->get_token_type() != STRING) {
+            raise_parsing_exception("Excepted string for description", tok);
+        }
+        // DESCRIPTION -> STRING
+        if (lexer->peek(0)->get_token_type() != STRING) {
+            return description_str;
+        }
+        // DESCRIPTION -> STRING DESCRIPTION
         parent->add_child(description_str);
-        return parse_description(parent);
     }
-    return description_str;
 }
 
 
@@ -790,15 +1005,16 @@ PNode Parser::parse_description(PNode parent) {
  */
 void Parser::parse_region_commands(PNode parent) {
 
-    auto tok = lexer->peek(0);
+    while (true) {
+        auto tok = lexer->peek(0);
 
-    switch(tok->get_token_type()) {
-        case SELECT: case REJEC: case BINS: case BIN: case SAVE: case PRINT: case WEIGHT: case HISTO: case SORT: case TAKE:
-            parent->add_child(parse_region_command(parent));
-            parse_region_commands(parent);
-            return;
-        default:
-            return;
+        switch(tok->get_token_type()) {
+            case SELECT: case REJEC: case BINS: case BIN: case SAVE: case PRINT: case WEIGHT: case HISTO: case SORT: case TAKE:
+                parent->add_child(parse_region_command(parent));
+                break;
+            default:
+                return;
+        }
     }
 }
 
@@ -824,7 +1040,7 @@ PNode Parser::parse_region_command_select(PNode parent) {
         case NONE: case ALL: 
         {
             lexer->next();
-            PNode cond(std::make_shared<Node>(CONDITION, parent));
+            PNode cond(make_node(CONDITION, parent));
             cond->add_child(make_terminal(cond, next));
             return cond;
         }
@@ -876,7 +1092,7 @@ PNode Parser::parse_region_command(PNode parent) {
         // REGION_COMMAND -> select REGION_COMMAND_SELECT
         case SELECT:
         {
-            PNode node(std::make_shared<Node>(REGION_SELECT, parent));
+            PNode node(make_node(REGION_SELECT, parent));
             node->add_child(parse_region_command_select(parent));
             return node;
         }
@@ -884,7 +1100,7 @@ PNode Parser::parse_region_command(PNode parent) {
         // REGION_COMMAND -> weight ID E
         case WEIGHT:
         {
-            PNode node(std::make_shared<Node>(WEIGHT_CMD, parent));
+            PNode node(make_node(WEIGHT_CMD, parent));
             node->add_child(parse_id(node));
             node->add_child(parse_expression(node));
             return node;
@@ -893,7 +1109,7 @@ PNode Parser::parse_region_command(PNode parent) {
         // REGION_COMMAND -> rejec REGION_COMMAND_SELECT
         case REJEC:
         {
-            PNode node(std::make_shared<Node>(REGION_REJECT, parent));
+            PNode node(make_node(REGION_REJECT, parent));
             node->add_child(parse_region_command_select(parent));
             return node;
         }
@@ -901,7 +1117,7 @@ PNode Parser::parse_region_command(PNode parent) {
         // REGION_COMMAND -> bin CONDITION
         case BIN:
         {
-            PNode node(std::make_shared<Node>(BIN_CMD, parent));
+            PNode node(make_node(BIN_CMD, parent));
             node->add_child(parse_condition(node));
             return node;
         }
@@ -909,7 +1125,7 @@ PNode Parser::parse_region_command(PNode parent) {
         // REGION_COMMAND -> take ID
         case TAKE:
         {
-            PNode node(std::make_shared<Node>(REGION_USE, parent));
+            PNode node(make_node(REGION_USE, parent));
             node->add_child(parse_id(node));
             return node;
         }
@@ -917,7 +1133,7 @@ PNode Parser::parse_region_command(PNode parent) {
         // REGION_COMMAND -> bins ID BIN_OR_BOX_VALUES
         case BINS:
         {
-            PNode node(std::make_shared<Node>(BINS_CMD, parent));
+            PNode node(make_node(BINS_CMD, parent));
             node->add_child(parse_expression(node));
             parse_bin_or_box_values(node);
             return node;
@@ -951,18 +1167,18 @@ PNode Parser::parse_region_command(PNode parent) {
         {
             if (lexer->peek(0)->get_token_type() == TAKE) {
                 lexer->expect_and_consume(TAKE);
-                PNode histo_use(std::make_shared<Node>(HISTO_USE, parent));
+                PNode histo_use(make_node(HISTO_USE, parent));
                 histo_use->add_child(parse_id(histo_use));
                 return histo_use;
             }
-            PNode histo(std::make_shared<Node>(HISTOGRAM, parent));
+            PNode histo(make_node(HISTOGRAM, parent));
             parse_histogram(histo);
             return histo;
         }
 
         default:
             raise_parsing_exception("Unexpected token in region block", tok);
-            return PNode(std::make_shared<Node>(AST_ERROR, parent));
+            return PNode(make_node(AST_ERROR, parent));
     }
 
 }
@@ -1050,25 +1266,26 @@ void Parser::parse_histogram(PNode parent) {
  */
 void Parser::parse_variable_list(PNode parent) {
 
-    auto tok = lexer->peek(0);
-    switch(tok->get_token_type()) {
+    while (true) {
+        auto tok = lexer->peek(0);
+        switch(tok->get_token_type()) {
 
-        // VARIABLE_LIST -> epsilon 
-        // this is the follow set for VARIABLE_LIST, and none of them are in the first set of EXPRESSION
-        // TODO: update this
-        case CLOSE_CURLY_BRACE: case CLOSE_PAREN: case COLON: case OBJ: case COMP:  case SELECT: case PRINT: case HISTO: case REJEC: case BINS: case BIN: case SAVE: case WEIGHT: case SORT: case ADLINFO: case DEF: case TABLE: case ALGO: case COMMA: 
-            return;            
+            // VARIABLE_LIST -> epsilon 
+            // this is the follow set for VARIABLE_LIST, and none of them are in the first set of EXPRESSION
+            // TODO: update this
+            case CLOSE_CURLY_BRACE: case CLOSE_PAREN: case COLON: case OBJ: case COMP:  case SELECT: case PRINT: case HISTO: case REJEC: case BINS: case BIN: case SAVE: case WEIGHT: case SORT: case ADLINFO: case DEF: case TABLE: case ALGO: case COMMA: 
+                return;            
 
-        // VARIABLE_LIST -> EXPRESSION VARIABLE_LIST
-        // VARIABLE_LIST -> EXPRESSION, VARIABLE_LIST
-        default:
-            parent->add_child(parse_expression(parent));
-            auto next = lexer->peek(0);
-            if (next->get_token_type() == COMMA) {
-                lexer->expect_and_consume(COMMA);
-            }
-            parse_variable_list(parent);
-            return;
+            // VARIABLE_LIST -> EXPRESSION VARIABLE_LIST
+            // VARIABLE_LIST -> EXPRESSION, VARIABLE_LIST
+            default:
+                parent->add_child(parse_expression(parent));
+                auto next = lexer->peek(0);
+                if (next->get_token_type() == COMMA) {
+                    lexer->expect_and_consume(COMMA);
+                }
+                break;
+        }
     }
 }
 
@@ -1102,7 +1319,7 @@ void Parser::parse_variable_list(PNode parent) {
 PNode Parser::parse_if_or_condition(PNode parent) {
 
     //TODO: change IF token to something else
-    PNode node(std::make_shared<Node>(IF_STATEMENT, parent));
+    PNode node(make_node(IF_STATEMENT, parent));
 
     node->add_child(parse_condition(node));
 
@@ -1167,13 +1384,12 @@ void Parser::parse_bin_or_box_values(PNode parent) {
     // BIN_OR_BOX_VALUES -> number BIN_OR_BOX_VALUES
     // BIN_OR_BOX_VALUES -> number
 
-    auto tok = lexer->next();
-    if (!is_numerical(tok->get_token_type())) raise_parsing_exception("Needs a numerical value for box argument", tok);
-
-    parent->add_child(make_terminal(parent, tok));
+    do {
+        auto tok = lexer->next();
+        if (!is_numerical(tok->get_token_type())) raise_parsing_exception("Needs a numerical value for box argument", tok);
 
-    auto next = lexer->peek(0);
-    if (is_numerical(next->get_token_type())) parse_bin_or_box_values(parent);
+        parent->add_child(make_terminal(parent, tok));
+    } while (is_numerical(lexer->peek(0)->get_token_type()));
 }
 
 
@@ -1189,65 +1405,53 @@ void Parser::parse_bin_or_box_values(PNode parent) {
 */
 void Parser::parse_particle_sum(PNode parent) {
 
-    parent->add_child(parse_particle(parent));
-    auto tok = lexer->peek(0);
+    while (true) {
+        parent->add_child(parse_particle(parent));
+        auto tok = lexer->peek(0);
 
-    switch (tok->get_token_type()) {
+        switch (tok->get_token_type()) {
 
-        // PARTICLE_SUM -> PARTICLE + PARTICLE_SUM
-        case PLUS:
-            lexer->expect_and_consume(PLUS);
-            parse_particle_sum(parent);
-            return;
+            // PARTICLE_SUM -> PARTICLE + PARTICLE_SUM
+            case PLUS:
+                lexer->expect_and_consume(PLUS);
+                break;
 
-        // PARTICLE_SUM -> PARTICLE PARTICLE_SUM
-        case GEN: case ELECTRON: case MUON: case TAU: case TRACK: case PHOTON: 
-        case JET: case FJET: case QGJET: case METLV: case STRING: case VARNAME: case MINUS:
-            parse_particle_sum(parent);
-            return;
+            // PARTICLE_SUM -> PARTICLE PARTICLE_SUM
+            case GEN: case ELECTRON: case MUON: case TAU: case TRACK: case PHOTON: 
+            case JET: case FJET: case QGJET: case METLV: case STRING: case VARNAME: case MINUS:
+                break;
 
-        default:
-        // PARTICLE_SUM -> PARTICLE
-            return;
+            default:
+            // PARTICLE_SUM -> PARTICLE
+                return;
+        }
     }
 }
 
 void Parser::parse_particle_list(PNode parent) {
 
-    parent->add_child(parse_particle(parent));
-    auto tok = lexer->peek(0);
+    while (true) {
+        parent->add_child(parse_particle(parent));
 
-    switch (tok->get_token_type()) {
+        // PARTICLE_LIST -> PARTICLE
+        if (lexer->peek(0)->get_token_type() != COMMA) return;
 
         // PARTICLE_LIST -> PARTICLE, PARTICLE_LIST
-        case COMMA:
-            lexer->expect_and_consume(COMMA);
-            parse_particle_list(parent);
-            return;
-
-        default:
-        // PARTICLE_LIST -> PARTICLE
-            return;
+        lexer->expect_and_consume(COMMA);
     }
 }
 
 void Parser::parse_named_particle_list(PNode parent) {
 
-    parent->add_child(parse_particle(parent));
-    parent->add_child(parse_id(parent));
-    auto tok = lexer->peek(0);
+    while (true) {
+        parent->add_child(parse_particle(parent));
+        parent->add_child(parse_id(parent));
 
-    switch (tok->get_token_type()) {
+        // NAMED_PARTICLE_LIST -> PARTICLE ID
+        if (lexer->peek(0)->get_token_type() != COMMA) return;
 
         // NAMED_PARTICLE_LIST -> PARTICLE ID, NAMED_PARTICLE_LIST
-        case COMMA:
-            lexer->expect_and_consume(COMMA);
-            parse_named_particle_list(parent);
-            return;
-
-        default:
-        // PARTICLE_LIST -> PARTICLE ID
-            return;
+        lexer->expect_and_consume(COMMA);
     }
 }
 
@@ -1370,7 +1574,7 @@ PNode Parser::parse_particle(PNode parent) {
             {
                 PNode particle;
                 if (lexer->peek(1)->get_token_type() == ARROW_INDEX) {
-                    particle = precedence_climber(parent, 0);
+                    particle = parse_operator_expression(parent, 0);
                 } else {
                     particle = parse_id(parent);
                 }
@@ -1406,7 +1610,7 @@ PNode Parser::parse_index(PNode parent) {
         case OPEN_SQUARE_BRACE:
         {    
             lexer->next();
-            PNode index(std::make_shared<Node>(INDEX, parent));
+            PNode index(make_node(INDEX, parent));
             auto next = lexer->next();
             if (next->get_token_type() != INTEGER && next->get_token_type() != COLON) raise_parsing_exception("Only integers are allowed to be used as indices", next);
             index->add_child(make_terminal(index, next));
@@ -1429,7 +1633,7 @@ PNode Parser::parse_index(PNode parent) {
 
         // INDEX -> epsilon
         default:
-            return PNode(std::make_shared<Node>(AST_EPSILON, parent));
+            return PNode(make_node(AST_EPSILON, parent));
     }
 }
 
@@ -1443,14 +1647,15 @@ PNode Parser::parse_index(PNode parent) {
 */
 void Parser::parse_composite_criteria(PNode parent) {
 
-    auto tok = lexer->peek(0);
-    switch(tok->get_token_type()) {
-        case SELECT: case PRINT: case HISTO: case REJEC: case PARTICLE_KEYWORD:
-            parent->add_child(parse_composite_criterion(parent));
-            parse_composite_criteria(parent);
-            return;
-        default:
-            return;
+    while (true) {
+        auto tok = lexer->peek(0);
+        switch(tok->get_token_type()) {
+            case SELECT: case PRINT: case HISTO: case REJEC: case PARTICLE_KEYWORD:
+                parent->add_child(parse_composite_criterion(parent));
+                break;
+            default:
+                return;
+        }
     }
 }
 
@@ -1464,14 +1669,15 @@ void Parser::parse_composite_criteria(PNode parent) {
 */
 void Parser::parse_criteria(PNode parent) {
 
-    auto tok = lexer->peek(0);
-    switch(tok->get_token_type()) {
-        case SELECT: case PRINT: case HISTO: case REJEC:
-            parent->add_child(parse_criterion(parent));
-            parse_criteria(parent);
-            return;
-        default:
-            return;
+    while (true) {
+        auto tok = lexer->peek(0);
+        switch(tok->get_token_type()) {
+            case SELECT: case PRINT: case HISTO: case REJEC:
+                parent->add_child(parse_criterion(parent));
+                break;
+            default:
+                return;
+        }
     }
 }
 
@@ -1491,7 +1697,7 @@ PNode Parser::parse_composite_criterion(PNode parent) {
 
         case PARTICLE_KEYWORD:
         {
-            PNode definition(std::make_shared<Node>(DEFINITION, parent));
+            PNode definition(make_node(DEFINITION, parent));
 
             auto add_particles = make_terminal(parent, lexer->next());
             definition->add_child(parse_id(definition));
@@ -1501,7 +1707,7 @@ PNode Parser::parse_composite_criterion(PNode parent) {
 
             if (eq_tok->get_token_type() != ASSIGN && eq_tok->get_token_type() != COLON) raise_parsing_exception("Unknown token for particle definition assignment, expected '=' or ':'", eq_tok);
             
-            PNode particle_list(std::make_shared<Node>(PARTICLE_SUM, add_particles));
+            PNode particle_list(make_node(PARTICLE_SUM, add_particles));
             parse_particle_sum(particle_list);
             add_particles->add_child(particle_list);
 
@@ -1531,14 +1737,14 @@ PNode Parser::parse_criterion(PNode parent) {
         // CRITERION -> cmd ACTION
         case SELECT: case HISTO:
         {
-            PNode node(std::make_shared<Node>(OBJECT_SELECT, parent));
+            PNode node(make_node(OBJECT_SELECT, parent));
             node->add_child(parse_action(node));
             return node;
         }
         // CRITERION -> rejec CONDITION
         case REJEC:
         {
-            PNode node(std::make_shared<Node>(OBJECT_REJECT, parent, tok));
+            PNode node(make_node(OBJECT_REJECT, parent, tok));
             node->add_child(parse_condition(node));
             return node;
         }
@@ -1570,109 +1776,146 @@ PNode Parser::parse_criterion(PNode parent) {
     CONDITION -> EXPRESSION
  */
 PNode Parser::parse_condition(PNode parent) {
-    PNode condition(std::make_shared<Node>(CONDITION, parent));
+    PNode condition(make_node(CONDITION, parent));
 
-    condition->add_child(precedence_climber(condition,  0));
+    condition->add_child(parse_operator_expression(condition,  0));
 
     return condition;
 }
 
-int get_precedence(PToken tok, bool increase_if_left_associative = false) {
-
-    int left_associative_addition = increase_if_left_associative ? 1 : 0;
-    
-    switch(tok->get_token_type()) {
-
-        // highest priority is an indexing of the form composite->subvariable
-        case ARROW_INDEX:
-        return 110 + left_associative_addition;
-
-        // second-highest priority is an indexing of the form object.function
-        case DOT_INDEX:
-        return 100 + left_associative_addition;
-
-        // raising to a power is right-associative
-        case RAISED_TO_POWER:
-        return 90;
-
-        case MULTIPLY: case DIVIDE:
-        return 80 + left_associative_addition;
-
-        case PLUS: case MINUS:
-        return 70 + left_associative_addition;
+/*
+Binding powers of the infix operators, for the Pratt loop of parse_operator_expression.
 
-        case WITHIN: case OUTSIDE:
-        return 40 + left_associative_addition;
+An operator takes the operand on its left if its left power is at least the minimum the loop is running at, and its
+right operand is then parsed with the right power as the new minimum. A left-associative operator has a right power
+one more than its left, so that the next operator of the same level ends its right operand; a right-associative one
+has equal powers, so that the next one nests inside it. Tokens that are not infix operators have a left power below
+every minimum, and so end the expression.
+*/
+struct Binding_power {
+    int left;
+    int right;
+};
+
+constexpr Binding_power NOT_AN_OPERATOR = {-1, -1};
+
+constexpr std::array<Binding_power, NUM_TOKEN_TYPES> make_binding_powers() {
+    std::array<Binding_power, NUM_TOKEN_TYPES> table = {};
+    for (auto &entry : table) entry = NOT_AN_OPERATOR;
+
+    auto left_associative = [&table](Token_type type, int power) { table[type] = {power, power + 1}; };
+    auto right_associative = [&table](Token_type type, int power) { table[type] = {power, power}; };
+
+    // highest priority is an indexing of the form composite->subvariable
+    left_associative(ARROW_INDEX, 110);
+    // second-highest priority is an indexing of the form object.function
+    left_associative(DOT_INDEX, 100);
+    right_associative(RAISED_TO_POWER, 90);
+    left_associative(MULTIPLY, 80);
+    left_associative(DIVIDE, 80);
+    left_associative(PLUS, 70);
+    left_associative(MINUS, 70);
+    left_associative(WITHIN, 40);
+    left_associative(OUTSIDE, 40);
+    left_associative(MAXIMIZE, 30);
+    left_associative(MINIMIZE, 30);
+    for (Token_type comparison : {LT, GT, LE, GE, EQ, NE}) left_associative(comparison, 20);
+    left_associative(AND, 10);
+    left_associative(OR, 10);
 
-        case MAXIMIZE: case MINIMIZE:
-        return 30 + left_associative_addition;
+    return table;
+}
 
-        case LT: case GT: case LE: case GE: case EQ: case NE: 
-        return 20 + left_associative_addition;
+constexpr std::array<Binding_power, NUM_TOKEN_TYPES> binding_powers = make_binding_powers();
 
-        case AND: case OR:
-        return 10 + left_associative_addition;
+static_assert(binding_powers[RAISED_TO_POWER].left == binding_powers[RAISED_TO_POWER].right, "^ is right-associative");
+static_assert(binding_powers[STRING].left < 0, "only operators bind");
 
-        default:
-        return -5;
+/*
+Pratt loop over the binding power table, with an explicit stack in place of recursion, so that neither long chains
+of operators nor bare parentheses, however deeply nested, grow the call stack, and every token is handled a constant
+number of times. The operands of a unary minus or not, and the arguments of a function, are still parsed by nested
+calls through parse_primary_expression.
 
+Each operator node is made once, when its operator is read, and is given its two operands when its right operand is
+complete. An opening parenthesis pushes a marker that holds the minimum in force outside it, so that the expression
+inside starts again from the lowest power and ends at the matching closing parenthesis.
 
-    }
-}
+Every call shares the parser's operator_stack, working only above the entries that were there when it started, so
+that its storage is reused by every expression rather than allocated again for each one.
+*/
+PNode Parser::parse_operator_expression(PNode parent, int min_power) {
 
+    std::size_t base = operator_stack.size();
 
-PNode Parser::precedence_climber(PNode parent, int min_precedence) {
+    // Leave the stack as this call found it, even when a parsing error ends the call early
+    struct Stack_guard {
+        std::vector<Pending_operator> &stack;
+        std::size_t base;
+        ~Stack_guard() { stack.resize(base); }
+    } guard{operator_stack, base};
 
-    auto lhs = parse_primary_expression(parent);
+    // The node the next operand will hang from
+    PNode operand_parent = parent;
 
-    auto lookahead = lexer->peek(0);
-    PToken op;
-    PNode op_node;
+    while (true) {
+        while (lexer->peek(0)->get_token_type() == OPEN_PAREN) {
+            lexer->next();
+            operator_stack.push_back({nullptr, nullptr, min_power});
+            min_power = 0;
+        }
 
-    // keep going while the next token is an operator with at least our current level of precedence
-    while (get_precedence(lookahead) >= min_precedence) {
-        op = lexer->next();
-        op_node = make_terminal(parent, op);
+        PNode operand = parse_primary_expression(operand_parent);
 
-        // find what precedence is our new minimum - if the operator is left-associative, it is one more than it's normal precedence
-        int new_min_precedence = get_precedence(op, true);
+        while (true) {
+            Binding_power power = binding_powers[lexer->peek(0)->get_token_type()];
 
-        auto rhs = precedence_climber(op_node, new_min_precedence);
+            // The operand is the left operand of the next operator
+            if (power.left >= min_power) {
+                PNode op_node = make_terminal(operand_parent, lexer->next());
+                operator_stack.push_back({operand, op_node, min_power});
+                min_power = power.right;
+                operand_parent = op_node;
+                break;
+            }
 
-        op_node->add_child(lhs);
-        lhs->set_parent(op_node);
+            if (operator_stack.size() == base) return operand;
 
-        op_node->add_child(rhs);
+            Pending_operator top = operator_stack.back();
+            operator_stack.pop_back();
+            min_power = top.min_power;
 
-        lhs = op_node;
+            if (!top.op_node) {
+                // The operand is the whole of a parenthesised expression, and is now the operand in its place
+                lexer->expect_and_consume(CLOSE_PAREN);
+                continue;
+            }
 
-        lookahead = lexer->peek(0);
+            // The operand is the right operand of the innermost pending operator, which is now complete
+            top.lhs->set_parent(top.op_node);
+            top.op_node->add_child(top.lhs);
+            top.op_node->add_child(operand);
+            operand = top.op_node;
+            operand_parent = operand->get_parent();
+        }
     }
-        
-    // at this point, we have parsed all we can of precedences above our threshold. We give our final node of the loop
-    return lhs;
 }
 
 PNode Parser::parse_primary_expression(PNode parent) {
 
     auto tok = lexer->next();
-    PNode node(make_terminal(parent, tok));
 
+    // Unary minus and brackets build their own nodes, rather than a terminal for their token
     switch(tok->get_token_type()) {
         case MINUS: 
         {
-            PNode negate_node(std::make_shared<Node>(NEGATE, parent));
+            PNode negate_node(make_node(NEGATE, parent));
             negate_node->add_child(parse_primary_expression(negate_node));
             return negate_node;
         }
-        case NOT:
-        {
-            node->add_child(parse_primary_expression(node));
-            return node;
-        }
         case OPEN_PAREN:
         {
-            PNode subexpression = precedence_climber(parent, 0);
+            PNode subexpression = parse_operator_expression(parent, 0);
             lexer->expect_and_consume(CLOSE_PAREN);
             return subexpression;
         }
@@ -1680,8 +1923,8 @@ PNode Parser::parse_primary_expression(PNode parent) {
         case OPEN_CURLY_BRACE:
         {
             // make a node representing what the particle list function will end up being
-            PNode terminal(std::make_shared<Node>(TERMINAL, parent));
-            PNode particle_list(std::make_shared<Node>(PARTICLE_LIST, terminal));
+            PNode terminal(make_node(TERMINAL, parent));
+            PNode particle_list(make_node(PARTICLE_LIST, terminal));
 
             parse_particle_list(particle_list);
             terminal->add_child(particle_list);
@@ -1693,7 +1936,7 @@ PNode Parser::parse_primary_expression(PNode parent) {
 
         case OPEN_SQUARE_BRACE:
         {
-            PNode interval(std::make_shared<Node>(INTERVAL, parent)); 
+            PNode interval(make_node(INTERVAL, parent)); 
             interval->add_child(parse_primary_expression(interval));
             if (lexer->peek(0)->get_token_type() == COMMA) lexer->expect_and_consume(COMMA);
             interval->add_child(parse_primary_expression(interval));
@@ -1701,12 +1944,25 @@ PNode Parser::parse_primary_expression(PNode parent) {
             return interval;
         }
 
+        default:
+            break;
+    }
+
+    PNode node(make_terminal(parent, tok));
+
+    switch(tok->get_token_type()) {
+        case NOT:
+        {
+            node->add_child(parse_primary_expression(node));
+            return node;
+        }
+
         case SORT:
         {
             // E -> sort (E, ascend)
             // E -> sort (E, descend)
             lexer->expect_and_consume(OPEN_PAREN);
-            node->add_child(precedence_climber(parent, 0));
+            node->add_child(parse_operator_expression(parent, 0));
             lexer->expect_and_consume(COMMA);
             node->add_child(make_terminal(node, lexer->next()));
             lexer->expect_and_consume(CLOSE_PAREN);
@@ -1718,9 +1974,9 @@ PNode Parser::parse_primary_expression(PNode parent) {
         {
             // E -> anyoccurances (E in E)
             lexer->expect_and_consume(OPEN_PAREN);
-            node->add_child(precedence_climber(node, 5));
+            node->add_child(parse_operator_expression(node, 5));
             lexer->expect_and_consume(WITHIN);
-            node->add_child(precedence_climber(node, 5));
+            node->add_child(parse_operator_expression(node, 5));
             lexer->expect_and_consume(CLOSE_PAREN);
             return node;
         }   
@@ -1728,7 +1984,7 @@ PNode Parser::parse_primary_expression(PNode parent) {
         case ANYOF: case ALLOF: case SQRT: case ABS: case COS:  case SIN: case TAN: case SINH: case COSH: case TANH: case EXP: case LOG: case AVE: case SUM: 
         {
             lexer->expect_and_consume(OPEN_PAREN);
-            node->add_child(precedence_climber(parent, 0));
+            node->add_child(parse_operator_expression(parent, 0));
             lexer->expect_and_consume(CLOSE_PAREN);
             return node;
         }
@@ -1746,7 +2002,7 @@ PNode Parser::parse_primary_expression(PNode parent) {
 
             lexer->expect_and_consume(OPEN_PAREN);
 
-            PNode particle_list(std::make_shared<Node>(PARTICLE_LIST, node));
+            PNode particle_list(make_node(PARTICLE_LIST, node));
             parse_particle_list(particle_list);
             node->add_child(particle_list);
 
@@ -1764,7 +2020,7 @@ PNode Parser::parse_primary_expression(PNode parent) {
         {
             // here, we are met with a token that isn't any other known form. If it is immediately followed by parentheses, then this is probably some external function. 
             if (lexer->peek(0)->get_token_type() == OPEN_PAREN) {
-                PNode func(std::make_shared<Node>(USER_FUNCTION, parent));
+                PNode func(make_node(USER_FUNCTION, parent));
                 node->set_parent(func);
 
                 lexer->expect_and_consume(OPEN_PAREN);
@@ -1799,45 +2055,28 @@ All productions are done via precedence climbing. Stated grammar does not correc
  */
 PNode Parser::parse_expression(PNode parent) {
     
-    PNode expression(std::make_shared<Node>(EXPRESSION, parent));
-    expression->add_child(precedence_climber(expression, 0));
+    PNode expression(make_node(EXPRESSION, parent));
+    expression->add_child(parse_operator_expression(expression, 0));
 
     return expression;
 }
 
-void Parser::print_children_and_yourself(PNode node, int *top_number) {
-
-    int reserved_number_for_me = (*top_number)++;
-
-    if (node->has_token()) {
-        std::string lexeme(node->get_token()->get_lexeme());
-        std::regex quotes = std::regex("\"+");
-        lexeme = std::regex_replace(lexeme, quotes, "");
-
-        std::cout << "    " << reserved_number_for_me << " [label=\"" << lexeme << "\"]" << std::endl;
-    } else {
-        std::cout << "    " << reserved_number_for_me << " [label=\"ID:" << node->get_ast_type_as_string() << "\"]" <<std::endl;
-    }
-
-    auto children_vector = node->get_children();
-    for (auto it = children_vector.begin(); it != children_vector.end(); ++it) {
-        std::cout << "    " << reserved_number_for_me << " -> " << *top_number << std::endl;
-        print_children_and_yourself(*it, top_number);
-    }
-}
-
 void Parser::print_parse_dot() {
-    PNode input_node = tree.get_root();
-
-    std::cout << "digraph G {" << std::endl;
-
-    int top = 1;
-
-    print_children_and_yourself(input_node, &top);
+    print_parse_dot(std::cout);
+}
 
-    std::cout << "}" << std::endl;
+void Parser::print_parse_dot(std::ostream &out) {
+    ASTWriter(out).write_dot(tree.get_root());
 }
 
 PNode Parser::get_root() {
     return tree.get_root();
 }
+
+Tree &Parser::get_tree() {
+    return tree;
+}
+
+FlatAST Parser::get_flat_ast() {
+    return tree.flatten();
+}
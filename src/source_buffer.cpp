@@ -0,0 +1,60 @@
+#include "source_buffer.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::SourceBuffer(std::string filename): data(nullptr), size(0), is_mapped(false) {
+
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    // An unreadable file gives an empty source, in the same way as an ifstream that failed to open
+    if (fd < 0) return;
+
+    struct stat file_status;
+    if (fstat(fd, &file_status) == 0 && S_ISREG(file_status.st_mode) && file_status.st_size > 0) {
+        void *mapping = mmap(nullptr, file_status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping != MAP_FAILED) {
+            // The whole file is read front to back exactly once by the lexer
+            madvise(mapping, file_status.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(mapping);
+            size = file_status.st_size;
+            is_mapped = true;
+        }
+    }
+    close(fd);
+
+    if (is_mapped) return;
+
+    // Not a regular file (or an empty one), so fall back to reading it in the ordinary way
+    std::ifstream read_file(filename, std::ios::binary);
+    read_stream(read_file);
+}
+
+SourceBuffer::SourceBuffer(std::istream &in): data(nullptr), size(0), is_mapped(false) {
+    read_stream(in);
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (is_mapped) munmap(const_cast<char *>(data), size);
+}
+
+void SourceBuffer::read_stream(std::istream &in) {
+    owned_contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = owned_contents.data();
+    size = owned_contents.size();
+}
+
+std::string_view SourceBuffer::get_contents() const {
+    return std::string_view(data, size);
+}
+
+bool SourceBuffer::is_memory_mapped() const {
+    return is_mapped;
+}
@@ -0,0 +1,72 @@
+#include "symbol_table.hpp"
+
+#include <cassert>
+#include <mutex>
+
+Symbol SymbolTable::intern(std::string_view text) {
+    if (shared_between_threads.load(std::memory_order_relaxed)) return intern_locked(text);
+
+    auto found = index.find(text);
+    if (found != index.end()) return found->second;
+
+    Symbol symbol = texts.size();
+    texts.emplace_back(text);
+    index.emplace(texts.back(), symbol);
+
+    return symbol;
+}
+
+Symbol SymbolTable::intern_locked(std::string_view text) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto found = index.find(text);
+        if (found != index.end()) return found->second;
+    }
+
+    // Another thread may have added the text since the lookup above
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto found = index.find(text);
+    if (found != index.end()) return found->second;
+
+    Symbol symbol = texts.size();
+    texts.emplace_back(text);
+    index.emplace(texts.back(), symbol);
+
+    return symbol;
+}
+
+Symbol SymbolTable::find(std::string_view text) const {
+    if (shared_between_threads.load(std::memory_order_relaxed)) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto found = index.find(text);
+        return found == index.end() ? NO_SYMBOL : found->second;
+    }
+
+    auto found = index.find(text);
+    return found == index.end() ? NO_SYMBOL : found->second;
+}
+
+const std::string &SymbolTable::get_text(Symbol symbol) const {
+    // The text itself never moves once added, so it can still be read once the lock is gone
+    if (shared_between_threads.load(std::memory_order_relaxed)) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        assert(symbol < texts.size());
+        return texts[symbol];
+    }
+
+    assert(symbol < texts.size());
+    return texts[symbol];
+}
+
+std::size_t SymbolTable::size() const {
+    return texts.size();
+}
+
+void SymbolTable::share_between_threads(bool shared) {
+    shared_between_threads.store(shared);
+}
+
+SymbolTable &get_symbol_table() {
+    static SymbolTable table;
+    return table;
+}
@@ -1,6 +1,7 @@
 #include "timber_converter.hpp"
 #include "ali_converter.hpp"
 #include "exceptions.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <ostream>
 #include <regex>
@@ -10,10 +11,10 @@
 #include <vector>
 
 
-std::string TimberConverter::add_all_relevant_tags_for_object(AnalysisCommand command) {
+std::string TimberConverter::add_all_relevant_tags_for_object(const AnalysisCommand &command) {
     std::stringstream command_text;
 
-    std::string add_target = get_mapping_if_exists(command.get_argument(1));
+    std::string add_target = get_mapping_if_exists(command.get_argument_symbol(1));
     std::string dest_vec = command.get_argument(0);
     std::string mask = command.get_argument(1);
     std::string src_vec = command.get_argument(2);
@@ -27,7 +28,7 @@ std::string TimberConverter::add_all_relevant_tags_for_object(AnalysisCommand co
 
 }
 
-std::string TimberConverter::add_all_relevant_tags_for_union_empty(AnalysisCommand command) {
+std::string TimberConverter::add_all_relevant_tags_for_union_empty(const AnalysisCommand &command) {
     std::stringstream command_text;
 
     std::string dest_vec = command.get_argument(0);
@@ -37,7 +38,7 @@ std::string TimberConverter::add_all_relevant_tags_for_union_empty(AnalysisComma
 }
 
 
-std::string TimberConverter::add_all_relevant_tags_for_union_merge(AnalysisCommand command, std::string adding_name) {
+std::string TimberConverter::add_all_relevant_tags_for_union_merge(const AnalysisCommand &command, std::string adding_name) {
     std::stringstream command_text;
 
     std::string dest_vec = command.get_argument(0);
@@ -53,7 +54,7 @@ std::string TimberConverter::add_all_relevant_tags_for_union_merge(AnalysisComma
     return command_text.str();  
 }
 
-std::string TimberConverter::add_structure_for_comb_empty(AnalysisCommand command) {
+std::string TimberConverter::add_structure_for_comb_empty(const AnalysisCommand &command) {
 
     std::string dest_vec = command.get_argument(0);
 
@@ -62,10 +63,10 @@ std::string TimberConverter::add_structure_for_comb_empty(AnalysisCommand comman
     return "";
 }
 
-std::string TimberConverter::add_structure_for_comb_merge(AnalysisCommand command, std::string adding_name) {
+std::string TimberConverter::add_structure_for_comb_merge(const AnalysisCommand &command, std::string adding_name) {
 
-    std::string dest_vec = command.get_argument(0);
-    std::string old_comb = command.get_argument(1);
+    Symbol dest_vec = command.get_argument_symbol(0);
+    Symbol old_comb = command.get_argument_symbol(1);
 
     comb_map[get_mapping_if_exists(old_comb)].push_back(generate_4vector_label(get_mapping_if_exists(adding_name), "_pt"));
     var_mappings[dest_vec] = get_mapping_if_exists(old_comb);
@@ -120,10 +121,18 @@ std::string TimberConverter::add_comb_argument(std::string new_name, std::string
 
 
 std::string TimberConverter::get_mapping_if_exists(std::string str) {
-    if (var_mappings.count(str) == 0) {
-        var_mappings[str] = str;
+    // Text that was never interned cannot have been mapped, and interning it would only grow the table
+    Symbol symbol = find_symbol(str);
+    if (symbol == NO_SYMBOL) return str;
+    return get_mapping_if_exists(symbol);
+}
+
+std::string TimberConverter::get_mapping_if_exists(Symbol symbol) {
+    auto found = var_mappings.find(symbol);
+    if (found == var_mappings.end()) {
+        found = var_mappings.emplace(symbol, symbol_text(symbol)).first;
     } 
-    return var_mappings[str];
+    return found->second;
 }
 
 
@@ -139,15 +148,20 @@ std::string TimberConverter::existing_definitions_string() {
     return defs.str();
 }
 
-std::string TimberConverter::index_particle(AnalysisCommand command, bool is_named, std::string part_text) {
+// Drop the '\x1d' that index_particle leaves after each particle it indexes
+static std::string without_index_marks(std::string text) {
+    text.erase(std::remove(text.begin(), text.end(), '\x1d'), text.end());
+    return text;
+}
+
+std::string TimberConverter::index_particle(const AnalysisCommand &command, bool is_named, std::string part_text) {
     std::stringstream idx_text;
     
     // std::regex e ("\x1d"); 
     // part_text = std::regex_replace(part_text, e, "");
 
     if (command.get_num_arguments() - is_named >= 4) {
-        std::regex e ("\x1d"); 
-        part_text = std::regex_replace(part_text, e, "");
+        part_text = without_index_marks(part_text);
         std::string former_index = command.get_argument(2+is_named);
         std::string latter_index = command.get_argument(3+is_named);
 
@@ -156,8 +170,7 @@ std::string TimberConverter::index_particle(AnalysisCommand command, bool is_nam
         idx_text << "index_get(" << part_text << '\x1d' << "," << former_index << "," << latter_index << ")";\
     } else if (command.get_num_arguments() - is_named >= 3) {
         // idx_text << "index_get(" << part_text << " ," << command.get_argument(2+is_named) << ")";
-        std::regex e ("\x1d"); 
-        part_text = std::regex_replace(part_text, e, "");
+        part_text = without_index_marks(part_text);
         idx_text << part_text << '\x1d' << "[" << command.get_argument(2+is_named) << "]";   
     } else {
         idx_text << part_text;
@@ -181,7 +194,7 @@ std::string TimberConverter::lorentzify(std::string name) {
     return command_text.str();
 }
 
-std::string TimberConverter::add_particle(AnalysisCommand command, std::string name, bool negative) {
+std::string TimberConverter::add_particle(const AnalysisCommand &command, std::string name, bool negative) {
     bool is_named = false;
     if (command.get_instruction() == ADD_PART_NAMED || command.get_instruction() == SUB_PART_NAMED) is_named = true;
 
@@ -191,7 +204,7 @@ std::string TimberConverter::add_particle(AnalysisCommand command, std::string n
 
     std::string indexed_if_needed = index_particle(command, is_named, name);
 
-    std::string source = get_mapping_if_exists(command.get_argument(1+is_named));
+    std::string source = get_mapping_if_exists(command.get_argument_symbol(1+is_named));
 
     if (is_lorentz_vector.count(source) != 0) {
         //TODO: finish the logic here
@@ -203,8 +216,7 @@ std::string TimberConverter::add_particle(AnalysisCommand command, std::string n
 
         command_text << "(";
 
-        std::regex e ("\x1d"); 
-        command_text << std::regex_replace (source,e,"");
+        command_text << without_index_marks(source);
         command_text << symbol;
         command_text << lorentzify(indexed_if_needed);
         command_text << ")";
@@ -226,7 +238,7 @@ std::string TimberConverter::add_particle(AnalysisCommand command, std::string n
         command_text << get_mapping_if_exists(indexed_if_needed);
     }
     
-    var_mappings[command.get_argument(0)] = command_text.str();
+    var_mappings[command.get_argument_symbol(0)] = command_text.str();
 
 
     // we add an index that simply enumerates the particle here. This is not useful per se, but if new collections are made from it, you can discriminate them through this
@@ -241,7 +253,7 @@ std::string TimberConverter::add_particle(AnalysisCommand command, std::string n
 
 }  
 
-std::string TimberConverter::sub_particle(AnalysisCommand command, std::string name) {
+std::string TimberConverter::sub_particle(const AnalysisCommand &command, std::string name) {
     return add_particle(command, name, true);
 }
 
@@ -276,9 +288,9 @@ std::string TimberConverter::generate_4vector_label(std::string input, std::stri
     return generate_4vector_label(input, "", suffix);
 }
 
-void TimberConverter::append_4vector_label(AnalysisCommand command, std::string prefix, std::string suffix, std::string prefix_if_lv, std::string suffix_if_lv) {
-    std::string output = command.get_argument(0);
-    std::string input = get_mapping_if_exists(command.get_argument(1));
+void TimberConverter::append_4vector_label(const AnalysisCommand &command, std::string prefix, std::string suffix, std::string prefix_if_lv, std::string suffix_if_lv) {
+    Symbol output = command.get_argument_symbol(0);
+    std::string input = get_mapping_if_exists(command.get_argument_symbol(1));
     if (is_lorentz_vector.count(input) != 0) {
         // in this case, this input is a lorentz vector object, and we want to get its traits via an object attribute
         if (suffix_if_lv == "" && prefix_if_lv == "") {
@@ -294,40 +306,47 @@ void TimberConverter::append_4vector_label(AnalysisCommand command, std::string
 }
 
 
-void TimberConverter::append_4vector_label(AnalysisCommand command, std::string suffix, std::string suffix_if_lv) {
+void TimberConverter::append_4vector_label(const AnalysisCommand &command, std::string suffix, std::string suffix_if_lv) {
     append_4vector_label(command, "", suffix, "", suffix_if_lv);
 }
 
-std::string TimberConverter::binary_command(AnalysisCommand command, std::string op) {
+std::string TimberConverter::binary_command(const AnalysisCommand &command, std::string op) {
     std::stringstream text;
-    text << "(" << get_mapping_if_exists(command.get_argument(1)) << ")" << op << "("<< get_mapping_if_exists(command.get_argument(2)) << ")";
-    var_mappings[command.get_argument(0)] = text.str();
+    text << "(" << get_mapping_if_exists(command.get_argument_symbol(1)) << ")" << op << "("<< get_mapping_if_exists(command.get_argument_symbol(2)) << ")";
+    var_mappings[command.get_argument_symbol(0)] = text.str();
     return "";
 }
 
-std::string TimberConverter::one_argument_function(AnalysisCommand command, std::string function_name) {
+std::string TimberConverter::one_argument_function(const AnalysisCommand &command, std::string function_name) {
     std::stringstream text;
-    text << function_name << "(" << var_mappings[command.get_argument(1)] << ")";
-    var_mappings[command.get_argument(0)] = text.str();
+    text << function_name << "(" << var_mappings[command.get_argument_symbol(1)] << ")";
+    var_mappings[command.get_argument_symbol(0)] = text.str();
     return "";
 }
 
-std::string TimberConverter::command_convert(AnalysisCommand command) {
+Symbol TimberConverter::python_name(Symbol symbol) {
+    if (symbol >= python_names.size()) python_names.resize(symbol + 1, NO_SYMBOL);
+    if (python_names[symbol] != NO_SYMBOL) return python_names[symbol];
 
-    AnalysisCommand new_command(command.get_instruction());
+    // Quoted strings are kept as they are; anything else has its '_', '-' and '>' replaced with 'w'
+    std::string name = symbol_text(symbol);
+    if (name.empty() || name[0] != '"') {
+        for (auto it = name.begin(); it != name.end(); ++it) {
+            if (*it == '_' || *it == '-' || *it == '>') *it = 'w';
+        }
+    }
+
+    Symbol renamed = intern_symbol(name);
+    python_names[symbol] = renamed;
+    return renamed;
+}
 
+std::string TimberConverter::command_convert(const AnalysisCommand &original) {
+
+    AnalysisCommand command = original;
     for (int i = 0; i < command.get_num_arguments(); i++) {
-        std::regex e("[_\\->]");
-        std::string new_arg = command.get_argument(i);
-        if (new_arg[0] != '"') {
-            new_arg = std::regex_replace(command.get_argument(i), e, "w");
-        }
-        if (i == 0) 
-            new_command.add_dest_argument(new_arg);
-        else
-            new_command.add_source_argument(new_arg);
+        command.set_argument_symbol(i, python_name(command.get_argument_symbol(i)));
     }
-    command = new_command;
 
 
     AnalysisLevelInstruction inst = command.get_instruction();
@@ -336,8 +355,8 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
     switch (inst) {
         case DO_CUTFLOW_ON_REGION:
             command_text << "\n_old_node = a.GetActiveNode()";
-            command_text << "\n_cutflow_node_" << command.get_argument(0) << " = a.Apply(" << get_mapping_if_exists(command.get_argument(0)) << "[0])";
-            command_text << "\n_cutflow_node_" << command.get_argument(0) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument(0)) << "[1])";
+            command_text << "\n_cutflow_node_" << command.get_argument(0) << " = a.Apply(" << get_mapping_if_exists(command.get_argument_symbol(0)) << "[0])";
+            command_text << "\n_cutflow_node_" << command.get_argument(0) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument_symbol(0)) << "[1])";
             
             command_text << "\nprint('\\n---\\n \\\\begin{tabular}{c c c c} \\\\multicolumn{4}{c}{Cutflow report for region ";
             {
@@ -351,7 +370,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             command_text << "\nfor _cutflow_k, _cutflow_v in CutflowDict(_cutflow_node_" << command.get_argument(0) << ").items():\n";
             command_text << "    _this_name = _cutflow_k\n";
             command_text << "    if _this_name != 'Initial':\n";
-            command_text << "        _this_name = " << get_mapping_if_exists(command.get_argument(0)) << "[0].items[_cutflow_k]\n";
+            command_text << "        _this_name = " << get_mapping_if_exists(command.get_argument_symbol(0)) << "[0].items[_cutflow_k]\n";
             command_text << "        _this_name = re.sub('[A-Za-z0-9]*UNION','',_this_name)\n";
             command_text << "    else:\n";
             command_text << "        _init = _cutflow_v\n        _prev = _init\n";
@@ -362,8 +381,8 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return command_text.str();
         case DO_EVENTLIST_ON_REGION:            
             command_text << "\n_old_node = a.GetActiveNode()";
-            command_text << "\n_eventlist_node_" << command.get_argument(0) << " = a.Apply(" << get_mapping_if_exists(command.get_argument(0)) << "[0])";
-            command_text << "\n_eventlist_node_" << command.get_argument(0) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument(0)) << "[1])";
+            command_text << "\n_eventlist_node_" << command.get_argument(0) << " = a.Apply(" << get_mapping_if_exists(command.get_argument_symbol(0)) << "[0])";
+            command_text << "\n_eventlist_node_" << command.get_argument(0) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument_symbol(0)) << "[1])";
             
             command_text << "\nprint('\\n---\\nBeginning event list for region ";
             {
@@ -382,71 +401,70 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             command_text << "\n_histogram" << command.get_argument(0) << ".append('" << command.get_argument(0) << "')";
             command_text << "\n_histogram" << command.get_argument(0) << ".append('" << command.get_argument(1) << "')";
             for (int i = 2; i < 5; i++) {
-                command_text << "\n_histogram" << command.get_argument(0) << ".append(" << var_mappings[command.get_argument(i)] << ")";
+                command_text << "\n_histogram" << command.get_argument(0) << ".append(" << var_mappings[command.get_argument_symbol(i)] << ")";
             }
-            command_text << "\n_histogram" << command.get_argument(0) << ".append('" << var_mappings[command.get_argument(5)] << "')";
+            command_text << "\n_histogram" << command.get_argument(0) << ".append('" << var_mappings[command.get_argument_symbol(5)] << "')";
             return command_text.str();
         case HIST_2D:
             command_text << "\n_histogram" << command.get_argument(0) << " = []";
             command_text << "\n_histogram" << command.get_argument(0) << ".append('" << command.get_argument(0) << "')";
             command_text << "\n_histogram" << command.get_argument(0) << ".append('" << command.get_argument(1) << "')";
             for (int i = 2; i < 5; i++) {
-                command_text << "\n_histogram" << command.get_argument(0) << ".append(" << var_mappings[command.get_argument(i)] << ")";
+                command_text << "\n_histogram" << command.get_argument(0) << ".append(" << var_mappings[command.get_argument_symbol(i)] << ")";
             }
-            command_text << "\n_histogram" << command.get_argument(0) << ".append('" << var_mappings[command.get_argument(5)] << "')";
+            command_text << "\n_histogram" << command.get_argument(0) << ".append('" << var_mappings[command.get_argument_symbol(5)] << "')";
             for (int i = 6; i < 9; i++) {
-                command_text << "\n_histogram" << command.get_argument(0) << ".append(" << var_mappings[command.get_argument(i)] << ")";
+                command_text << "\n_histogram" << command.get_argument(0) << ".append(" << var_mappings[command.get_argument_symbol(i)] << ")";
             }
-            command_text << "\n_histogram" << command.get_argument(0) << ".append('" << var_mappings[command.get_argument(9)] << "')";
+            command_text << "\n_histogram" << command.get_argument(0) << ".append('" << var_mappings[command.get_argument_symbol(9)] << "')";
 
             return command_text.str();      
         case USE_HIST:
             command_text << "\n_old_node = a.GetActiveNode()";
-            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.Apply(" << get_mapping_if_exists(command.get_argument(1)) << "[0])";
-            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument(1)) << "[1])";
+            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.Apply(" << get_mapping_if_exists(command.get_argument_symbol(1)) << "[0])";
+            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument_symbol(1)) << "[1])";
             command_text << "\nuse_histo(_histogram" << command.get_argument(0) << ", _histogram_node_" << command.get_argument(1) << ")";
             command_text << "\na.SetActiveNode(_old_node)";
             return command_text.str();
         case CREATE_HIST_LIST:
             command_text << "\n_histogram_list" << command.get_argument(0) << " = []";
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();
         case ADD_HIST_TO_LIST:
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(1));
-            command_text << "\n_histogram_list" << var_mappings[command.get_argument(1)] << ".append(_histogram" << command.get_argument(2) << ")";
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(1));
+            command_text << "\n_histogram_list" << var_mappings[command.get_argument_symbol(1)] << ".append(_histogram" << command.get_argument(2) << ")";
             return command_text.str();
         case USE_HIST_LIST:
             command_text << "\n_old_node = a.GetActiveNode()";
-            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.Apply(" << get_mapping_if_exists(command.get_argument(1)) << "[0])";
-            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument(1)) << "[1])";
-            command_text << "\nuse_histo_list(_histogram_list" << var_mappings[command.get_argument(0)] << ", _histogram_node_" << command.get_argument(1) << ")";
+            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.Apply(" << get_mapping_if_exists(command.get_argument_symbol(1)) << "[0])";
+            command_text << "\n_histogram_node_" << command.get_argument(1) << " = a.AddCorrections(" << get_mapping_if_exists(command.get_argument_symbol(1)) << "[1])";
+            command_text << "\nuse_histo_list(_histogram_list" << var_mappings[command.get_argument_symbol(0)] << ", _histogram_node_" << command.get_argument(1) << ")";
             command_text << "\na.SetActiveNode(_old_node)";
             return command_text.str();
 
         case CREATE_REGION:
             command_text << command.get_argument(0) << " = [CutGroup('" << command.get_argument(0) << "'), []]\n";
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();
         case MERGE_REGIONS:
-            command_text << var_mappings[command.get_argument(2)] << "[0] = " << var_mappings[command.get_argument(2)] << "[0] + " << var_mappings[command.get_argument(1)] << "[0]\n";
-            command_text << var_mappings[command.get_argument(2)] << "[1] = " << var_mappings[command.get_argument(2)] << "[1] + " << var_mappings[command.get_argument(1)] << "[1]\n";
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(2));
+            command_text << var_mappings[command.get_argument_symbol(2)] << "[0] = " << var_mappings[command.get_argument_symbol(2)] << "[0] + " << var_mappings[command.get_argument_symbol(1)] << "[0]\n";
+            command_text << var_mappings[command.get_argument_symbol(2)] << "[1] = " << var_mappings[command.get_argument_symbol(2)] << "[1] + " << var_mappings[command.get_argument_symbol(1)] << "[1]\n";
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(2));
             return command_text.str();
         case CUT_REGION:
-            command_text << var_mappings[command.get_argument(1)] << "[0].Add('" << command.get_argument(0) << "', '" << var_mappings[command.get_argument(2)] << "')"; 
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(1));
+            command_text << var_mappings[command.get_argument_symbol(1)] << "[0].Add('" << command.get_argument(0) << "', '" << var_mappings[command.get_argument_symbol(2)] << "')"; 
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(1));
             return command_text.str();
         case ADD_ALIAS:
         {
-            std::string source = get_mapping_if_exists(command.get_argument(1));
+            std::string source = get_mapping_if_exists(command.get_argument_symbol(1));
             std::string dest = command.get_argument(0);
-            var_mappings[dest] = get_mapping_if_exists(source);
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(source);
 
             // if we are aliasing a 4vector object, we should define it so that we do not do too much redundant work
             if (is_lorentz_vector.count(source) != 0) {
     
-                std::regex e ("\x1d"); 
-                source = std::regex_replace(source, e, "");
+                source = without_index_marks(source);
 
                 char non_underscore_delimiter = 'w';
 
@@ -457,7 +475,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
                 command_text << "\na.Define('" << dest << "_phi', 'Phi(" << non_underscore_delimiter << "VEC" << non_underscore_delimiter << dest << ")')";
                 command_text << "\na.Define('" << dest << "_mass', 'M(" << non_underscore_delimiter << "VEC" << non_underscore_delimiter << dest << ")')";
 
-                var_mappings[command.get_argument(0)] = command.get_argument(0);
+                var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
                 return command_text.str();
             }
             return "";
@@ -466,7 +484,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
         {
             std::string fn_name_with_quotes = command.get_argument(1);
             std::string fn_name_wo_quotes = fn_name_with_quotes.substr(1,fn_name_with_quotes.size()-2);
-            var_mappings[command.get_argument(0)] = fn_name_wo_quotes;
+            var_mappings[command.get_argument_symbol(0)] = fn_name_wo_quotes;
             return "";
         }
         case ADD_CORRECTIONLIB:
@@ -477,15 +495,15 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             
             std::stringstream correctionlib_func_name;
             correctionlib_func_name << command.get_argument(0) << "->evaluate";
-            var_mappings[command.get_argument(0)] = correctionlib_func_name.str();
+            var_mappings[command.get_argument_symbol(0)] = correctionlib_func_name.str();
 
             command_text << "ROOT.gInterpreter.Declare('auto " << command.get_argument(0) << " = correction::CorrectionSet::from_file(" << filename_with_quotes << ")->at(" << keyname_with_quotes << ")')\n";
             return command_text.str();
         }
         case SORT_ASCEND:
             command_text << "\na.SubCollection('" << command.get_argument(0) << "', '";
-            command_text << generate_4vector_label(get_mapping_if_exists(command.get_argument(1)), "");
-            command_text << "', 'ROOT::VecOps::Argsort(" << get_mapping_if_exists(command.get_argument(2));
+            command_text << generate_4vector_label(get_mapping_if_exists(command.get_argument_symbol(1)), "");
+            command_text << "', 'ROOT::VecOps::Argsort(" << get_mapping_if_exists(command.get_argument_symbol(2));
             command_text << ")', useTake=True)\n";
 
             return command_text.str();
@@ -493,8 +511,8 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
         case SORT_DESCEND:
 
             command_text << "\na.SubCollection('" << command.get_argument(0) << "', '";
-            command_text << generate_4vector_label(get_mapping_if_exists(command.get_argument(1)), "");
-            command_text << "', 'ROOT::VecOps::Reverse(ROOT::VecOps::Argsort(" << get_mapping_if_exists(command.get_argument(2));
+            command_text << generate_4vector_label(get_mapping_if_exists(command.get_argument_symbol(1)), "");
+            command_text << "', 'ROOT::VecOps::Reverse(ROOT::VecOps::Argsort(" << get_mapping_if_exists(command.get_argument_symbol(2));
             command_text << "))', useTake=True)\n";
 
             return command_text.str();
@@ -504,28 +522,28 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             command_text << "\n" << command.get_argument(0) << " = VarGroup('" << command.get_argument(0) << "')\n"; 
 
             append_4vector_label(command, "", "_pt", "Pt(", ")");
-            command_text << command.get_argument(0) << ".Add('" << command.get_argument(0) << "', 'create_mask(" << get_mapping_if_exists(command.get_argument(0)) << ")')";            
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            command_text << command.get_argument(0) << ".Add('" << command.get_argument(0) << "', 'create_mask(" << get_mapping_if_exists(command.get_argument_symbol(0)) << ")')";            
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
 
             existing_definitions.push_back(command.get_argument(0));
             return command_text.str();
         }
         case LIMIT_MASK:
         {   
-            command_text << var_mappings[command.get_argument(1)] << ".Add('" << command.get_argument(0) << "', 'limit_mask(" << command.get_argument(1) << ", " << var_mappings[command.get_argument(2)] << ")')";
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(1));
+            command_text << var_mappings[command.get_argument_symbol(1)] << ".Add('" << command.get_argument(0) << "', 'limit_mask(" << command.get_argument(1) << ", " << var_mappings[command.get_argument_symbol(2)] << ")')";
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(1));
             return command_text.str();
         }
         case APPLY_MASK:
         {
             command_text << add_all_relevant_tags_for_object(command);
 
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             return command_text.str();
         }
         case CREATE_TABLE:
         {
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             command_text << command.get_argument(0) << "_nvars = " << command.get_argument(0) << "\n";
             command_text << command.get_argument(0) << "_lower_bounds = []\n";
             command_text << command.get_argument(0) << "_upper_bounds = []\n";
@@ -535,7 +553,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
         case CREATE_TABLE_LOWER_BOUNDS:
         case CREATE_TABLE_UPPER_BOUNDS:
             if (command.get_num_arguments() < 3) {
-                var_mappings[command.get_argument(0)] = command.get_argument(1); 
+                var_mappings[command.get_argument_symbol(0)] = command.get_argument(1); 
                 return "";
             }
             command_text << "[" << command.get_argument(1);
@@ -543,27 +561,27 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
                 command_text << "," << command.get_argument(i); 
             }
             command_text << "]";
-            var_mappings[command.get_argument(0)] = command_text.str(); return "";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str(); return "";
         case CREATE_TABLE_VALUE:
 
             if (command.get_num_arguments() < 3) {
-                var_mappings[command.get_argument(0)] = command.get_argument(1);
+                var_mappings[command.get_argument_symbol(0)] = command.get_argument(1);
             } else {
                 command_text << "[" << command.get_argument(1) << "," << command.get_argument(2) << "," << command.get_argument(3) << "]";
-                var_mappings[command.get_argument(0)] = command_text.str();
+                var_mappings[command.get_argument_symbol(0)] = command_text.str();
             }
             return "";
         case APPEND_TO_TABLE:
         {
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(1));
-            command_text << var_mappings[command.get_argument(1)] << "_values.append(" << var_mappings[command.get_argument(2)] << "\n";
-            command_text << var_mappings[command.get_argument(1)] << "_lower_bounds.append(" << var_mappings[command.get_argument(3)] << "\n";
-            command_text << var_mappings[command.get_argument(1)] << "_upper_bounds.append(" << var_mappings[command.get_argument(4)] << "\n";
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(1));
+            command_text << var_mappings[command.get_argument_symbol(1)] << "_values.append(" << var_mappings[command.get_argument_symbol(2)] << "\n";
+            command_text << var_mappings[command.get_argument_symbol(1)] << "_lower_bounds.append(" << var_mappings[command.get_argument_symbol(3)] << "\n";
+            command_text << var_mappings[command.get_argument_symbol(1)] << "_upper_bounds.append(" << var_mappings[command.get_argument_symbol(4)] << "\n";
             return command_text.str();
         }
         case FINISH_TABLE:
         {
-            std::string old_name = get_mapping_if_exists(command.get_argument(1));
+            std::string old_name = get_mapping_if_exists(command.get_argument_symbol(1));
             command_text << old_name << "_values_array = ROOT.ROOT::VecOps.AsRVec(np.array(" << old_name << "_values, dtype=np.float32))\n";
             command_text << old_name << "_lower_bounds_array = ROOT.ROOT::VecOps.AsRVec(np.array(" << old_name << "_lower_bounds, dtype=np.float32))\n";
             command_text << old_name << "_upper_bounds_array = ROOT.ROOT::VecOps.AsRVec(np.array(" << old_name << "_upper_bounds, dtype=np.float32))\n"; 
@@ -572,14 +590,14 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             command_text << " = create_table_function(' + str(" << old_name << "_nvars) + '," << old_name << "_lower_bound_array," << old_name << "_upper_bound_array," << old_name << "_values_array);')";
         }
         case WEIGHT_APPLY:
-            command_text << var_mappings[command.get_argument(1)] << "[1].append(Correction('" << command.get_argument(2) << "', '', '" << var_mappings[command.get_argument(2)] << "')"; 
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(1));
+            command_text << var_mappings[command.get_argument_symbol(1)] << "[1].append(Correction('" << command.get_argument(2) << "', '', '" << var_mappings[command.get_argument_symbol(2)] << "')"; 
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(1));
             return command_text.str();
         case BEGIN_EXPRESSION:
             return "";
         case END_EXPRESSION:
         {
-            var_mappings[command.get_argument(0)] = get_mapping_if_exists(command.get_argument(1));
+            var_mappings[command.get_argument_symbol(0)] = get_mapping_if_exists(command.get_argument_symbol(1));
             return "";
         }
             return "END_EXPRESSION";
@@ -588,8 +606,8 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
         case END_IF:
             return "END_IF";
         case EXPR_RAISE:
-            command_text << "raise_power(" << var_mappings[command.get_argument(1)] << "," << var_mappings[command.get_argument(2)] <<  ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "raise_power(" << var_mappings[command.get_argument_symbol(1)] << "," << var_mappings[command.get_argument_symbol(2)] <<  ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case EXPR_MULTIPLY:
             return binary_command(command, "*");
@@ -621,12 +639,12 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return binary_command(command, "||");
 
         case EXPR_WITHIN:
-            command_text << "((" << var_mappings[command.get_argument(1)] << ">=" << var_mappings[command.get_argument(2)] << ")&&(" << var_mappings[command.get_argument(1)] << "<=" << var_mappings[command.get_argument(3)] << "))";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "((" << var_mappings[command.get_argument_symbol(1)] << ">=" << var_mappings[command.get_argument_symbol(2)] << ")&&(" << var_mappings[command.get_argument_symbol(1)] << "<=" << var_mappings[command.get_argument_symbol(3)] << "))";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case EXPR_OUTSIDE:
-            command_text << "((" << var_mappings[command.get_argument(1)] << "<=" << var_mappings[command.get_argument(2)] << ")||(" << var_mappings[command.get_argument(1)] << ">=" << var_mappings[command.get_argument(3)] << "))";
-            var_mappings[command.get_argument(0)] = command_text.str();           
+            command_text << "((" << var_mappings[command.get_argument_symbol(1)] << "<=" << var_mappings[command.get_argument_symbol(2)] << ")||(" << var_mappings[command.get_argument_symbol(1)] << ">=" << var_mappings[command.get_argument_symbol(3)] << "))";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();           
             return "";
 
         case EXPR_NEGATE:
@@ -637,7 +655,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
         case FUNC_BTAG:
         {
             append_4vector_label(command, "_btagDeepFlavB");
-            var_mappings[command.get_argument(0)] = command_text.str();
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         }
         case FUNC_PT:
@@ -673,7 +691,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
 
         case MAKE_EMPTY_PARTICLE:
         {
-            var_mappings[command.get_argument(0)] = "";
+            var_mappings[command.get_argument_symbol(0)] = "";
             return "";
         }
         case ADD_PART_ELECTRON:
@@ -697,7 +715,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
         case ADD_PART_FJET:
             return add_particle(command, "FatJet");
         case ADD_PART_NAMED:
-            return add_particle(command, get_mapping_if_exists(command.get_argument(1)));
+            return add_particle(command, get_mapping_if_exists(command.get_argument_symbol(1)));
         case SUB_PART_ELECTRON:
             return sub_particle(command, "Electron");
         case SUB_PART_MUON:
@@ -751,8 +769,8 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return one_argument_function(command, "ROOT::VecOps::Sum");
 
         case FUNC_ANYOCCURRENCES:
-            command_text << "AnyOccurrences(" << var_mappings[command.get_argument(1)] << "," << var_mappings[command.get_argument(2)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "AnyOccurrences(" << var_mappings[command.get_argument_symbol(1)] << "," << var_mappings[command.get_argument_symbol(2)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
             
         case FUNC_MIN:
@@ -761,12 +779,12 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return one_argument_function(command, "ROOT::VecOps::Max");
 
         case FUNC_MAX_LIST:
-            command_text << "std::max(" << var_mappings[command.get_argument(1)] << "," << var_mappings[command.get_argument(2)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "std::max(" << var_mappings[command.get_argument_symbol(1)] << "," << var_mappings[command.get_argument_symbol(2)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_MIN_LIST:
-            command_text << "std::min(" << var_mappings[command.get_argument(1)] << "," << var_mappings[command.get_argument(2)] << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "std::min(" << var_mappings[command.get_argument_symbol(1)] << "," << var_mappings[command.get_argument_symbol(2)] << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
 
         case FUNC_FIRST:
@@ -781,7 +799,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
 
         case FUNC_SORT_DESCEND:
             command_text << "ROOT::VecOps::Reverse(ROOT::VecOps::Sort(" << command.get_argument(1) << "))";
-            var_mappings[command.get_argument(0)] = command_text.str(); return "";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str(); return "";
 
         case FUNC_NAMED:
             raise_non_implemented_conversion_exception("FUNC_NAMED");
@@ -789,13 +807,13 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
 
         case MAKE_EMPTY_UNION:
             // command_text << "\n" << command.get_argument(0) << " = VarGroup('" << command.get_argument(0) << "')\n"; 
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             command_text << add_all_relevant_tags_for_union_empty(command);
 
             existing_definitions.push_back(command.get_argument(0));
             return command_text.str();        
         case ADD_NAMED_TO_UNION:
-            command_text << add_all_relevant_tags_for_union_merge(command, get_mapping_if_exists(command.get_argument(2)));
+            command_text << add_all_relevant_tags_for_union_merge(command, get_mapping_if_exists(command.get_argument_symbol(2)));
             return command_text.str();        
         case ADD_ELECTRON_TO_UNION:
             command_text << add_all_relevant_tags_for_union_merge(command, "Electron");
@@ -829,12 +847,12 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return command_text.str();
 
         case MAKE_EMPTY_COMB:
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             command_text << add_structure_for_comb_empty(command);
             existing_definitions.push_back(command.get_argument(0));
             return command_text.str();        
         case ADD_NAMED_TO_COMB:
-            command_text << add_structure_for_comb_merge(command, get_mapping_if_exists(command.get_argument(2)));
+            command_text << add_structure_for_comb_merge(command, get_mapping_if_exists(command.get_argument_symbol(2)));
             return command_text.str();        
         case ADD_ELECTRON_TO_COMB:
             command_text << add_structure_for_comb_merge(command, "Electron");
@@ -868,16 +886,16 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return command_text.str();
 
         case NAME_ELEMENT_OF_COMB:
-            command_text << add_comb_argument(get_mapping_if_exists(command.get_argument(0)), get_mapping_if_exists(command.get_argument(1)), get_mapping_if_exists(command.get_argument(2)));
+            command_text << add_comb_argument(get_mapping_if_exists(command.get_argument_symbol(0)), get_mapping_if_exists(command.get_argument_symbol(1)), get_mapping_if_exists(command.get_argument_symbol(2)));
             return command_text.str();
 
         case MAKE_EMPTY_DISJOINT:
-            var_mappings[command.get_argument(0)] = command.get_argument(0);
+            var_mappings[command.get_argument_symbol(0)] = command.get_argument(0);
             command_text << add_structure_for_comb_empty(command);
             existing_definitions.push_back(command.get_argument(0));
             return command_text.str();        
         case ADD_NAMED_TO_DISJOINT:
-            command_text << add_structure_for_comb_merge(command, get_mapping_if_exists(command.get_argument(2)));
+            command_text << add_structure_for_comb_merge(command, get_mapping_if_exists(command.get_argument_symbol(2)));
             return command_text.str();        
         case ADD_ELECTRON_TO_DISJOINT:
             command_text << add_structure_for_comb_merge(command, "Electron");
@@ -911,7 +929,7 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return command_text.str();
 
         case NAME_ELEMENT_OF_DISJOINT:
-            command_text << add_comb_argument(get_mapping_if_exists(command.get_argument(0)), get_mapping_if_exists(command.get_argument(1)), get_mapping_if_exists(command.get_argument(2)), true);
+            command_text << add_comb_argument(get_mapping_if_exists(command.get_argument_symbol(0)), get_mapping_if_exists(command.get_argument_symbol(1)), get_mapping_if_exists(command.get_argument_symbol(2)), true);
             return command_text.str();
 
         case FUNC_FLAVOR:
@@ -949,32 +967,32 @@ std::string TimberConverter::command_convert(AnalysisCommand command) {
             return "FUNC_MINI_ISO";
         case FUNC_DISTINCT:
             command_text << "(" << generate_4vector_label(command.get_argument(1), "_provenance") << "!=" << generate_4vector_label(command.get_argument(2), "_provenance") << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
         case FUNC_DR:
-            command_text << "LVDeltaR(" << lorentzify(get_mapping_if_exists(command.get_argument(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument(2))) << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "LVDeltaR(" << lorentzify(get_mapping_if_exists(command.get_argument_symbol(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument_symbol(2))) << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_DPHI:
-            command_text << "LVDeltaPhi(" << lorentzify(get_mapping_if_exists(command.get_argument(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument(2))) << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "LVDeltaPhi(" << lorentzify(get_mapping_if_exists(command.get_argument_symbol(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument_symbol(2))) << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_DETA:
-            command_text << "LVDeltaEta(" << lorentzify(get_mapping_if_exists(command.get_argument(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument(2))) << ")";
+            command_text << "LVDeltaEta(" << lorentzify(get_mapping_if_exists(command.get_argument_symbol(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument_symbol(2))) << ")";
             return "";
         case FUNC_DR_HADAMARD:
-            command_text << "LVDeltaRHadamard(" << lorentzify(get_mapping_if_exists(command.get_argument(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument(2))) << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "LVDeltaRHadamard(" << lorentzify(get_mapping_if_exists(command.get_argument_symbol(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument_symbol(2))) << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_DPHI_HADAMARD:
-            command_text << "LVDeltaPhiHadamard(" << lorentzify(get_mapping_if_exists(command.get_argument(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument(2))) << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "LVDeltaPhiHadamard(" << lorentzify(get_mapping_if_exists(command.get_argument_symbol(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument_symbol(2))) << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case FUNC_DETA_HADAMARD:
-            command_text << "LVDeltaEtaHadamard(" << lorentzify(get_mapping_if_exists(command.get_argument(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument(2))) << ")";
+            command_text << "LVDeltaEtaHadamard(" << lorentzify(get_mapping_if_exists(command.get_argument_symbol(1))) << ", " << lorentzify(get_mapping_if_exists(command.get_argument_symbol(2))) << ")";
             return "";
         case FUNC_SIZE: //TODO: check this does not conflict with a valid use case
-            command_text << "size(" << generate_4vector_label(get_mapping_if_exists(command.get_argument(1)), "_pt") << ")";
-            var_mappings[command.get_argument(0)] = command_text.str();
+            command_text << "size(" << generate_4vector_label(get_mapping_if_exists(command.get_argument_symbol(1)), "_pt") << ")";
+            var_mappings[command.get_argument_symbol(0)] = command_text.str();
             return "";
         case CREATE_BIN:
         case FUNC_GEN_PART_IDX: